@@ -18,30 +18,6 @@ typedef struct {
     vector_float4 color;
 } MetalVertex;
 
- void ios_clear_slider_cache(void) { sliderCacheCount = 0; }
- void ios_clear_textbox_cache(void) { textboxCacheCount = 0; }
-
-
-
- mu_Id ios_find_slider_at_point(int x, int y) {
-    for (int i = 0; i < sliderCacheCount; i++) {
-        mu_Rect r = sliderCache[i].rect;
-        if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) {
-            return sliderCache[i].id;
-        }
-    }
-    return 0;
-}
- mu_Id ios_find_textbox_at_point(int x, int y) {
-    for (int i = 0; i < textboxCacheCount; i++) {
-        mu_Rect r = textboxCache[i].rect;
-        if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) {
-            return textboxCache[i].id;
-        }
-    }
-    return 0;
-}
-
 
 // metal_rendererクラス (スネークケース命名規則に合わせる)
 @interface metal_renderer : NSObject <MTKViewDelegate>
@@ -1102,7 +1078,7 @@ static void micro_ui_log(const char *format, ...) {
     mu_Context *ctx = self.renderer.muiContext;
     
 
-        if (self.activeTextBoxBuffer && ctx->focus != ios_find_textbox_at_point(ctx->mouse_pos.x, ctx->mouse_pos.y)) {
+        if (self.activeTextBoxBuffer && ctx->focus != ios_find_textbox_at(ctx, ctx->mouse_pos.x, ctx->mouse_pos.y)) {
         // テキストボックス以外にフォーカスが移った場合
         [self.hiddenTextField resignFirstResponder];
         self.activeTextBoxBuffer = NULL;
@@ -1232,8 +1208,8 @@ static void micro_ui_log(const char *format, ...) {
                 write_log("通常領域タッチ開始");
                 // 通常領域タッチ処理
                 int tx = (int)location.x, ty = (int)location.y;
-                mu_Id sliderId = ios_find_slider_at_point(tx, ty);
-                mu_Id textboxId = ios_find_textbox_at_point(tx, ty);
+                mu_Id sliderId = ios_find_slider_at(ctx, tx, ty);
+                mu_Id textboxId = ios_find_textbox_at(ctx, tx, ty);
                 if (sliderId) {
                     mu_set_focus(ctx, sliderId);
                     ios_set_hover(ctx, sliderId);
@@ -1476,8 +1452,8 @@ static void micro_ui_log(const char *format, ...) {
     } else {
         write_log("通常領域タッチ開始");
         int tx = (int)location.x, ty = (int)location.y;
-        mu_Id sliderId = ios_find_slider_at_point(tx, ty);
-        mu_Id textboxId = ios_find_textbox_at_point(tx, ty);
+        mu_Id sliderId = ios_find_slider_at(ctx, tx, ty);
+        mu_Id textboxId = ios_find_textbox_at(ctx, tx, ty);
         if (sliderId) {
             mu_set_focus(ctx, sliderId);
             ios_set_hover(ctx, sliderId);
@@ -1547,14 +1523,8 @@ static void micro_ui_log(const char *format, ...) {
     #endif
 
     // テキストボックスIDを取得
-    mu_Id textboxId = ios_find_textbox_at_point((int)location.x, (int)location.y);
-    BOOL isTextboxFocus = NO;
-    for (int i = 0; i < textboxCacheCount; ++i) {
-        if (ctx->focus == textboxCache[i].id) {
-            isTextboxFocus = YES;
-            break;
-        }
-    }
+    mu_Id textboxId = ios_find_textbox_at(ctx, (int)location.x, (int)location.y);
+    BOOL isTextboxFocus = ios_is_textbox(ctx, ctx->focus) ? YES : NO;
     // wasDraggingの判定を修正
     BOOL wasDragging = (ctx->focus != 0 && ctx->mouse_down && !isTextboxFocus);
     BOOL wasHeaderTap = self.didTapHeader;
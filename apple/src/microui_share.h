@@ -18,6 +18,12 @@
     #define UINT8_SLIDER_FN uint8_slider
     #define TEXTBOX_FN mu_textbox
 #endif
+
+// --- タッチ位置のコントロール検索 ---
+// src/microui.h（MU_HITGRID_SIZEがある）では、mu_update_controlが全てのコントロールを記録し
+// mu_endでグリッドにまとめるので、そのグリッドをmu_hit_testで引く（件数の上限もない）。
+// 古いmicrouiのコピーでビルドする場合だけ、ラッパーで矩形を覚えて線形に探す。
+#ifndef MU_HITGRID_SIZE
 typedef struct {
     mu_Id id;
     mu_Rect rect;
@@ -30,6 +36,7 @@ typedef struct {
 } TextboxCache;
 static TextboxCache textboxCache[16];
 static int textboxCacheCount = 0;
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,8 +51,9 @@ int ios_uint8_slider(mu_Context* ctx, unsigned char* value, int min, int max);
 int ios_textbox(mu_Context* ctx, char* buf, int bufsz);
 void ios_clear_slider_cache(void);
 void ios_clear_textbox_cache(void);
-mu_Id ios_find_slider_at_point(int x, int y);
-mu_Id ios_find_textbox_at_point(int x, int y);
+mu_Id ios_find_slider_at(mu_Context* ctx, int x, int y);
+mu_Id ios_find_textbox_at(mu_Context* ctx, int x, int y);
+int ios_is_textbox(mu_Context* ctx, mu_Id id);
 void ios_fix_hover_state(mu_Context* ctx);
 mu_Id ios_get_header_id(mu_Context* ctx, const char* label);
  void ios_cache_slider(mu_Context* ctx, mu_Id id, mu_Rect rect);
@@ -159,11 +167,16 @@ void draw_demo_windows(mu_Context* ctx, unsigned char bg[3]) {
     return res;
 }
  void ios_cache_slider(mu_Context* ctx, mu_Id id, mu_Rect rect) {
+#ifdef MU_HITGRID_SIZE
+    // mu_update_controlがMU_HIT_SLIDERとして記録済み
+    (void)ctx; (void)id; (void)rect;
+#else
     if (sliderCacheCount < 32) {
         sliderCache[sliderCacheCount].id = id;
         sliderCache[sliderCacheCount].rect = rect;
         sliderCacheCount++;
     }
+#endif
 }
  int ios_header_ex(mu_Context* ctx, const char* label, int opt) {
     if (!ctx || !label) return 0;
@@ -172,14 +185,65 @@ void draw_demo_windows(mu_Context* ctx, unsigned char bg[3]) {
     return mu_header_ex(ctx, label, opt);
 }
 static void ios_cache_textbox(mu_Context* ctx, mu_Id id, mu_Rect rect) {
+#ifdef MU_HITGRID_SIZE
+    // mu_update_controlがMU_HIT_TEXTBOXとして記録済み
+    (void)ctx; (void)id; (void)rect;
+#else
     if (textboxCacheCount < 16) {
         textboxCache[textboxCacheCount].id = id;
         textboxCache[textboxCacheCount].rect = rect;
         textboxCacheCount++;
     }
+#endif
 }
 int ios_textbox(mu_Context* ctx, char* buf, int bufsz) {
     int res = mu_textbox(ctx, buf, bufsz);
     ios_cache_textbox(ctx, ctx->last_id, ctx->last_rect);
     return res;
-}
\ No newline at end of file
+}
+#ifdef MU_HITGRID_SIZE
+// 前フレームのグリッドから、タッチ位置で最前面にあるスライダー・テキストボックスを探す
+// （手前のウィンドウに隠れている場合は0）。キャッシュのクリアは不要（mu_endで作り直す）
+mu_Id ios_find_slider_at(mu_Context* ctx, int x, int y) {
+    return mu_hit_test(ctx, x, y, MU_HIT_SLIDER);
+}
+mu_Id ios_find_textbox_at(mu_Context* ctx, int x, int y) {
+    return mu_hit_test(ctx, x, y, MU_HIT_TEXTBOX);
+}
+int ios_is_textbox(mu_Context* ctx, mu_Id id) {
+    return mu_hit_kind(ctx, id) == MU_HIT_TEXTBOX;
+}
+void ios_clear_slider_cache(void) {}
+void ios_clear_textbox_cache(void) {}
+#else
+// 前フレームにラッパーで覚えた矩形を記録順に探す（ctxは使わない）
+mu_Id ios_find_slider_at(mu_Context* ctx, int x, int y) {
+    (void)ctx;
+    for (int i = 0; i < sliderCacheCount; i++) {
+        mu_Rect r = sliderCache[i].rect;
+        if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) {
+            return sliderCache[i].id;
+        }
+    }
+    return 0;
+}
+mu_Id ios_find_textbox_at(mu_Context* ctx, int x, int y) {
+    (void)ctx;
+    for (int i = 0; i < textboxCacheCount; i++) {
+        mu_Rect r = textboxCache[i].rect;
+        if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) {
+            return textboxCache[i].id;
+        }
+    }
+    return 0;
+}
+int ios_is_textbox(mu_Context* ctx, mu_Id id) {
+    (void)ctx;
+    for (int i = 0; i < textboxCacheCount; i++) {
+        if (textboxCache[i].id == id) return 1;
+    }
+    return 0;
+}
+void ios_clear_slider_cache(void) { sliderCacheCount = 0; }
+void ios_clear_textbox_cache(void) { textboxCacheCount = 0; }
+#endif
\ No newline at end of file
@@ -0,0 +1,301 @@
+﻿/**
+ * 保存したコマンドリストの再生ベンチマーク
+ * command_captureで保存したフレームをコマンドリストへ戻し、描画の前処理
+ * （mu_quad_buildによる四角形インスタンスへの変換）に繰り返し流して時間を計ります。
+ * 元のアプリも描画APIも要らないので、本番で保存したフレームをLinuxで計測できます。
+ * グリフは1文字7x16のスタブなので、結果は環境によらず再現できます。
+ *
+ * 使い方: command_replay [-n 繰り返し回数] [-f text|json] [-s チャンク] [-d] ファイル...
+ *   保存は microui_bench -c ファイル シーン名、または
+ *   アプリでmu_capture_open/mu_capture_frameを呼んで行います。
+ *   -s を付けると、フレームごとにmu_quad_split（1ジョブあたりチャンク個）・mu_quad_run・
+ *   mu_quad_mergeでも変換し、バッチを順に連結したインスタンス列とクリップが
+ *   mu_quad_buildの結果とバイト単位で一致するか確かめます（一致しなければ1を返す）。
+ *   あわせて、バッチ配列をフレームのクリップ数ちょうど、インスタンス配列を
+ *   mu_quad_buildの出力数ちょうどにして分割し、配列の外へ書き込まないことも確かめます。
+ *   -d を付けると、インスタンスをdraw_listに積んで、頂点数・インデックス（65536頂点を
+ *   超えたら32ビット）・描画範囲とクリップを確かめます。32ビットインデックスのない
+ *   デバイスを想定して、max_verticesを65536にした描画リストでも同じように確かめます
+ *   （16ビットのまま、65536頂点ごとに範囲が分かれる）。描画リストはファイルをまたいで
+ *   使い回すので、大きいフレームのファイルの後に小さいファイルを指定すると、
+ *   16ビットへ戻る場合も確かめられます。
+ *   mu_quad_expand（CPUでの頂点展開）の時間は常に計ります。
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "microui.h"
+#include "command_capture.h"
+#include "quad_instance.h"
+#include "draw_list.h"
+
+#define MAX_QUADS   (1 << 20)
+#define MAX_BATCHES 65536
+#define MAX_JOBS    256
+#define GUARD       64      /* 容量ぎりぎりの分割変換で、配列の後ろに置く番兵の要素数 */
+#define EXPAND_QUADS 16384  /* mu_quad_expandで1度に展開する数（頂点バッファの大きさ） */
+
+static double now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static int glyph(void *udata, unsigned codepoint, mu_Rect *src, mu_Vec2 *offset, int *xadvance) {
+  (void) udata;
+  *src = mu_rect((codepoint & 31) * 8, 16 + (codepoint >> 5 & 31) * 16, 7, 16);
+  *offset = mu_vec2(0, 0);
+  *xadvance = 7;
+  return 1;
+}
+
+/* 2つの変換結果を、バッチを順に連結したインスタンス列として比べる（各インスタンスのクリップも比べる） */
+static int same_output(const mu_QuadList *a, const mu_QuadList *b) {
+  int ia = 0, ib = 0, ka = 0, kb = 0;
+  for (;;) {
+    const mu_QuadBatch *ba, *bb;
+    while (ia < a->batch_count && ka == a->batches[ia].count) { ia++; ka = 0; }
+    while (ib < b->batch_count && kb == b->batches[ib].count) { ib++; kb = 0; }
+    if (ia == a->batch_count || ib == b->batch_count) {
+      return ia == a->batch_count && ib == b->batch_count;
+    }
+    ba = &a->batches[ia];
+    bb = &b->batches[ib];
+    if (memcmp(&ba->clip, &bb->clip, sizeof(mu_Rect)) != 0 ||
+        memcmp(&a->items[ba->offset + ka], &b->items[bb->offset + kb], sizeof(mu_QuadInstance)) != 0)
+    {
+      return 0;
+    }
+    ka++;
+    kb++;
+  }
+}
+
+/* mu_quad_split・mu_quad_run・mu_quad_mergeで変換する（ワーカーの代わりに順に実行） */
+static void split_build(mu_Context *ctx, const mu_QuadAtlas *atlas, mu_QuadList *list, int chunk) {
+  static mu_QuadJob jobs[MAX_JOBS];
+  int i, n = mu_quad_split(ctx, list, jobs, MAX_JOBS, chunk);
+  for (i = 0; i < n; i++) { mu_quad_run(atlas, list, &jobs[i]); }
+  mu_quad_merge(list, jobs, n);
+}
+
+/* 番兵がすべてpatのままか */
+static int guard_intact(const void *p, int size, unsigned char pat) {
+  const unsigned char *b = p;
+  int i;
+  for (i = 0; i < size; i++) {
+    if (b[i] != pat) { return 0; }
+  }
+  return 1;
+}
+
+/* 容量ぎりぎり（バッチは先頭の1つ＋CLIPの数、インスタンスはfullと同じ数）の配列で分割変換し、
+   配列の外に書き込まないこと・打ち切らなかった場合はfullと一致することを確かめる */
+static int tight_split(mu_Context *ctx, const mu_QuadAtlas *atlas, const mu_QuadList *full, int chunk) {
+  static mu_QuadInstance items[MAX_QUADS];
+  static mu_QuadBatch batches[MAX_BATCHES];
+  mu_Command *cmd = NULL;
+  mu_QuadList list;
+  int clips = 1;
+  while (mu_next_command(ctx, &cmd)) {
+    if (cmd->type == MU_COMMAND_CLIP) { clips++; }
+  }
+  if (full->count + GUARD > MAX_QUADS || clips + GUARD > MAX_BATCHES) { return 1; }
+  mu_quad_list_init(&list, items, full->count, batches, clips);
+  memset(items + full->count, 0xa5, GUARD * sizeof(mu_QuadInstance));
+  memset(batches + clips, 0xa5, GUARD * sizeof(mu_QuadBatch));
+  split_build(ctx, atlas, &list, chunk);
+  if (!guard_intact(items + full->count, GUARD * sizeof(mu_QuadInstance), 0xa5) ||
+      !guard_intact(batches + clips, GUARD * sizeof(mu_QuadBatch), 0xa5))
+  {
+    return 0;
+  }
+  return list.overflow || same_output(full, &list);
+}
+
+/* 頂点バッファに収まる分ずつ展開する（インスタンス描画がないバックエンドと同じ使い方） */
+static void expand_all(const mu_QuadList *list, const mu_QuadAtlas *atlas) {
+  static mu_QuadVertex vertices[EXPAND_QUADS * 4];
+  int i;
+  for (i = 0; i < list->count; i += EXPAND_QUADS) {
+    mu_quad_expand(list->items + i, mu_min(list->count - i, EXPAND_QUADS), atlas, vertices);
+  }
+}
+
+/* 描画リストのi番目のインデックス */
+static unsigned draw_index(const mu_DrawList *draw, int i) {
+  if (draw->index_size == 2) { return ((const unsigned short*) draw->indices)[i]; }
+  return ((const unsigned*) draw->indices)[i];
+}
+
+/* インスタンスを描画リストに積み、頂点数・インデックス・描画範囲を確かめる */
+static int check_draw_list(mu_DrawList *draw, const mu_QuadList *list) {
+  static const int corner[6] = { 0, 1, 2, 2, 1, 3 };
+  int i, k, q, r, total = 0, offset = 0;
+  mu_draw_list_begin(draw);
+  for (i = 0; i < list->batch_count; i++) {
+    const mu_QuadBatch *b = &list->batches[i];
+    mu_draw_list_set_clip(draw, b->clip);
+    for (k = 0; k < b->count; k++) {
+      const mu_QuadInstance *it = &list->items[b->offset + k];
+      float u = (float) (it->u & ~MU_QUAD_SOLID), v = it->v;
+      mu_draw_list_quad(draw, mu_rect(it->x, it->y, it->w, it->h), u, v, u + it->w, v + it->h, 0xffffffff);
+    }
+    total += b->count;
+  }
+  mu_draw_list_end(draw);
+
+  if (draw->failed || draw->vertex_count != total * 4 || draw->index_count != total * 6) { return 0; }
+  if (draw->max_vertices > 0 && draw->max_vertices <= 65536) {
+    if (draw->index_size != 2) { return 0; }
+  } else if (draw->vertex_count > 65536 && draw->index_size != 4) {
+    return 0;
+  }
+  /* 範囲は隙間なく並び、隣どうしはクリップか先頭頂点が違う */
+  for (r = 0; r < draw->range_count; r++) {
+    const mu_DrawRange *dr = &draw->ranges[r];
+    if (dr->index_offset != offset || dr->index_count <= 0) { return 0; }
+    if (r > 0 && memcmp(&dr->clip, &dr[-1].clip, sizeof(mu_Rect)) == 0 && dr->base_vertex == dr[-1].base_vertex) {
+      return 0;
+    }
+    offset += dr->index_count;
+  }
+  if (offset != draw->index_count) { return 0; }
+  /* インデックスに範囲の先頭頂点を足すと元の頂点になり、上限を超えない */
+  for (q = 0, r = 0; q < total; q++) {
+    while (q * 6 >= draw->ranges[r].index_offset + draw->ranges[r].index_count) { r++; }
+    for (k = 0; k < 6; k++) {
+      unsigned idx = draw_index(draw, q * 6 + k);
+      if (idx + draw->ranges[r].base_vertex != (unsigned) (q * 4 + corner[k])) { return 0; }
+      if (draw->max_vertices > 0 && idx >= (unsigned) draw->max_vertices) { return 0; }
+    }
+  }
+  /* 各四角形はバッチと同じクリップの範囲に入っている */
+  for (i = 0, q = 0, r = 0; i < list->batch_count; i++) {
+    const mu_QuadBatch *b = &list->batches[i];
+    for (k = 0; k < b->count; k++, q++) {
+      while (q * 6 >= draw->ranges[r].index_offset + draw->ranges[r].index_count) { r++; }
+      if (memcmp(&draw->ranges[r].clip, &b->clip, sizeof(mu_Rect)) != 0) { return 0; }
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  static mu_QuadInstance items[MAX_QUADS], split_items[MAX_QUADS];
+  static mu_QuadBatch batches[MAX_BATCHES], split_batches[MAX_BATCHES];
+  int i, f, loops = 20, n = 1, res = 0, chunk = 0, check_draw = 0;
+  const char *format = "text";
+  mu_QuadAtlas atlas;
+  mu_QuadList list, split;
+  mu_DrawList draw, draw16;
+  mu_Context *ctx;
+
+  while (n < argc && argv[n][0] == '-') {
+    if (strcmp(argv[n], "-n") == 0 && n + 1 < argc) {
+      loops = atoi(argv[n + 1]);
+    } else if (strcmp(argv[n], "-f") == 0 && n + 1 < argc) {
+      format = argv[n + 1];
+    } else if (strcmp(argv[n], "-s") == 0 && n + 1 < argc) {
+      chunk = atoi(argv[n + 1]);
+    } else if (strcmp(argv[n], "-d") == 0) {
+      check_draw = 1;
+      n++;
+      continue;
+    } else {
+      break;
+    }
+    n += 2;
+  }
+  if (n >= argc || argv[n][0] == '-') {
+    fprintf(stderr, "usage: %s [-n loops] [-f text|json] [-s chunk] [-d] file...\n", argv[0]);
+    return 1;
+  }
+  if (loops < 1) { loops = 1; }
+
+  memset(&atlas, 0, sizeof(atlas));
+  atlas.width = atlas.height = 512;
+  atlas.white = mu_rect(0, 0, 3, 3);
+  for (i = 0; i < MU_ICON_MAX; i++) { atlas.icons[i] = mu_rect(i * 16, 0, 16, 16); }
+  atlas.glyph = glyph;
+  mu_quad_list_init(&list, items, MAX_QUADS, batches, MAX_BATCHES);
+  mu_quad_list_init(&split, split_items, MAX_QUADS, split_batches, MAX_BATCHES);
+  mu_draw_list_init(&draw, 1024);
+  mu_draw_list_init(&draw16, 1024);
+  draw16.max_vertices = 65536;
+
+  /* コマンドリストだけを使うので、コールバックの設定は要らない */
+  ctx = malloc(sizeof(mu_Context));
+  if (!ctx) { return 1; }
+  mu_init(ctx);
+
+  for (; n < argc; n++) {
+    mu_CaptureReader r;
+    double inject = 0, build = 0, expand = 0, t;
+    long quads = 0;
+    int commands = 0, bad = 0, differ = 0, tight_bad = 0, draw_bad = 0, draw16_bad = 0, wide = 0;
+    int max_vertices = 0, split_frames = 0;
+    if (!mu_capture_load(&r, argv[n])) {
+      fprintf(stderr, "cannot read %s\n", argv[n]);
+      res = 1;
+      continue;
+    }
+    for (i = 0; i < loops; i++) {
+      for (f = 0; f < r.frame_count; f++) {
+        int count;
+        t = now_ns();
+        count = mu_capture_inject(&r, ctx, f);
+        inject += now_ns() - t;
+        if (count < 0) { bad++; continue; }
+        t = now_ns();
+        quads += mu_quad_build(ctx, &atlas, &list);
+        build += now_ns() - t;
+        t = now_ns();
+        expand_all(&list, &atlas);
+        expand += now_ns() - t;
+        commands += count;
+        if (chunk > 0 && i == 0) {
+          split_build(ctx, &atlas, &split, chunk);
+          if (!same_output(&list, &split)) { differ++; }
+          if (!tight_split(ctx, &atlas, &list, chunk)) { tight_bad++; }
+        }
+        if (check_draw && i == 0) {
+          if (!check_draw_list(&draw, &list)) { draw_bad++; }
+          if (draw.index_size == 4) { wide++; }
+          max_vertices = mu_max(max_vertices, draw.vertex_count);
+          if (!check_draw_list(&draw16, &list)) { draw16_bad++; }
+          if (draw16.range_count > draw.range_count) { split_frames++; }
+        }
+      }
+    }
+    f = loops * r.frame_count;
+    if (f == 0) { f = 1; }
+    if (strcmp(format, "json") == 0) {
+      printf("{\"file\":\"%s\",\"frames\":%d,\"commands_per_frame\":%d,\"quads_per_frame\":%ld,"
+        "\"inject_ns\":%.0f,\"build_ns\":%.0f,\"expand_ns\":%.0f,\"bad_frames\":%d,"
+        "\"split_mismatches\":%d,\"tight_split_mismatches\":%d,\"draw_list_mismatches\":%d,"
+        "\"draw_list16_mismatches\":%d}\n",
+        argv[n], r.frame_count, commands / f, quads / f, inject / f, build / f, expand / f, bad,
+        differ, tight_bad, draw_bad, draw16_bad);
+    } else {
+      printf("%s: %d frames, %d commands/frame, %ld quads/frame, inject %.0f ns/frame, quad build %.0f ns/frame, "
+        "expand %.0f ns/frame", argv[n], r.frame_count, commands / f, quads / f, inject / f, build / f, expand / f);
+      if (bad) { printf(", %d bad frames", bad / loops); }
+      if (chunk > 0) { printf(", split/run/merge %d mismatches (%d with exact-size arrays)", differ, tight_bad); }
+      if (check_draw) {
+        printf(", draw list %d mismatches (max %d vertices, 32-bit indices in %d frames), "
+          "16-bit only %d mismatches (ranges split in %d frames)",
+          draw_bad, max_vertices, wide, draw16_bad, split_frames);
+      }
+      printf("\n");
+    }
+    if (bad || differ || tight_bad || draw_bad || draw16_bad) { res = 1; }
+    mu_capture_free(&r);
+  }
+  mu_draw_list_free(&draw);
+  mu_draw_list_free(&draw16);
+  free(ctx);
+  return res;
+}
@@ -0,0 +1,158 @@
+﻿/**
+ * コマンド受け渡し（command_mailbox）の2スレッドのテスト
+ * UIスレッドはフレームを作ってmu_mailbox_publishで渡し、描画スレッドは
+ * mu_mailbox_acquireで受け取ります。描画スレッドは受け取ったフレームの番号が
+ * 増えていくこと（戻らない・同じフレームを2回新しく受け取らない）と、スナップショットを
+ * 走査した内容がUIスレッドで公開前に走査した内容と一致することを確かめます。
+ * UIスレッドは4フレームのうち3フレームで描画スレッドが受け取るまで待ち、残りの1フレームは
+ * 待たずに次を公開します（取得されなかったスナップショットを捨てる経路も通す）。
+ * MU_COMPACT_COMMANDSでも同じように動きます。
+ *
+ * 使い方: mailbox_test [フレーム数]
+ *   問題がなければ0、食い違いがあるか、受け取って確かめたフレームが半分に
+ *   満たなければ1を返します。
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "microui.h"
+#include "command_mailbox.h"
+
+static mu_CommandMailbox mailbox;
+static unsigned *hashes;     /* フレーム番号ごとの内容のハッシュ（UIスレッドが公開前に書く） */
+static int last_frame;       /* 最後に公開したフレーム番号（終わったら設定する） */
+static int checked_frame;    /* 描画スレッドが最後に確かめたフレーム番号 */
+static int checked_count;    /* 描画スレッドが受け取って確かめたフレーム数 */
+
+static int text_width(mu_Font font, const char *str, int len) {
+  (void) font;
+  if (len < 0) { len = strlen(str); }
+  return len * 7;
+}
+
+static int text_height(mu_Font font) {
+  (void) font;
+  return 16;
+}
+
+static unsigned hash_bytes(unsigned h, const void *data, int size) {
+  const unsigned char *p = data;
+  while (size--) { h = (h ^ *p++) * 16777619u; }
+  return h;
+}
+
+/* 走査したコマンドのハッシュ（符号化の違いが出ないよう、展開後の値だけを使う） */
+static unsigned hash_command(unsigned h, const mu_Command *cmd) {
+  h = hash_bytes(h, &cmd->type, sizeof(cmd->type));
+  switch (cmd->type) {
+    case MU_COMMAND_CLIP: h = hash_bytes(h, &cmd->clip.rect, sizeof(mu_Rect)); break;
+    case MU_COMMAND_RECT:
+      h = hash_bytes(h, &cmd->rect.rect, sizeof(mu_Rect));
+      h = hash_bytes(h, &cmd->rect.color, sizeof(mu_Color));
+      break;
+    case MU_COMMAND_ICON:
+      h = hash_bytes(h, &cmd->icon.rect, sizeof(mu_Rect));
+      h = hash_bytes(h, &cmd->icon.id, sizeof(int));
+      h = hash_bytes(h, &cmd->icon.color, sizeof(mu_Color));
+      break;
+    case MU_COMMAND_TEXT:
+      h = hash_bytes(h, &cmd->text.pos, sizeof(mu_Vec2));
+      h = hash_bytes(h, &cmd->text.color, sizeof(mu_Color));
+      h = hash_bytes(h, cmd->text.str, cmd->text.len);
+      break;
+  }
+  return h;
+}
+
+/* フレームごとに内容が変わるUI（文字列はmu_draw_textでプールにコピーされる） */
+static void build(mu_Context *ctx) {
+  char buf[64];
+  int i, n = ctx->frame % 40;
+  if (mu_begin_window(ctx, "Mailbox", mu_rect(10 + n, 10, 300, 400))) {
+    mu_layout_row(ctx, 2, (int[]) { 120, -1 }, 0);
+    for (i = 0; i < 10 + n; i++) {
+      sprintf(buf, "frame %d row %d", ctx->frame, i);
+      mu_label(ctx, buf);
+      mu_button(ctx, "Button");
+    }
+    mu_end_window(ctx);
+  }
+  if (mu_begin_window(ctx, "Other", mu_rect(200, 100 + n, 200, 200))) {
+    mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+    mu_text(ctx, "A second window so the command list has JUMPs between roots.");
+    mu_end_window(ctx);
+  }
+}
+
+static void* render_thread(void *arg) {
+  int *errors = arg, seen = 0, prev = 0;
+  for (;;) {
+    mu_CommandSnapshot *snap = mu_mailbox_acquire(&mailbox);
+    int done = __atomic_load_n(&last_frame, __ATOMIC_SEQ_CST);
+    if (snap->frame != prev && snap->size > 0) {
+      mu_Command *cmd = NULL;
+      unsigned h = 2166136261u;
+      if (snap->frame < prev) {
+        fprintf(stderr, "frame %d acquired after frame %d\n", snap->frame, prev);
+        (*errors)++;
+      }
+      while (mu_next_snapshot_command(snap, &cmd)) { h = hash_command(h, cmd); }
+      if (h != hashes[snap->frame]) {
+        fprintf(stderr, "frame %d: snapshot does not match the published commands\n", snap->frame);
+        (*errors)++;
+      }
+      prev = snap->frame;
+      seen++;
+      __atomic_store_n(&checked_frame, prev, __ATOMIC_SEQ_CST);
+    } else {
+      sched_yield();
+    }
+    if (done && prev == done) { break; }
+  }
+  checked_count = seen;
+  printf("render thread: %d frames acquired, last frame %d\n", seen, prev);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  int i, frames = argc >= 2 ? atoi(argv[1]) : 2000, errors = 0;
+  mu_Context *ctx = malloc(sizeof(mu_Context));
+  pthread_t thread;
+  if (!ctx || frames <= 0) { return 1; }
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+  hashes = calloc(frames + 2, sizeof(unsigned));
+  if (!hashes) { return 1; }
+  mu_mailbox_init(&mailbox, ctx);
+  if (pthread_create(&thread, NULL, render_thread, &errors) != 0) { return 1; }
+
+  for (i = 0; i < frames; i++) {
+    mu_Command *cmd = NULL;
+    unsigned h = 2166136261u;
+    mu_begin(ctx);
+    build(ctx);
+    mu_end(ctx);
+    while (mu_next_command(ctx, &cmd)) { h = hash_command(h, cmd); }
+    hashes[ctx->frame] = h;
+    mu_mailbox_publish(&mailbox, ctx);
+    /* 描画スレッドが受け取って確かめるまで待つ（4フレームに1回は待たない） */
+    if (i % 4 != 3) {
+      while (__atomic_load_n(&checked_frame, __ATOMIC_SEQ_CST) < ctx->frame) { sched_yield(); }
+    }
+  }
+  __atomic_store_n(&last_frame, ctx->frame, __ATOMIC_SEQ_CST);
+
+  pthread_join(thread, NULL);
+  printf("ui thread: %d frames published, %d errors\n", frames, errors);
+  if (checked_count * 2 < frames) {
+    fprintf(stderr, "only %d of %d frames were acquired and checked\n", checked_count, frames);
+    errors++;
+  }
+  free(hashes);
+  free(ctx);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,470 @@
+﻿/**
+ * microuiコアのヘッドレスベンチマーク
+ * 描画バックエンドなしで、合成したシーンをmu_beginからmu_endまで繰り返し作成し、
+ * 1フレームあたりの時間、コマンドのバイト数と種類ごとの数、プールの使用数を出力します。
+ * text_width/text_heightは文字数から決まるスタブなので、結果は環境によらず再現できます。
+ *
+ * 使い方: microui_bench [-n フレーム数] [-f text|json|csv] [-r 記録 | -p 記録 | -c 保存先] [シーン名...]
+ *   -f json は1シーン1行のJSON（JSON Lines）、-f csv はヘッダー付きのCSVを出力します。
+ *   シーン名を指定するとそのシーンだけを実行します。
+ *   -r は最初のシーンを決まった手順の入力（移動・クリック・スクロール・文字）で操作し、
+ *   入力とフレームごとのハッシュを記録します。-p はその記録を再生し、ハッシュの
+ *   不一致と処理時間を出力します。記録は別のビルドで再生して比較できます。
+ *   -c は-rと同じ操作で作ったフレームのコマンドリストを保存します（command_replayで計測）。
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "microui.h"
+#include "input_record.h"
+#include "command_capture.h"
+
+#define WARMUP_FRAMES 10
+
+typedef struct {
+  const char *name;
+  void (*build)(mu_Context *ctx);
+} Scene;
+
+typedef struct {
+  const char *scene;
+  int frames;
+  double ns_mean, ns_min;
+  int command_bytes;
+  int text_bytes;
+  int commands[MU_COMMAND_MAX];
+  int containers, treenodes;
+  int layout_resolves, layout_reuses;
+} Result;
+
+
+/*============================================================================
+** stubs
+**============================================================================*/
+
+static int text_width(mu_Font font, const char *str, int len) {
+  (void) font;
+  if (len < 0) { len = strlen(str); }
+  return len * 7;
+}
+
+static int text_height(mu_Font font) {
+  (void) font;
+  return 16;
+}
+
+static double now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+
+/*============================================================================
+** scenes
+**============================================================================*/
+
+#define BUTTONS      10000
+#define WINDOWS      1000
+#define TREE_CHAINS  40
+#define TREE_DEPTH   28
+#define PARAGRAPHS   20
+#define CLIP_ROWS    5000
+#define FORM_ROWS    200
+
+static const int ten_columns[10] = { 120, 120, 120, 120, 120, 120, 120, 120, 120, -1 };
+static char window_names[WINDOWS][16];
+static char paragraph[4096];
+static float clip_values[CLIP_ROWS];
+static char form_fields[2][FORM_ROWS][32];
+
+/* 10k個のボタン（全て見える大きさのウィンドウ） */
+static void scene_buttons(mu_Context *ctx) {
+  int i;
+  if (mu_begin_window_ex(ctx, "buttons", mu_rect(0, 0, 1280, 30000), MU_OPT_NOSCROLL)) {
+    mu_layout_row(ctx, 10, ten_columns, 0);
+    for (i = 0; i < BUTTONS; i++) {
+      mu_push_id_int(ctx, i);
+      mu_button(ctx, "Button");
+      mu_pop_id(ctx);
+    }
+    mu_end_window(ctx);
+  }
+}
+
+/* 1k個の重なったウィンドウ */
+static void scene_windows(mu_Context *ctx) {
+  int i;
+  for (i = 0; i < WINDOWS; i++) {
+    mu_Rect r = mu_rect((i % 40) * 48, (i / 40) * 40, 160, 120);
+    if (mu_begin_window(ctx, window_names[i], r)) {
+      mu_label(ctx, "Label");
+      mu_button(ctx, "OK");
+      mu_end_window(ctx);
+    }
+  }
+}
+
+/* 深いツリーノード（全て展開） */
+static void tree_chain(mu_Context *ctx, int depth) {
+  if (depth == TREE_DEPTH) { return; }
+  if (mu_begin_treenode_ex(ctx, "Node", MU_OPT_EXPANDED)) {
+    mu_label(ctx, "Leaf A");
+    mu_label(ctx, "Leaf B");
+    tree_chain(ctx, depth + 1);
+    mu_end_treenode(ctx);
+  }
+}
+
+static void scene_tree(mu_Context *ctx) {
+  int i;
+  if (mu_begin_window_ex(ctx, "tree", mu_rect(0, 0, 1280, 100000), MU_OPT_NOSCROLL)) {
+    for (i = 0; i < TREE_CHAINS; i++) {
+      mu_push_id_int(ctx, i);
+      tree_chain(ctx, 0);
+      mu_pop_id(ctx);
+    }
+    mu_end_window(ctx);
+  }
+}
+
+/* 折り返しのある長い段落 */
+static void scene_text(mu_Context *ctx) {
+  int i;
+  if (mu_begin_window_ex(ctx, "text", mu_rect(0, 0, 800, 100000), MU_OPT_NOSCROLL)) {
+    mu_layout_row(ctx, 1, ten_columns + 9, 0);
+    for (i = 0; i < PARAGRAPHS; i++) { mu_text(ctx, paragraph); }
+    mu_end_window(ctx);
+  }
+}
+
+/* スクロールしたパネルの入れ子（ほとんどのコントロールがクリップされる） */
+static void scene_clip(mu_Context *ctx) {
+  static const int widths[3] = { 80, 120, -1 };
+  int i, full = -1;
+  if (mu_begin_window(ctx, "clip", mu_rect(0, 0, 400, 300))) {
+    mu_layout_row(ctx, 1, &full, -1);
+    mu_begin_panel(ctx, "outer");
+    mu_layout_row(ctx, 1, &full, 240);
+    mu_begin_panel(ctx, "inner");
+    mu_get_current_container(ctx)->scroll.y = CLIP_ROWS * 14;
+    for (i = 0; i < CLIP_ROWS; i++) {
+      mu_push_id_int(ctx, i);
+      mu_layout_row(ctx, 3, widths, 0);
+      mu_label(ctx, "Row");
+      mu_button(ctx, "Go");
+      mu_slider(ctx, &clip_values[i], 0, 1);
+      mu_pop_id(ctx);
+    }
+    mu_end_panel(ctx);
+    mu_end_panel(ctx);
+    mu_end_window(ctx);
+  }
+}
+
+/* 2列x200行のラベル・入力欄・ボタン（mu_layout_rowとbegin_columnの入れ子） */
+static void scene_form_nested(mu_Context *ctx) {
+  static const int columns[2] = { 620, -1 };
+  static const int fields[3] = { 80, -90, -1 };
+  int c, i;
+  if (mu_begin_window_ex(ctx, "form", mu_rect(0, 0, 1280, 8000), MU_OPT_NOSCROLL)) {
+    mu_layout_row(ctx, 2, columns, FORM_ROWS * 28);
+    for (c = 0; c < 2; c++) {
+      mu_layout_begin_column(ctx);
+      for (i = 0; i < FORM_ROWS; i++) {
+        mu_push_id_int(ctx, c * FORM_ROWS + i);
+        mu_layout_row(ctx, 3, fields, 0);
+        mu_label(ctx, "Name");
+        mu_textbox(ctx, form_fields[c][i], sizeof(form_fields[c][i]));
+        mu_button(ctx, "Apply");
+        mu_pop_id(ctx);
+      }
+      mu_layout_end_column(ctx);
+    }
+    mu_end_window(ctx);
+  }
+}
+
+/* scene_form_nestedと同じ画面を、各行のフレックスレイアウトで組む */
+static void scene_form_flex(mu_Context *ctx) {
+  static const int columns[2] = { 620, -1 };
+  static mu_FlexItem items[3];
+  int c, i, full = -1;
+  items[0].basis = 80;
+  items[1].grow = 1;
+  items[2].basis = 85;
+  if (mu_begin_window_ex(ctx, "form", mu_rect(0, 0, 1280, 8000), MU_OPT_NOSCROLL)) {
+    mu_layout_row(ctx, 2, columns, FORM_ROWS * 28);
+    for (c = 0; c < 2; c++) {
+      mu_layout_begin_column(ctx);
+      for (i = 0; i < FORM_ROWS; i++) {
+        mu_push_id_int(ctx, c * FORM_ROWS + i);
+        mu_layout_row(ctx, 1, &full, 0);
+        mu_layout_begin_flex(ctx, items, 3, MU_FLEX_ROW, ctx->style->spacing);
+        mu_label(ctx, "Name");
+        mu_textbox(ctx, form_fields[c][i], sizeof(form_fields[c][i]));
+        mu_button(ctx, "Apply");
+        mu_layout_end_flex(ctx);
+        mu_pop_id(ctx);
+      }
+      mu_layout_end_column(ctx);
+    }
+    mu_end_window(ctx);
+  }
+}
+
+static const Scene scenes[] = {
+  { "buttons_10k",  scene_buttons },
+  { "windows_1k",   scene_windows },
+  { "tree_deep",    scene_tree    },
+  { "text_long",    scene_text    },
+  { "clip_heavy",   scene_clip    },
+  { "form_nested",  scene_form_nested },
+  { "form_flex",    scene_form_flex   },
+};
+
+static void init_scenes(void) {
+  static const char *words[] = { "lorem", "ipsum", "dolor", "sit", "amet,", "consectetur", "adipiscing", "elit" };
+  int i, len = 0;
+  for (i = 0; i < WINDOWS; i++) { sprintf(window_names[i], "win%d", i); }
+  for (i = 0; len + 16 < (int) sizeof(paragraph); i++) {
+    len += sprintf(paragraph + len, "%s%s", words[i % 8], (i % 40 == 39) ? "\n" : " ");
+  }
+}
+
+
+/*============================================================================
+** measure & report
+**============================================================================*/
+
+static void run_scene(mu_Context *ctx, const Scene *scene, int frames, Result *res) {
+  int i;
+  double total = 0, t;
+
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+  for (i = 0; i < WARMUP_FRAMES; i++) {
+    mu_begin(ctx);
+    scene->build(ctx);
+    mu_end(ctx);
+  }
+  ctx->layout_row_resolves = ctx->layout_row_reuses = 0;
+
+  memset(res, 0, sizeof(*res));
+  res->scene = scene->name;
+  res->frames = frames;
+  res->ns_min = 1e30;
+  for (i = 0; i < frames; i++) {
+    t = now_ns();
+    mu_begin(ctx);
+    scene->build(ctx);
+    mu_end(ctx);
+    t = now_ns() - t;
+    total += t;
+    if (t < res->ns_min) { res->ns_min = t; }
+  }
+  res->ns_mean = total / frames;
+
+  /* 最後のフレームの統計 */
+  res->command_bytes = ctx->stats.command_bytes;
+  res->text_bytes = ctx->stats.text_bytes;
+  memcpy(res->commands, ctx->stats.commands, sizeof(res->commands));
+
+  for (i = 0; i < MU_CONTAINERPOOL_SIZE; i++) {
+    if (ctx->container_pool[i].last_update) { res->containers++; }
+  }
+  for (i = 0; i < MU_TREENODEPOOL_SIZE; i++) {
+    if (ctx->treenode_pool[i].last_update) { res->treenodes++; }
+  }
+  res->layout_resolves = ctx->layout_row_resolves;
+  res->layout_reuses = ctx->layout_row_reuses;
+}
+
+static void print_result(const Result *r, const char *format, int first) {
+  const int *c = r->commands;
+  if (strcmp(format, "json") == 0) {
+    printf("{\"scene\":\"%s\",\"frames\":%d,\"ns_per_frame\":%.0f,\"ns_min\":%.0f,"
+      "\"command_bytes\":%d,\"text_bytes\":%d,\"commands\":{\"jump\":%d,\"clip\":%d,\"rect\":%d,\"text\":%d,\"icon\":%d},"
+      "\"pools\":{\"containers\":%d,\"containers_max\":%d,\"treenodes\":%d,\"treenodes_max\":%d},"
+      "\"layout_rows\":{\"resolves\":%d,\"reuses\":%d}}\n",
+      r->scene, r->frames, r->ns_mean, r->ns_min, r->command_bytes, r->text_bytes,
+      c[MU_COMMAND_JUMP], c[MU_COMMAND_CLIP], c[MU_COMMAND_RECT], c[MU_COMMAND_TEXT], c[MU_COMMAND_ICON],
+      r->containers, MU_CONTAINERPOOL_SIZE, r->treenodes, MU_TREENODEPOOL_SIZE,
+      r->layout_resolves, r->layout_reuses);
+  } else if (strcmp(format, "csv") == 0) {
+    if (first) {
+      printf("scene,frames,ns_per_frame,ns_min,command_bytes,text_bytes,jump,clip,rect,text,icon,"
+        "containers,treenodes,layout_resolves,layout_reuses\n");
+    }
+    printf("%s,%d,%.0f,%.0f,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+      r->scene, r->frames, r->ns_mean, r->ns_min, r->command_bytes, r->text_bytes,
+      c[MU_COMMAND_JUMP], c[MU_COMMAND_CLIP], c[MU_COMMAND_RECT], c[MU_COMMAND_TEXT], c[MU_COMMAND_ICON],
+      r->containers, r->treenodes, r->layout_resolves, r->layout_reuses);
+  } else {
+    if (first) {
+      printf("%-12s %12s %12s %10s %10s %7s %7s %7s %7s %7s %6s %6s\n",
+        "scene", "ns/frame", "ns min", "cmd bytes", "text bytes", "jump", "clip", "rect", "text", "icon", "cnt", "tree");
+    }
+    printf("%-12s %12.0f %12.0f %10d %10d %7d %7d %7d %7d %7d %6d %6d\n",
+      r->scene, r->ns_mean, r->ns_min, r->command_bytes, r->text_bytes,
+      c[MU_COMMAND_JUMP], c[MU_COMMAND_CLIP], c[MU_COMMAND_RECT], c[MU_COMMAND_TEXT], c[MU_COMMAND_ICON],
+      r->containers, r->treenodes);
+  }
+}
+
+/*============================================================================
+** record & replay
+**============================================================================*/
+
+/* 記録用の入力手順（フレーム番号だけで決まる） */
+static void scripted_input(mu_Context *ctx, int frame) {
+  int x = 40 + (frame * 37) % 900, y = 40 + (frame * 53) % 700;
+  mu_input_time(ctx, frame * 16);
+  mu_input_mousemove(ctx, x, y);
+  if (frame % 20 == 5) { mu_input_mousedown(ctx, x, y, MU_MOUSE_LEFT); }
+  if (frame % 20 == 7) { mu_input_mouseup(ctx, x, y, MU_MOUSE_LEFT); }
+  if (frame % 50 == 25) { mu_input_scroll(ctx, 0, frame % 100 < 50 ? 30 : -30); }
+  if (frame % 60 == 30) { mu_input_text(ctx, "hello"); }
+}
+
+static int run_record(mu_Context *ctx, const Scene *scene, int frames, const char *path) {
+  mu_Recorder rec;
+  int i;
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+  if (!mu_record_open(&rec, ctx, path)) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return 1;
+  }
+  for (i = 0; i < frames; i++) {
+    scripted_input(ctx, i);
+    mu_begin(ctx);
+    scene->build(ctx);
+    mu_end(ctx);
+    mu_record_frame(&rec, ctx);
+  }
+  mu_record_close(&rec, ctx);
+  printf("recorded %d frames of %s to %s\n", frames, scene->name, path);
+  return 0;
+}
+
+static int run_capture(mu_Context *ctx, const Scene *scene, int frames, const char *path) {
+  mu_CaptureWriter w;
+  int i;
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+  if (!mu_capture_open(&w, path)) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return 1;
+  }
+  for (i = 0; i < frames; i++) {
+    scripted_input(ctx, i);
+    mu_begin(ctx);
+    scene->build(ctx);
+    mu_end(ctx);
+    mu_capture_frame(&w, ctx);
+  }
+  mu_capture_close(&w);
+  printf("captured %d frames of %s to %s\n", w.frames, scene->name, path);
+  return 0;
+}
+
+static int run_replay(mu_Context *ctx, const Scene *scene, const char *path, const char *format) {
+  mu_Replay rep;
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+  if (!mu_replay_open(&rep, path)) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+  while (mu_replay_next(&rep, ctx)) {
+    mu_begin(ctx);
+    scene->build(ctx);
+    mu_end(ctx);
+    mu_replay_check(&rep, ctx);
+  }
+  mu_replay_close(&rep);
+  if (rep.frame == 0) { rep.min = 0; }
+  if (strcmp(format, "json") == 0) {
+    printf("{\"scene\":\"%s\",\"frames\":%d,\"ns_per_frame\":%.0f,\"ns_min\":%.0f,\"ns_max\":%.0f,"
+      "\"mismatches\":%d,\"first_mismatch\":%d,\"error\":%d}\n",
+      scene->name, rep.frame, rep.frame ? rep.total * 1e9 / rep.frame : 0, rep.min * 1e9, rep.max * 1e9,
+      rep.mismatches, rep.first_mismatch, rep.error);
+  } else {
+    printf("%s: %d frames, %.0f ns/frame (min %.0f, max %.0f), %d mismatches",
+      scene->name, rep.frame, rep.frame ? rep.total * 1e9 / rep.frame : 0, rep.min * 1e9, rep.max * 1e9,
+      rep.mismatches);
+    if (rep.mismatches) { printf(" (first at frame %d)", rep.first_mismatch); }
+    printf("%s\n", rep.error ? ", recording is truncated or corrupt" : "");
+  }
+  return rep.mismatches || rep.error;
+}
+
+static int selected(int argc, char **argv, int first_name, const char *name) {
+  int i;
+  if (first_name >= argc) { return 1; }
+  for (i = first_name; i < argc; i++) {
+    if (strcmp(argv[i], name) == 0) { return 1; }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int i, frames = 200, first = 1, n = 1;
+  const char *format = "text", *record = NULL, *replay = NULL, *capture = NULL;
+  mu_Context *ctx;
+  Result res;
+
+  while (n < argc && argv[n][0] == '-') {
+    if (strcmp(argv[n], "-n") == 0 && n + 1 < argc) {
+      frames = atoi(argv[n + 1]);
+    } else if (strcmp(argv[n], "-f") == 0 && n + 1 < argc) {
+      format = argv[n + 1];
+    } else if (strcmp(argv[n], "-r") == 0 && n + 1 < argc) {
+      record = argv[n + 1];
+    } else if (strcmp(argv[n], "-p") == 0 && n + 1 < argc) {
+      replay = argv[n + 1];
+    } else if (strcmp(argv[n], "-c") == 0 && n + 1 < argc) {
+      capture = argv[n + 1];
+    } else {
+      fprintf(stderr, "usage: %s [-n frames] [-f text|json|csv] [-r file | -p file | -c file] [scene...]\n", argv[0]);
+      return 1;
+    }
+    n += 2;
+  }
+  if (frames < 1) { frames = 1; }
+
+  /* コンテキストはコマンドバッファを含み大きいのでヒープに置く */
+  ctx = malloc(sizeof(mu_Context));
+  if (!ctx) { return 1; }
+  init_scenes();
+
+  /* 記録・再生・保存は選ばれた最初のシーンだけで行う */
+  if (record || replay || capture) {
+    int res = 1;
+    for (i = 0; i < (int) (sizeof(scenes) / sizeof(scenes[0])); i++) {
+      if (!selected(argc, argv, n, scenes[i].name)) { continue; }
+      res = record  ? run_record(ctx, &scenes[i], frames, record)
+          : capture ? run_capture(ctx, &scenes[i], frames, capture)
+                    : run_replay(ctx, &scenes[i], replay, format);
+      break;
+    }
+    free(ctx);
+    return res;
+  }
+
+  for (i = 0; i < (int) (sizeof(scenes) / sizeof(scenes[0])); i++) {
+    if (!selected(argc, argv, n, scenes[i].name)) { continue; }
+    run_scene(ctx, &scenes[i], frames, &res);
+    print_result(&res, format, first);
+    first = 0;
+  }
+  free(ctx);
+  return 0;
+}
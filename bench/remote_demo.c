@@ -0,0 +1,215 @@
+﻿/**
+ * リモート表示のデモ
+ * サーバーは画面なしでUIを動かしてコマンドリストを送り、クライアントは受け取った
+ * フレームを展開して、決まった手順のマウス操作を送り返します。
+ * 終わるとサーバーは送信量（参照を展開した大きさ・実際に送った大きさ・参照で送った
+ * ウィンドウの割合）を、クライアントは受け取ったフレーム数と壊れていた数を表示します。
+ * クライアントの操作がサーバーに届かずIncrementの回数が合わなければ、サーバーは1を返します。
+ * クライアントは途中で覚えているコンテナの内容を1度壊し（サーバー側のハッシュの衝突と
+ * 同じ状況）、RESYNCで送り直してもらって復帰できなければ1を返します。
+ *
+ * 使い方:
+ *   remote_demo server アドレス [フレーム数]
+ *   remote_demo client アドレス
+ *   アドレスは 127.0.0.1:7000 や unix:/tmp/mu.sock です。
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "microui.h"
+#include "remote.h"
+
+static int text_width(mu_Font font, const char *str, int len) {
+  (void) font;
+  if (len < 0) { len = strlen(str); }
+  return len * 7;
+}
+
+static int text_height(mu_Font font) {
+  (void) font;
+  return 16;
+}
+
+static void sleep_ms(int ms) {
+  struct timespec t;
+  t.tv_sec = ms / 1000;
+  t.tv_nsec = (ms % 1000) * 1000000L;
+  nanosleep(&t, NULL);
+}
+
+
+/*============================================================================
+** server
+**============================================================================*/
+
+static int counter;
+static int checked = 1;
+static float volume = 50;
+
+static void build(mu_Context *ctx) {
+  char buf[64];
+  int i;
+  if (mu_begin_window(ctx, "Controls", mu_rect(10, 10, 260, 200))) {
+    mu_layout_row(ctx, 2, (int[]) { 120, -1 }, 0);
+    if (mu_button(ctx, "Increment")) { counter++; }
+    if (mu_button(ctx, "Reset")) { counter = 0; }
+    sprintf(buf, "Count: %d", counter);
+    mu_label(ctx, buf);
+    mu_checkbox(ctx, "Enabled", &checked);
+    mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+    mu_slider(ctx, &volume, 0, 100);
+    mu_end_window(ctx);
+  }
+  /* 操作しても変わらないウィンドウ（2フレーム目からは参照で送られる） */
+  if (mu_begin_window(ctx, "Help", mu_rect(280, 10, 300, 400))) {
+    mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+    for (i = 0; i < 20; i++) {
+      sprintf(buf, "Line %d of the help text", i + 1);
+      mu_label(ctx, buf);
+    }
+    mu_end_window(ctx);
+  }
+  if (mu_begin_window(ctx, "About", mu_rect(10, 220, 260, 120))) {
+    mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+    mu_text(ctx, "microui remote demo: the UI runs in the server process and "
+                 "the command list is streamed to this client.");
+    mu_end_window(ctx);
+  }
+}
+
+static int run_server(const char *address, int frames) {
+  static mu_RemoteServer srv;
+  mu_Context *ctx = malloc(sizeof(mu_Context));
+  double raw = 0, sent = 0, list = 0;
+  long refs = 0, segments = 0;
+  int i, wait, expected;
+  if (!ctx) { return 1; }
+  mu_init(ctx);
+  ctx->text_width = text_width;
+  ctx->text_height = text_height;
+  if (!mu_remote_listen(&srv, address)) {
+    fprintf(stderr, "cannot listen on %s\n", address);
+    return 1;
+  }
+  /* クライアントを5秒まで待つ */
+  for (wait = 0; !mu_remote_poll(&srv, ctx); wait++) {
+    if (wait == 5000) {
+      fprintf(stderr, "no client connected\n");
+      mu_remote_close_server(&srv);
+      return 1;
+    }
+    sleep_ms(1);
+  }
+  for (i = 0; i < frames; i++) {
+    if (!mu_remote_poll(&srv, ctx)) { break; }
+    mu_begin(ctx);
+    build(ctx);
+    mu_end(ctx);
+    if (!mu_remote_send_frame(&srv, ctx)) { break; }
+    list += ctx->command_list.idx;
+    raw += srv.raw_bytes;
+    sent += srv.sent_bytes;
+    refs += srv.refs;
+    segments += srv.segments;
+    sleep_ms(2);
+  }
+  if (i > 0) {
+    printf("server: %d frames, command list %.0f B/frame, encoded %.0f B/frame, "
+           "sent %.0f B/frame, %.1f%% windows by reference, %d resyncs, counter %d\n",
+           i, list / i, raw / i, sent / i, segments ? 100.0 * refs / segments : 0.0, srv.resyncs, counter);
+  }
+  mu_remote_close_server(&srv);
+  free(ctx);
+  if (i != frames) { return 1; }
+  /* 10フレームごと（0フレーム目はホバー前なので除く）。最後の1回は届く前に終わることがある */
+  expected = (frames - 1) / 10;
+  if (counter < expected - 1 || counter > expected) {
+    fprintf(stderr, "server: counter %d, expected %d\n", counter, expected);
+    return 1;
+  }
+  return 0;
+}
+
+
+/*============================================================================
+** client
+**============================================================================*/
+
+/*
+ * 送り返す操作（受け取ったフレーム数だけで決まる）。Incrementを10フレームごとに押す。
+ * ボタンはホバーしてから押さないと反応しないので、1フレーム前に上へ移動しておく
+ */
+#define CORRUPT_FRAME 103   /* 覚えている内容を壊すフレーム */
+
+static void send_input(mu_RemoteClient *cli, int frame) {
+  int x = 70, y = 50;
+  if (frame % 10 >= 2 && frame % 10 <= 8) { x = 20 + (frame * 37) % 240; y = 40 + (frame * 53) % 160; }
+  mu_remote_send_input(cli, MU_EVENT_TIME, 0, 0, frame * 16, NULL);
+  mu_remote_send_input(cli, MU_EVENT_MOUSEMOVE, x, y, 0, NULL);
+  if (frame % 10 == 0) { mu_remote_send_input(cli, MU_EVENT_MOUSEDOWN, x, y, MU_MOUSE_LEFT, NULL); }
+  if (frame % 10 == 1) { mu_remote_send_input(cli, MU_EVENT_MOUSEUP, x, y, MU_MOUSE_LEFT, NULL); }
+}
+
+/*
+ * 覚えているコンテナの内容を1バイトずつ変える。サーバーは同じ内容だと思って参照を送るので、
+ * 次のフレームはハッシュが一致しなくなる
+ */
+static void corrupt_cache(mu_RemoteClient *cli) {
+  int i;
+  for (i = 0; i < MU_CONTAINERPOOL_SIZE; i++) {
+    if (cli->cache[i].size > 0) { cli->cache[i].data[cli->cache[i].size - 1] ^= 1; }
+  }
+}
+
+static int run_client(const char *address) {
+  static mu_RemoteClient cli;
+  mu_Context *ctx = malloc(sizeof(mu_Context));
+  int commands = 0, tries, errors_before = -1, recovered = 0;
+  if (!ctx) { return 1; }
+  mu_init(ctx);
+  /* サーバーの待ち受けが始まるまで少し待つ */
+  for (tries = 0; !mu_remote_connect(&cli, address); tries++) {
+    if (tries == 100) {
+      fprintf(stderr, "cannot connect to %s\n", address);
+      return 1;
+    }
+    sleep_ms(20);
+  }
+  while (!cli.closed) {
+    if (mu_remote_receive(&cli, ctx, 100)) {
+      mu_Command *cmd = NULL;
+      commands = 0;
+      while (mu_next_command(ctx, &cmd)) { commands++; }
+      if (errors_before >= 0 && cli.errors > errors_before && !recovered) { recovered = cli.frames; }
+      send_input(&cli, cli.frames);
+      /* クリックの前後（10で割って0と1）を避けて壊す */
+      if (errors_before < 0 && cli.frames >= CORRUPT_FRAME) {
+        errors_before = cli.errors;
+        corrupt_cache(&cli);
+      }
+    }
+  }
+  printf("client: %d frames, %d errors, %d commands in the last frame",
+         cli.frames, cli.errors, commands);
+  if (recovered) { printf(", recovered from the corrupted cache at frame %d", recovered); }
+  printf("\n");
+  mu_remote_disconnect(&cli);
+  free(ctx);
+  /* 壊す前の失敗と、壊した後に復帰できなかった場合は失敗 */
+  if (errors_before > 0 || (cli.errors > 0 && !recovered)) { return 1; }
+  return 0;
+}
+
+
+int main(int argc, char **argv) {
+  if (argc >= 3 && strcmp(argv[1], "server") == 0) {
+    return run_server(argv[2], argc >= 4 ? atoi(argv[3]) : 300);
+  }
+  if (argc >= 3 && strcmp(argv[1], "client") == 0) {
+    return run_client(argv[2]);
+  }
+  fprintf(stderr, "usage: %s server address [frames] | client address\n", argv[0]);
+  return 1;
+}
@@ -0,0 +1,270 @@
+﻿/**
+ * コマンドリストの保存・再投入モジュール (microui用)
+ * 詳細はcommand_capture.hを参照してください。
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "command_capture.h"
+
+/* 種類ごとの保存サイズ（種類の1バイトを除く）。TEXTは文字列を含まない */
+#define CLIP_BYTES 16
+#define RECT_BYTES 20
+#define ICON_BYTES 24
+#define TEXT_BYTES 17
+
+
+/*============================================================================
+** write
+**============================================================================*/
+
+static void write_u32(FILE *fp, unsigned v) {
+  fputc(v & 0xff, fp);
+  fputc(v >> 8 & 0xff, fp);
+  fputc(v >> 16 & 0xff, fp);
+  fputc(v >> 24 & 0xff, fp);
+}
+
+static void write_rect(FILE *fp, mu_Rect r) {
+  write_u32(fp, r.x); write_u32(fp, r.y); write_u32(fp, r.w); write_u32(fp, r.h);
+}
+
+static void write_color(FILE *fp, mu_Color c) {
+  fputc(c.r, fp); fputc(c.g, fp); fputc(c.b, fp); fputc(c.a, fp);
+}
+
+
+/**
+ * @brief フォントの番号（内部関数）
+ * 初めてのフォントなら番号を割り当てます。
+ * @return int 番号、表が一杯なら-1
+ */
+static int font_id(mu_Font *fonts, int *count, mu_Font font) {
+  int i;
+  for (i = 0; i < *count; i++) {
+    if (fonts[i] == font) { return i; }
+  }
+  if (*count == MU_CAPTURE_FONTS) { return -1; }
+  fonts[*count] = font;
+  return (*count)++;
+}
+
+
+int mu_capture_open(mu_CaptureWriter *w, const char *path) {
+  memset(w, 0, sizeof(*w));
+  w->fp = fopen(path, "wb");
+  if (!w->fp) { return 0; }
+  fwrite("MUCC", 1, 4, w->fp);
+  write_u32(w->fp, MU_CAPTURE_VERSION);
+  return 1;
+}
+
+
+int mu_capture_frame(mu_CaptureWriter *w, mu_Context *ctx) {
+  mu_Font fonts[MU_CAPTURE_FONTS];
+  int font_count = w->font_count;
+  unsigned bytes = 0, count = 0;
+  mu_Command *cmd = NULL;
+  if (!w->fp) { return 0; }
+
+  /* 1回目: 大きさを数え、フォントに番号を付ける（失敗したら表を戻せるよう複製で行う） */
+  memcpy(fonts, w->fonts, sizeof(fonts));
+  while (mu_next_command(ctx, &cmd)) {
+    switch (cmd->type) {
+      case MU_COMMAND_CLIP: bytes += 1 + CLIP_BYTES; break;
+      case MU_COMMAND_RECT: bytes += 1 + RECT_BYTES; break;
+      case MU_COMMAND_ICON: bytes += 1 + ICON_BYTES; break;
+      case MU_COMMAND_TEXT:
+        if (font_id(fonts, &font_count, cmd->text.font) < 0) { return 0; }
+        bytes += 1 + TEXT_BYTES + cmd->text.len;
+        break;
+      default: continue;
+    }
+    count++;
+  }
+  memcpy(w->fonts, fonts, sizeof(fonts));
+  w->font_count = font_count;
+
+  /* 2回目: 書き出し */
+  write_u32(w->fp, bytes);
+  write_u32(w->fp, count);
+  cmd = NULL;
+  while (mu_next_command(ctx, &cmd)) {
+    int len;
+    switch (cmd->type) {
+      case MU_COMMAND_CLIP:
+        fputc(cmd->type, w->fp);
+        write_rect(w->fp, cmd->clip.rect);
+        break;
+      case MU_COMMAND_RECT:
+        fputc(cmd->type, w->fp);
+        write_rect(w->fp, cmd->rect.rect);
+        write_color(w->fp, cmd->rect.color);
+        break;
+      case MU_COMMAND_ICON:
+        fputc(cmd->type, w->fp);
+        write_rect(w->fp, cmd->icon.rect);
+        write_u32(w->fp, cmd->icon.id);
+        write_color(w->fp, cmd->icon.color);
+        break;
+      case MU_COMMAND_TEXT:
+        len = cmd->text.len;
+        fputc(cmd->type, w->fp);
+        fputc(font_id(w->fonts, &w->font_count, cmd->text.font), w->fp);
+        write_u32(w->fp, cmd->text.pos.x);
+        write_u32(w->fp, cmd->text.pos.y);
+        write_color(w->fp, cmd->text.color);
+        write_u32(w->fp, len);
+        fwrite(cmd->text.str, 1, len, w->fp);
+        break;
+    }
+  }
+  w->frames++;
+  return 1;
+}
+
+
+void mu_capture_close(mu_CaptureWriter *w) {
+  if (w->fp) { fclose(w->fp); }
+  w->fp = NULL;
+}
+
+
+/*============================================================================
+** read
+**============================================================================*/
+
+static unsigned read_u32(const unsigned char *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (unsigned) p[3] << 24;
+}
+
+static mu_Rect read_rect(const unsigned char *p) {
+  return mu_rect(read_u32(p), read_u32(p + 4), read_u32(p + 8), read_u32(p + 12));
+}
+
+static mu_Color read_color(const unsigned char *p) {
+  mu_Color c;
+  c.r = p[0]; c.g = p[1]; c.b = p[2]; c.a = p[3];
+  return c;
+}
+
+
+int mu_capture_load(mu_CaptureReader *r, const char *path) {
+  FILE *fp;
+  long size;
+  int pos, capacity = 0;
+  memset(r, 0, sizeof(*r));
+  fp = fopen(path, "rb");
+  if (!fp) { return 0; }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  r->data = size >= 8 ? malloc(size) : NULL;
+  if (!r->data || fread(r->data, 1, size, fp) != (size_t) size ||
+      memcmp(r->data, "MUCC", 4) != 0 || read_u32(r->data + 4) != MU_CAPTURE_VERSION)
+  {
+    fclose(fp);
+    mu_capture_free(r);
+    return 0;
+  }
+  fclose(fp);
+  r->size = (int) size;
+
+  /* フレームの位置を調べる */
+  for (pos = 8; pos + 8 <= r->size; pos += 8 + read_u32(r->data + pos)) {
+    if (read_u32(r->data + pos) > (unsigned) (r->size - pos - 8)) { break; }
+    if (r->frame_count == capacity) {
+      int *frames;
+      capacity = capacity ? capacity * 2 : 64;
+      frames = realloc(r->frames, capacity * sizeof(int));
+      if (!frames) { break; }
+      r->frames = frames;
+    }
+    r->frames[r->frame_count++] = pos;
+  }
+  return 1;
+}
+
+
+/**
+ * @brief コマンド1つの再投入（内部関数）
+ * @param r 読み込んだファイル
+ * @param ctx MicroUIのコンテキスト
+ * @param pos 読み出し位置（次のコマンドへ進める）
+ * @param end フレームの末尾
+ * @return int 成功したら1、壊れているかコマンドリストに入らなければ0
+ */
+static int inject_command(const mu_CaptureReader *r, mu_Context *ctx,
+  const unsigned char **pos, const unsigned char *end)
+{
+  const unsigned char *p = *pos;
+  mu_Command cmd;
+  int len;
+  if (p >= end) { return 0; }
+  cmd.type = *p++;
+  switch (cmd.type) {
+    case MU_COMMAND_CLIP: len = CLIP_BYTES; break;
+    case MU_COMMAND_RECT: len = RECT_BYTES; break;
+    case MU_COMMAND_ICON: len = ICON_BYTES; break;
+    case MU_COMMAND_TEXT:
+      if (end - p < TEXT_BYTES) { return 0; }
+      cmd.text.len = read_u32(p + 13);
+      if (cmd.text.len < 0 || cmd.text.len > end - p - TEXT_BYTES) { return 0; }
+      len = TEXT_BYTES + cmd.text.len;
+      break;
+    default: return 0;
+  }
+  if (end - p < len) { return 0; }
+
+  switch (cmd.type) {
+    case MU_COMMAND_CLIP: cmd.clip.rect = read_rect(p); break;
+    case MU_COMMAND_RECT:
+      cmd.rect.rect = read_rect(p);
+      cmd.rect.color = read_color(p + 16);
+      break;
+    case MU_COMMAND_ICON:
+      cmd.icon.rect = read_rect(p);
+      cmd.icon.id = read_u32(p + 16);
+      cmd.icon.color = read_color(p + 20);
+      break;
+    case MU_COMMAND_TEXT:
+      cmd.text.font = p[0] < MU_CAPTURE_FONTS ? r->fonts[p[0]] : NULL;
+      cmd.text.pos = mu_vec2(read_u32(p + 1), read_u32(p + 5));
+      cmd.text.color = read_color(p + 9);
+      cmd.text.str = (const char*) p + TEXT_BYTES;
+      break;
+  }
+  if (!mu_inject_command(ctx, &cmd)) { return 0; }
+  *pos = p + len;
+  return 1;
+}
+
+
+int mu_capture_inject(const mu_CaptureReader *r, mu_Context *ctx, int frame) {
+  const unsigned char *p, *end;
+  int i, count;
+  if (frame < 0 || frame >= r->frame_count) { return -1; }
+  p = r->data + r->frames[frame];
+  end = p + 8 + read_u32(p);
+  count = read_u32(p + 4);
+  p += 8;
+
+  mu_clear_commands(ctx);
+  for (i = 0; i < count; i++) {
+    if (!inject_command(r, ctx, &p, end)) { break; }
+  }
+  mu_commit_commands(ctx);
+  if (i < count) {
+    mu_clear_commands(ctx);
+    return -1;
+  }
+  return count;
+}
+
+
+void mu_capture_free(mu_CaptureReader *r) {
+  free(r->data);
+  free(r->frames);
+  r->data = NULL;
+  r->frames = NULL;
+  r->size = r->frame_count = 0;
+}
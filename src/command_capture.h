@@ -0,0 +1,128 @@
+/**
+ * コマンドリストの保存・再投入モジュール (microui用)
+ * mu_endで完成したコマンドリストを、mu_next_commandで走査した順にファイルへ保存し、
+ * 後からコンテキストのコマンドリストへ戻します。戻したコマンドはmu_next_commandで
+ * そのまま走査できるので、r_drawのswitchやmu_quad_buildなど既存の処理に
+ * 元のアプリなしで何度でも流せます（描画処理だけの計測や検証用）。
+ *
+ * - JUMPは辿った結果の順に並べ直して保存するので、ファイルにJUMPは含みません。
+ * - 文字列はコマンド内に含めます。
+ * - mu_Fontはポインタなので、出現順の番号（0〜MU_CAPTURE_FONTS-1）に置き換えます。
+ *   戻す時はmu_CaptureReader.fonts[番号]のフォントを設定します。
+ *
+ * ファイル形式（整数は全てリトルエンディアン）:
+ *   "MUCC" バージョン(u32)
+ *   フレームの列
+ *     バイト数(u32) コマンド数(u32) コマンドの列
+ *       種類(u8) に続けて
+ *       CLIP: 矩形(i32 x4)
+ *       RECT: 矩形(i32 x4) 色(u8 x4)
+ *       ICON: 矩形(i32 x4) アイコン(i32) 色(u8 x4)
+ *       TEXT: フォント番号(u8) 位置(i32 x2) 色(u8 x4) 長さ(u32) 文字列
+ *
+ * 使い方（保存）:
+ *   mu_capture_open(&w, "frames.mucc");
+ *   ... mu_end(ctx); mu_capture_frame(&w, ctx); ...
+ *   mu_capture_close(&w);
+ *
+ * 使い方（再投入）:
+ *   mu_capture_load(&r, "frames.mucc");
+ *   for (i = 0; i < r.frame_count; i++) {
+ *     mu_capture_inject(&r, ctx, i);
+ *     while (mu_next_command(ctx, &cmd)) { ... }
+ *   }
+ *   mu_capture_free(&r);
+ */
+#ifndef COMMAND_CAPTURE_H
+#define COMMAND_CAPTURE_H
+
+#include <stdio.h>
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MU_CAPTURE_VERSION 1
+#define MU_CAPTURE_FONTS   16    /* 番号に置き換えられるフォントの数 */
+
+typedef struct {
+  FILE *fp;
+  mu_Font fonts[MU_CAPTURE_FONTS];  /* 番号→フォント（出現順） */
+  int font_count;
+  int frames;            /* 保存したフレーム数 */
+} mu_CaptureWriter;
+
+typedef struct {
+  unsigned char *data;   /* ファイルの内容 */
+  int size;
+  int *frames;           /* フレームごとの先頭位置 */
+  int frame_count;
+  mu_Font fonts[MU_CAPTURE_FONTS];  /* 戻す時に使うフォント（既定はNULL） */
+} mu_CaptureReader;
+
+/**
+ * @brief 保存の開始
+ * ファイルを作成してヘッダーを書き込みます。
+ * 使い方: mu_capture_open(&w, "frames.mucc");
+ * @param w 保存先
+ * @param path 出力ファイル名
+ * @return int 成功したら1、ファイルを作成できなければ0
+ */
+int mu_capture_open(mu_CaptureWriter *w, const char *path);
+
+/**
+ * @brief フレームの保存
+ * mu_endの後に呼び出し、コマンドリストを1フレームとして追加します。
+ * 使い方: mu_capture_frame(&w, ctx);
+ * @param w 保存先
+ * @param ctx MicroUIのコンテキスト
+ * @return int 保存したら1、フォントがMU_CAPTURE_FONTSより多ければ0（何も書かない）
+ */
+int mu_capture_frame(mu_CaptureWriter *w, mu_Context *ctx);
+
+/**
+ * @brief 保存の終了
+ * 使い方: mu_capture_close(&w);
+ * @param w 保存先
+ * @return なし
+ */
+void mu_capture_close(mu_CaptureWriter *w);
+
+/**
+ * @brief ファイルの読み込み
+ * ファイル全体を読み込み、フレームの位置を調べます。
+ * 末尾の途中で切れたフレームは含めません。
+ * 使い方: mu_capture_load(&r, "frames.mucc");
+ * @param r 読み込み先
+ * @param path ファイル名
+ * @return int 成功したら1、開けないか形式・バージョンが違えば0
+ */
+int mu_capture_load(mu_CaptureReader *r, const char *path);
+
+/**
+ * @brief フレームをコマンドリストへ戻す
+ * ctx->command_listの内容をフレームのコマンドで置き換えます（文字列は文字列プールに置きます）。
+ * JUMPを含まない並びになるので、mu_next_commandで先頭から順に走査できます。
+ * mu_beginとmu_endの間では呼ばないでください。
+ * 使い方: mu_capture_inject(&r, ctx, i);
+ * @param r 読み込んだファイル
+ * @param ctx MicroUIのコンテキスト
+ * @param frame フレーム番号（0から）
+ * @return int 戻したコマンド数、フレームが壊れているかコマンドリスト・文字列プールに入らなければ-1
+ */
+int mu_capture_inject(const mu_CaptureReader *r, mu_Context *ctx, int frame);
+
+/**
+ * @brief 読み込んだファイルの解放
+ * 使い方: mu_capture_free(&r);
+ * @param r 読み込み先
+ * @return なし
+ */
+void mu_capture_free(mu_CaptureReader *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
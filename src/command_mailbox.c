@@ -0,0 +1,99 @@
+﻿/**
+ * コマンド受け渡しモジュール (microui用)
+ * 詳細はcommand_mailbox.hを参照してください。
+ */
+#include "command_mailbox.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedExchange, _InterlockedOr)
+#define atomic_exchange(p, v) _InterlockedExchange((p), (v))
+#define atomic_load(p)        _InterlockedOr((p), 0)
+#else
+#define atomic_exchange(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_load(p)        __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#endif
+
+
+/**
+ * @brief 受け渡しの初期化
+ * 使い方: mu_mailbox_init(&mailbox, ctx);
+ * @param mb 受け渡し用構造体
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_mailbox_init(mu_CommandMailbox *mb, mu_Context *ctx) {
+  int i;
+  for (i = 0; i < 3; i++) {
+    mb->slots[i].items = mb->buffers[i];
+    mb->slots[i].texts = mb->texts[i];
+    mb->slots[i].size = 0;
+    mb->slots[i].frame = 0;
+    mb->slots[i].ctx = ctx;
+    mb->slots[i].read = mb->buffers[i];
+  }
+  mb->building = 0;
+  mb->state = 1;
+  mb->rendering = 2;
+  ctx->command_list.items = mb->slots[mb->building].items;
+  ctx->text_pool.items = mb->slots[mb->building].texts;
+  mu_clear_commands(ctx);
+}
+
+/**
+ * @brief スナップショットの公開（UIスレッド）
+ * 書き終えたスロットとFRESHビットをstateに入れ、代わりに出てきたスロットを
+ * 次の書き込み先にします。出てきたスロットは描画スレッドが持っていないので自由に使えます。
+ * 使い方: mu_mailbox_publish(&mailbox, ctx);
+ * @param mb 受け渡し用構造体
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_mailbox_publish(mu_CommandMailbox *mb, mu_Context *ctx) {
+  mu_CommandSnapshot *snap = &mb->slots[mb->building];
+  long old;
+  mu_commit_commands(ctx);
+  snap->size = ctx->command_list.idx;
+  snap->frame = ctx->frame;
+  old = atomic_exchange(&mb->state, mb->building | MU_MAILBOX_FRESH);
+  mb->building = (int) (old & 3);
+  /* 次のmu_beginまでmu_next_commandが何も返さないようにする */
+  ctx->command_list.items = mb->slots[mb->building].items;
+  ctx->text_pool.items = mb->slots[mb->building].texts;
+  mu_clear_commands(ctx);
+}
+
+/**
+ * @brief 最新スナップショットの取得（描画スレッド）
+ * FRESHビットを立てるのはUIスレッドだけ、消すのは描画スレッドだけなので、
+ * 一度FRESHを見たら交換するまでFRESHのままです（交換で最新のスロットが手に入る）。
+ * 使い方: snap = mu_mailbox_acquire(&mailbox);
+ * @param mb 受け渡し用構造体
+ * @return mu_CommandSnapshot* 描画するスナップショット
+ */
+mu_CommandSnapshot* mu_mailbox_acquire(mu_CommandMailbox *mb) {
+  if (atomic_load(&mb->state) & MU_MAILBOX_FRESH) {
+    long old = atomic_exchange(&mb->state, mb->rendering);
+    mb->rendering = (int) (old & 3);
+  }
+  return &mb->slots[mb->rendering];
+}
+
+/**
+ * @brief スナップショットの次のコマンドを取得する
+ * mu_read_commandで読むので、MU_COMPACT_COMMANDSの符号化したコマンドも展開して返す。
+ * 使い方: while (mu_next_snapshot_command(snap, &cmd)) { ... }
+ * @param snap スナップショット
+ * @param cmd コマンドへのポインタ（NULLの場合は先頭から）
+ * @return int 有効なコマンドがあれば1、末尾なら0
+ */
+int mu_next_snapshot_command(mu_CommandSnapshot *snap, mu_Command **cmd) {
+  char *end = snap->items + snap->size;
+  if (!*cmd) { snap->read = snap->items; }
+  while (snap->read != end) {
+    *cmd = mu_read_command(snap->ctx, &snap->read, &snap->scratch);
+    if ((*cmd)->type != MU_COMMAND_JUMP) { return 1; }
+    snap->read = (*cmd)->jump.dst;
+  }
+  return 0;
+}
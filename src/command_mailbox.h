@@ -0,0 +1,107 @@
+/**
+ * コマンド受け渡しモジュール (microui用)
+ * mu_endで完成したコマンドリストを、コピーせずに描画スレッドへ渡します。
+ * 3つのバッファを回して使い（トリプルバッファ）、受け渡しは
+ * アトミックな交換1回で行うため、どちらのスレッドも待たされません。
+ * UIスレッドが次のフレームを組み立てている間に、描画スレッドは
+ * 前のフレームを描画できます。
+ *
+ * 使い方:
+ *   UIスレッド:   mu_begin → ウィンドウ処理 → mu_end → mu_mailbox_publish
+ *   描画スレッド: snap = mu_mailbox_acquire → mu_next_snapshot_command で走査
+ *
+ * 所有権:
+ * - publish後のバッファは描画スレッドのものです。UIスレッドは触りません。
+ * - 描画スレッドは次にacquireするまで、受け取ったスナップショットを使えます。
+ * - mu_draw_textのテキストはスロットごとの文字列プールにコピーされるので、
+ *   元の文字列はmu_draw_textの後に解放・書き換えしても構いません。
+ * - mu_draw_text_staticのテキストはコピーされません。フォントと同じく、
+ *   描画スレッドが使い終わるまで（少なくとも2フレーム先まで）書き換えないでください。
+ * - mu_Font（TEXTコマンドのfont）はポインタのまま渡ります。フォントは
+ *   描画スレッドが使い終わるまで（少なくとも2フレーム先まで）解放しないでください。
+ * - JUMPコマンドの飛び先は同じバッファ内を指すため、スナップショット単体で走査できます。
+ *   コンテナ（mu_Container）への参照は含みません。
+ * - MU_COMPACT_COMMANDSでも使えます。走査はmu_read_commandで展開するので、描画スレッドは
+ *   コンテキストのフォント番号の表（mu_init以降追加のみ）を読みます。
+ */
+#ifndef COMMAND_MAILBOX_H
+#define COMMAND_MAILBOX_H
+
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* stateのビット: 新しいスナップショットが未取得 */
+#define MU_MAILBOX_FRESH 4
+
+/* 1フレーム分のコマンドリスト */
+typedef struct {
+  char *items;           /* コマンドの先頭 */
+  char *texts;           /* TEXTコマンドが指す文字列プール */
+  int size;              /* 使用バイト数 */
+  int frame;             /* 作成したフレーム番号（ctx->frame） */
+  mu_Context *ctx;       /* mu_read_commandに渡すコンテキスト */
+  char *read;            /* 走査位置（mu_next_snapshot_command） */
+  mu_CommandScratch scratch;  /* 走査で展開したコマンド（MU_COMPACT_COMMANDS） */
+} mu_CommandSnapshot;
+
+typedef struct {
+  char buffers[3][MU_COMMANDLIST_SIZE];
+  char texts[3][MU_TEXTPOOL_SIZE];      /* スロットごとの文字列プール */
+  mu_CommandSnapshot slots[3];
+  volatile long state;   /* 下位2ビット: 受け渡し中のスロット、MU_MAILBOX_FRESH */
+  int building;          /* UIスレッドが書き込み中のスロット */
+  int rendering;         /* 描画スレッドが読み込み中のスロット */
+} mu_CommandMailbox;
+
+/**
+ * @brief 受け渡しの初期化
+ * バッファを初期化し、コンテキストのコマンドリストと文字列プールを1つ目のスロットに差し替えます。
+ * mu_initの後、スレッドを開始する前に呼び出してください。
+ * 使い方: mu_mailbox_init(&mailbox, ctx);
+ * @param mb 受け渡し用構造体（既定の大きさで約1.5MBあるので静的領域かヒープに置く）
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_mailbox_init(mu_CommandMailbox *mb, mu_Context *ctx);
+
+/**
+ * @brief スナップショットの公開（UIスレッド）
+ * mu_end後のコマンドリストを描画スレッドに渡し、空いているバッファを
+ * 次のフレーム用にコンテキストへ設定します。描画スレッドが前回分を
+ * 取得していなければ、その古いスナップショットは捨てられます。
+ * 使い方: mu_end(ctx); mu_mailbox_publish(&mailbox, ctx);
+ * @param mb 受け渡し用構造体
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_mailbox_publish(mu_CommandMailbox *mb, mu_Context *ctx);
+
+/**
+ * @brief 最新スナップショットの取得（描画スレッド）
+ * 新しいスナップショットが公開されていれば受け取り、なければ前回と同じものを返します。
+ * 変化したかどうかはframeで判定できます。
+ * 使い方: mu_CommandSnapshot *snap = mu_mailbox_acquire(&mailbox);
+ * @param mb 受け渡し用構造体
+ * @return mu_CommandSnapshot* 描画するスナップショット（未公開ならsizeは0）
+ */
+mu_CommandSnapshot* mu_mailbox_acquire(mu_CommandMailbox *mb);
+
+/**
+ * @brief スナップショットの次のコマンドを取得する
+ * mu_next_commandと同じ走査をスナップショットに対して行います。
+ * 走査位置はスナップショットに持つので、1つのスナップショットを同時に2か所で走査しないでください。
+ * 使い方: mu_Command *cmd = NULL; while (mu_next_snapshot_command(snap, &cmd)) { ... }
+ * @param snap スナップショット
+ * @param cmd コマンドへのポインタ（NULLの場合は先頭から）
+ * @return int 有効なコマンドがあれば1、末尾なら0
+ */
+int mu_next_snapshot_command(mu_CommandSnapshot *snap, mu_Command **cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
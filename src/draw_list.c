@@ -0,0 +1,209 @@
+﻿/**
+ * 描画リストモジュール (microui用)
+ * 詳細はdraw_list.hを参照してください。
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "draw_list.h"
+
+/* 16ビットインデックスで表せる頂点数 */
+#define MAX_INDEX16_VERTICES 65536
+
+static mu_Rect unclipped_rect = { 0, 0, 0x1000000, 0x1000000 };
+
+
+/**
+ * @brief 32ビットインデックスに広げられるか（内部関数）
+ */
+static int can_widen(const mu_DrawList *list) {
+  return list->max_vertices == 0 || list->max_vertices > MAX_INDEX16_VERTICES;
+}
+
+
+/**
+ * @brief 頂点・インデックスバッファの確保（内部関数）
+ * 指定した頂点数を格納できるように頂点とインデックスのバッファを拡張します。
+ * 頂点数が16ビットで表せない場合は、使えればインデックスを32ビットに広げます。
+ * @param list 描画リスト
+ * @param vertices 必要な頂点数
+ * @return int 成功なら1、確保失敗なら0
+ */
+static int reserve(mu_DrawList *list, int vertices) {
+  int indices = vertices * 3 / 2;
+  int index_size = (vertices > MAX_INDEX16_VERTICES && can_widen(list)) ? 4 : list->index_size;
+
+  if (vertices > list->vertex_capacity) {
+    void *p = realloc(list->vertices, vertices * sizeof(mu_DrawVertex));
+    if (!p) { return 0; }
+    list->vertices = p;
+    list->vertex_capacity = vertices;
+  }
+
+  if (index_size != list->index_size || indices > list->index_capacity) {
+    int cap = mu_max(indices, list->index_capacity);
+    void *p = realloc(list->indices, cap * index_size);
+    if (!p) { return 0; }
+    list->indices = p;
+    list->index_capacity = cap;
+    /* 16ビットから32ビットへの切り替え: 後ろから広げれば上書きしない */
+    if (index_size != list->index_size) {
+      unsigned short *src = p;
+      unsigned *dst = p;
+      int i = list->index_count;
+      while (i--) { dst[i] = src[i]; }
+      list->index_size = index_size;
+    }
+  }
+  return 1;
+}
+
+
+/**
+ * @brief 描画範囲の追加（内部関数）
+ * @param list 描画リスト
+ * @param clip クリップ矩形
+ * @return int 成功なら1、確保失敗なら0
+ */
+static int push_range(mu_DrawList *list, mu_Rect clip) {
+  mu_DrawRange *r;
+  if (list->range_count == list->range_capacity) {
+    int cap = list->range_capacity ? list->range_capacity * 2 : 64;
+    void *p = realloc(list->ranges, cap * sizeof(mu_DrawRange));
+    if (!p) { return 0; }
+    list->ranges = p;
+    list->range_capacity = cap;
+  }
+  r = &list->ranges[list->range_count++];
+  r->index_offset = list->index_count;
+  r->index_count = 0;
+  r->base_vertex = list->base_vertex;
+  r->clip = clip;
+  return 1;
+}
+
+
+static int same_rect(mu_Rect a, mu_Rect b) {
+  return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+
+void mu_draw_list_init(mu_DrawList *list, int initial_vertices) {
+  memset(list, 0, sizeof(*list));
+  list->index_size = 2;
+  list->high_water = initial_vertices;
+  list->clip = unclipped_rect;
+}
+
+
+void mu_draw_list_free(mu_DrawList *list) {
+  free(list->vertices);
+  free(list->indices);
+  free(list->ranges);
+  memset(list, 0, sizeof(*list));
+}
+
+
+void mu_draw_list_begin(mu_DrawList *list) {
+  /* 前フレームの最大頂点数に1/4の余裕を持たせて確保しておく */
+  int want = list->high_water + list->high_water / 4;
+  list->vertex_count = 0;
+  list->index_count = 0;
+  list->range_count = 0;
+  list->base_vertex = 0;
+  list->failed = 0;
+  list->clip = unclipped_rect;
+  /* 小さいフレームに戻ったら16ビットインデックスに戻す（同じ領域で2倍の要素が入る） */
+  if (list->index_size == 4 && want <= MAX_INDEX16_VERTICES) {
+    list->index_size = 2;
+    list->index_capacity *= 2;
+  }
+  if (!reserve(list, want) || !push_range(list, list->clip)) { list->failed = 1; }
+}
+
+
+void mu_draw_list_end(mu_DrawList *list) {
+  /* 最後の範囲が空なら取り除く */
+  if (list->range_count > 0 && list->ranges[list->range_count - 1].index_count == 0) {
+    list->range_count--;
+  }
+  list->high_water = list->vertex_count;
+}
+
+
+void mu_draw_list_set_clip(mu_DrawList *list, mu_Rect clip) {
+  mu_DrawRange *r;
+  list->clip = clip;
+  if (list->failed || list->range_count == 0) { return; }
+  r = &list->ranges[list->range_count - 1];
+  if (same_rect(r->clip, clip)) { return; }
+  if (r->index_count > 0) {
+    if (!push_range(list, clip)) { list->failed = 1; }
+    return;
+  }
+  /* 空の範囲はクリップを差し替える。直前の範囲と同じクリップ・先頭頂点に戻ったなら統合する */
+  if (list->range_count > 1 && same_rect(list->ranges[list->range_count - 2].clip, clip) &&
+      list->ranges[list->range_count - 2].base_vertex == r->base_vertex)
+  {
+    list->range_count--;
+  } else {
+    r->clip = clip;
+  }
+}
+
+
+void mu_draw_list_quad(mu_DrawList *list, mu_Rect dst,
+  float u0, float v0, float u1, float v1, unsigned color)
+{
+  mu_DrawVertex *v;
+  int n = list->vertex_count;
+  int i = list->index_count;
+  int k;
+  if (list->failed) { return; }
+  /* 範囲から参照できる頂点数を超えるなら、ここから新しい範囲にする（同じクリップ） */
+  if (list->max_vertices > 0 && n + 4 - list->base_vertex > list->max_vertices) {
+    mu_DrawRange *r = &list->ranges[list->range_count - 1];
+    list->base_vertex = n;
+    if (r->index_count == 0) {
+      r->base_vertex = n;
+    } else if (!push_range(list, list->clip)) {
+      list->failed = 1;
+      return;
+    }
+  }
+  if (n + 4 > list->vertex_capacity || i + 6 > list->index_capacity ||
+      (n + 4 > MAX_INDEX16_VERTICES && list->index_size == 2 && can_widen(list)))
+  {
+    if (!reserve(list, mu_max(n + 4, list->vertex_capacity * 2))) {
+      list->failed = 1;
+      return;
+    }
+  }
+
+  v = &list->vertices[n];
+  v[0].x = (float) dst.x;           v[0].y = (float) dst.y;
+  v[1].x = (float) (dst.x + dst.w); v[1].y = (float) dst.y;
+  v[2].x = (float) dst.x;           v[2].y = (float) (dst.y + dst.h);
+  v[3].x = (float) (dst.x + dst.w); v[3].y = (float) (dst.y + dst.h);
+  v[0].u = u0; v[0].v = v0;
+  v[1].u = u1; v[1].v = v0;
+  v[2].u = u0; v[2].v = v1;
+  v[3].u = u1; v[3].v = v1;
+  v[0].z = v[1].z = v[2].z = v[3].z = 0.5f;
+  v[0].color = v[1].color = v[2].color = v[3].color = color;
+
+  k = n - list->base_vertex;
+  if (list->index_size == 2) {
+    unsigned short *idx = (unsigned short*) list->indices + i;
+    idx[0] = (unsigned short) (k + 0); idx[1] = (unsigned short) (k + 1);
+    idx[2] = (unsigned short) (k + 2); idx[3] = (unsigned short) (k + 2);
+    idx[4] = (unsigned short) (k + 1); idx[5] = (unsigned short) (k + 3);
+  } else {
+    unsigned *idx = (unsigned*) list->indices + i;
+    idx[0] = k + 0; idx[1] = k + 1; idx[2] = k + 2;
+    idx[3] = k + 2; idx[4] = k + 1; idx[5] = k + 3;
+  }
+
+  list->vertex_count += 4;
+  list->index_count += 6;
+  list->ranges[list->range_count - 1].index_count += 6;
+}
@@ -0,0 +1,120 @@
+/**
+ * 描画リストモジュール (microui用)
+ * 頂点・インデックスとクリップごとの描画範囲を1フレーム分まとめて記録します。
+ * 途中でフラッシュせずに最後まで積み上げ、記録した範囲ごとに
+ * シザー矩形を設定して描画するため、クリップの順序が崩れません。
+ * プラットフォーム非依存なので、描画APIなしでも動作確認できます。
+ *
+ * - バッファは前フレームの最大頂点数（high water）を元に確保します。
+ * - 頂点数が65536を超えると32ビットインデックスに切り替えます。
+ *   max_verticesを65536以下にした場合（32ビットインデックスのないデバイス）は切り替えず、
+ *   その頂点数ごとに描画範囲を分けて、範囲の先頭頂点（base_vertex）からの相対値で記録します。
+ * - 同じクリップ矩形が続く範囲は1つにまとめ、描画呼び出しを最小にします。
+ */
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 頂点（renderer.hのstruct Vertexと同じ24バイトの並び） */
+typedef struct {
+  float x, y, z;
+  unsigned color;        /* D3DCOLOR形式（ARGB） */
+  float u, v;
+} mu_DrawVertex;
+
+/* 1回の描画呼び出しに対応する範囲 */
+typedef struct {
+  int index_offset;      /* 先頭インデックスの位置 */
+  int index_count;       /* インデックス数 */
+  int base_vertex;       /* インデックスに足す頂点の位置（D3DのBaseVertexIndex） */
+  mu_Rect clip;          /* シザー矩形 */
+} mu_DrawRange;
+
+typedef struct {
+  mu_DrawVertex *vertices;
+  int vertex_count, vertex_capacity;
+  void *indices;         /* index_sizeが2ならunsigned short、4ならunsigned */
+  int index_count, index_capacity;
+  int index_size;
+  mu_DrawRange *ranges;
+  int range_count, range_capacity;
+  mu_Rect clip;          /* 現在のクリップ矩形 */
+  int high_water;        /* 前フレームまでの最大頂点数 */
+  int max_vertices;      /* 1つの範囲から参照できる頂点数（MaxVertexIndex+1、0なら制限なし） */
+  int base_vertex;       /* 現在の範囲の先頭頂点 */
+  int failed;            /* メモリ確保に失敗した場合1（以降のquadは捨てる） */
+} mu_DrawList;
+
+/**
+ * @brief 描画リストの初期化
+ * 最初のフレームで使う頂点数の目安を指定して初期化します。
+ * 使い方: mu_draw_list_init(&list, MAX_VERTICES);
+ * @param list 描画リスト
+ * @param initial_vertices 最初に確保する頂点数
+ * @return なし
+ */
+void mu_draw_list_init(mu_DrawList *list, int initial_vertices);
+
+/**
+ * @brief 描画リストの解放
+ * 確保したバッファを全て解放します。
+ * 使い方: mu_draw_list_free(&list);
+ * @param list 描画リスト
+ * @return なし
+ */
+void mu_draw_list_free(mu_DrawList *list);
+
+/**
+ * @brief フレームの開始
+ * 内容を空にし、前フレームの最大頂点数に合わせてバッファを確保し直します。
+ * 使い方: mu_draw_list_begin(&list);
+ * @param list 描画リスト
+ * @return なし
+ */
+void mu_draw_list_begin(mu_DrawList *list);
+
+/**
+ * @brief フレームの終了
+ * 最大頂点数を更新し、空の範囲を取り除きます。
+ * 使い方: mu_draw_list_end(&list);
+ * @param list 描画リスト
+ * @return なし
+ */
+void mu_draw_list_end(mu_DrawList *list);
+
+/**
+ * @brief クリップ矩形の設定
+ * 以降の四角形に使うクリップ矩形を記録します。すぐには描画しません。
+ * 使い方: mu_draw_list_set_clip(&list, rect);
+ * @param list 描画リスト
+ * @param clip クリップ矩形
+ * @return なし
+ */
+void mu_draw_list_set_clip(mu_DrawList *list, mu_Rect clip);
+
+/**
+ * @brief 四角形の追加
+ * 頂点4つとインデックス6つを追加します。容量が足りなければバッファを拡張します。
+ * 使い方: mu_draw_list_quad(&list, dst, u0, v0, u1, v1, color);
+ * @param list 描画リスト
+ * @param dst 描画先の矩形
+ * @param u0 左上のU
+ * @param v0 左上のV
+ * @param u1 右下のU
+ * @param v1 右下のV
+ * @param color 頂点カラー（D3DCOLOR形式）
+ * @return なし
+ */
+void mu_draw_list_quad(mu_DrawList *list, mu_Rect dst,
+  float u0, float v0, float u1, float v1, unsigned color);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
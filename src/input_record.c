@@ -0,0 +1,270 @@
+﻿/**
+ * 入力の記録・再生モジュール (microui用)
+ * 詳細はinput_record.hを参照してください。
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include <string.h>
+#include "input_record.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define FRAME_TAG 0
+#define MAX_TEXT  4096   /* 1回のmu_input_textで再生できる長さ */
+
+
+/**
+ * @brief 現在時刻（内部関数）
+ * @return double 単調増加する時刻（秒）
+ */
+static double record_now(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if (!freq.QuadPart) { QueryPerformanceFrequency(&freq); }
+  QueryPerformanceCounter(&t);
+  return (double) t.QuadPart / (double) freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+
+/*============================================================================
+** hash
+**============================================================================*/
+
+/* FNV-1a。整数は下位バイトから入れるので、エンディアンによらず同じ値になる */
+static unsigned hash_int(unsigned h, int v) {
+  int i;
+  for (i = 0; i < 4; i++) { h = (h ^ ((unsigned) v >> (i * 8) & 0xff)) * 16777619u; }
+  return h;
+}
+
+static unsigned hash_rect(unsigned h, mu_Rect r) {
+  return hash_int(hash_int(hash_int(hash_int(h, r.x), r.y), r.w), r.h);
+}
+
+static unsigned hash_color(unsigned h, mu_Color c) {
+  return hash_int(h, c.r | c.g << 8 | c.b << 16 | c.a << 24);
+}
+
+
+unsigned mu_command_hash(mu_Context *ctx) {
+  unsigned h = 2166136261u;
+  const char *p;
+  mu_Command *cmd = NULL;
+  while (mu_next_command(ctx, &cmd)) {
+    h = hash_int(h, cmd->type);
+    switch (cmd->type) {
+      case MU_COMMAND_CLIP: h = hash_rect(h, cmd->clip.rect); break;
+      case MU_COMMAND_RECT: h = hash_color(hash_rect(h, cmd->rect.rect), cmd->rect.color); break;
+      case MU_COMMAND_ICON:
+        h = hash_color(hash_int(hash_rect(h, cmd->icon.rect), cmd->icon.id), cmd->icon.color);
+        break;
+      case MU_COMMAND_TEXT:
+        h = hash_color(hash_int(hash_int(h, cmd->text.pos.x), cmd->text.pos.y), cmd->text.color);
+        for (p = cmd->text.str; *p; p++) { h = (h ^ (unsigned char) *p) * 16777619u; }
+        break;
+    }
+  }
+  return h;
+}
+
+
+/*============================================================================
+** record
+**============================================================================*/
+
+static void write_uint(FILE *fp, unsigned v) {
+  while (v >= 0x80) {
+    fputc((int) (v & 0x7f) | 0x80, fp);
+    v >>= 7;
+  }
+  fputc((int) v, fp);
+}
+
+static void write_int(FILE *fp, int v) {
+  write_uint(fp, ((unsigned) v << 1) ^ (unsigned) -(v < 0));
+}
+
+
+/**
+ * @brief 入力の記録（ctx->input_hook）
+ * @param udata 記録（mu_Recorder*）
+ * @param type MU_EVENT_*
+ * @param x マウスX座標・スクロールX量
+ * @param y マウスY座標・スクロールY量
+ * @param code マウスボタン・キー・時刻
+ * @param text 入力文字列（MU_EVENT_TEXTのみ）
+ * @return なし
+ */
+static void record_input(void *udata, int type, int x, int y, int code, const char *text) {
+  mu_Recorder *rec = (mu_Recorder*) udata;
+  int len;
+  fputc(type, rec->fp);
+  switch (type) {
+    case MU_EVENT_MOUSEMOVE:
+    case MU_EVENT_MOUSEDOWN:
+    case MU_EVENT_MOUSEUP:
+      write_int(rec->fp, x - rec->last.x);
+      write_int(rec->fp, y - rec->last.y);
+      rec->last = mu_vec2(x, y);
+      if (type != MU_EVENT_MOUSEMOVE) { write_uint(rec->fp, code); }
+      break;
+    case MU_EVENT_SCROLL:
+      write_int(rec->fp, x);
+      write_int(rec->fp, y);
+      break;
+    case MU_EVENT_KEYDOWN:
+    case MU_EVENT_KEYUP:
+    case MU_EVENT_TIME:
+      write_uint(rec->fp, (unsigned) code);
+      break;
+    case MU_EVENT_TEXT:
+      len = (int) strlen(text);
+      write_uint(rec->fp, len);
+      fwrite(text, 1, len, rec->fp);
+      break;
+  }
+}
+
+
+int mu_record_open(mu_Recorder *rec, mu_Context *ctx, const char *path) {
+  memset(rec, 0, sizeof(*rec));
+  rec->fp = fopen(path, "wb");
+  if (!rec->fp) { return 0; }
+  fwrite("MUIR", 1, 4, rec->fp);
+  fputc(MU_RECORD_VERSION, rec->fp);
+  ctx->input_hook = record_input;
+  ctx->input_udata = rec;
+  return 1;
+}
+
+
+void mu_record_frame(mu_Recorder *rec, mu_Context *ctx) {
+  if (!rec->fp) { return; }
+  fputc(FRAME_TAG, rec->fp);
+  write_uint(rec->fp, mu_command_hash(ctx));
+  rec->frames++;
+}
+
+
+void mu_record_close(mu_Recorder *rec, mu_Context *ctx) {
+  if (ctx->input_udata == rec) {
+    ctx->input_hook = NULL;
+    ctx->input_udata = NULL;
+  }
+  if (rec->fp) { fclose(rec->fp); }
+  rec->fp = NULL;
+}
+
+
+/*============================================================================
+** replay
+**============================================================================*/
+
+static unsigned read_uint(mu_Replay *rep) {
+  unsigned v = 0;
+  int c, shift = 0;
+  do {
+    c = fgetc(rep->fp);
+    if (c == EOF || shift > 28) { rep->error = 1; return 0; }
+    v |= (unsigned) (c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return v;
+}
+
+static int read_int(mu_Replay *rep) {
+  unsigned v = read_uint(rep);
+  return (int) (v >> 1) ^ -(int) (v & 1);
+}
+
+
+int mu_replay_open(mu_Replay *rep, const char *path) {
+  char magic[4];
+  memset(rep, 0, sizeof(*rep));
+  rep->fp = fopen(path, "rb");
+  if (!rep->fp) { return 0; }
+  if (fread(magic, 1, 4, rep->fp) != 4 || memcmp(magic, "MUIR", 4) != 0 ||
+      fgetc(rep->fp) != MU_RECORD_VERSION)
+  {
+    mu_replay_close(rep);
+    return 0;
+  }
+  rep->min = 1e30;
+  return 1;
+}
+
+
+int mu_replay_next(mu_Replay *rep, mu_Context *ctx) {
+  static char text[MAX_TEXT + 1];
+  int type, x, y, len;
+  if (!rep->fp || rep->error) { return 0; }
+  for (;;) {
+    type = fgetc(rep->fp);
+    if (type == EOF) { return 0; }
+    switch (type) {
+      case FRAME_TAG:
+        rep->expected = read_uint(rep);
+        if (rep->error) { return 0; }
+        rep->start = record_now();
+        return 1;
+      case MU_EVENT_MOUSEMOVE:
+      case MU_EVENT_MOUSEDOWN:
+      case MU_EVENT_MOUSEUP:
+        x = rep->last.x += read_int(rep);
+        y = rep->last.y += read_int(rep);
+        if (type == MU_EVENT_MOUSEMOVE) { mu_input_mousemove(ctx, x, y); }
+        else if (type == MU_EVENT_MOUSEDOWN) { mu_input_mousedown(ctx, x, y, read_uint(rep)); }
+        else { mu_input_mouseup(ctx, x, y, read_uint(rep)); }
+        break;
+      case MU_EVENT_SCROLL:
+        x = read_int(rep);
+        y = read_int(rep);
+        mu_input_scroll(ctx, x, y);
+        break;
+      case MU_EVENT_KEYDOWN: mu_input_keydown(ctx, read_uint(rep)); break;
+      case MU_EVENT_KEYUP: mu_input_keyup(ctx, read_uint(rep)); break;
+      case MU_EVENT_TIME: mu_input_time(ctx, read_uint(rep)); break;
+      case MU_EVENT_TEXT:
+        len = read_uint(rep);
+        if (len > MAX_TEXT || (int) fread(text, 1, len, rep->fp) != len) { rep->error = 1; }
+        if (rep->error) { return 0; }
+        text[len] = '\0';
+        mu_input_text(ctx, text);
+        break;
+      default:
+        rep->error = 1;
+        return 0;
+    }
+    if (rep->error) { return 0; }
+  }
+}
+
+
+int mu_replay_check(mu_Replay *rep, mu_Context *ctx) {
+  double t = record_now() - rep->start;
+  rep->frame++;
+  rep->total += t;
+  if (t < rep->min) { rep->min = t; }
+  if (t > rep->max) { rep->max = t; }
+  if (mu_command_hash(ctx) == rep->expected) { return 1; }
+  if (!rep->mismatches) { rep->first_mismatch = rep->frame; }
+  rep->mismatches++;
+  return 0;
+}
+
+
+void mu_replay_close(mu_Replay *rep) {
+  if (rep->fp) { fclose(rep->fp); }
+  rep->fp = NULL;
+}
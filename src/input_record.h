@@ -0,0 +1,151 @@
+/**
+ * 入力の記録・再生モジュール (microui用)
+ * mu_input_*の呼び出しをフレームの区切りと一緒にバイナリファイルへ記録し、
+ * 後から同じ順序・同じフレームで流し直します。UIの処理は入力だけで決まるので、
+ * 同じ記録を別のビルドで再生すれば、同じ操作での処理時間を比較できます。
+ *
+ * 記録側はctx->input_hookで入力を受け取り、mu_endの後に
+ * mu_record_frameでフレームの区切りとコマンド列のハッシュを書き込みます。
+ * 再生側はmu_replay_nextで1フレーム分の入力を与え、mu_end後のmu_replay_checkで
+ * ハッシュを比べて、mu_replay_next〜mu_replay_checkの時間を集計します。
+ * ウィンドウやテスト用のビルド関数があれば、画面なしで再生できます。
+ *
+ * ファイル形式（整数はLEB128の可変長、符号付きはジグザグ符号化）:
+ *   "MUIR" バージョン(1バイト)
+ *   レコードの列（先頭1バイトが種類）
+ *     0 フレームの区切り  ハッシュ
+ *     MU_EVENT_MOUSEMOVE/DOWN/UP  前のマウス位置からのx, yの差（DOWN/UPはボタンも）
+ *     MU_EVENT_SCROLL  x, y
+ *     MU_EVENT_KEYDOWN/UP  キー
+ *     MU_EVENT_TEXT  長さ, 文字列
+ *     MU_EVENT_TIME  時刻
+ *   区切りまでの入力は、次のmu_beginで処理されるフレームのものです。
+ *
+ * 使い方（記録）:
+ *   mu_record_open(&rec, ctx, "session.rec");
+ *   ... mu_input_* → mu_begin → UI → mu_end → mu_record_frame(&rec, ctx) ...
+ *   mu_record_close(&rec, ctx);
+ *
+ * 使い方（再生）:
+ *   mu_replay_open(&rep, "session.rec");
+ *   while (mu_replay_next(&rep, ctx)) {
+ *     mu_begin(ctx); build(ctx); mu_end(ctx);
+ *     mu_replay_check(&rep, ctx);
+ *   }
+ *   printf("%d frames, %d mismatches\n", rep.frame, rep.mismatches);
+ *   mu_replay_close(&rep);
+ */
+#ifndef INPUT_RECORD_H
+#define INPUT_RECORD_H
+
+#include <stdio.h>
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MU_RECORD_VERSION 1
+
+typedef struct {
+  FILE *fp;
+  mu_Vec2 last;          /* 前に記録したマウス位置 */
+  int frames;            /* 記録したフレーム数 */
+} mu_Recorder;
+
+typedef struct {
+  FILE *fp;
+  mu_Vec2 last;          /* 前に再生したマウス位置 */
+  int frame;             /* 再生したフレーム数 */
+  unsigned expected;     /* 今フレームの記録時のハッシュ */
+  int mismatches;        /* ハッシュが一致しなかったフレーム数 */
+  int first_mismatch;    /* 最初に一致しなかったフレーム（1から。なければ0） */
+  int error;             /* ファイルが壊れていれば1 */
+  double start;          /* 今フレームの開始時刻（秒） */
+  double total, min, max; /* フレームの処理時間（秒） */
+} mu_Replay;
+
+/**
+ * @brief コマンド列のハッシュ
+ * mu_next_commandで走査したコマンドの内容から32ビットのハッシュを計算します。
+ * フォントはポインタなので含めません（ビルドや実行ごとに変わるため）。
+ * 使い方: h = mu_command_hash(ctx);
+ * @param ctx MicroUIのコンテキスト（mu_end後）
+ * @return unsigned ハッシュ値
+ */
+unsigned mu_command_hash(mu_Context *ctx);
+
+/**
+ * @brief 記録の開始
+ * ファイルを作成してヘッダーを書き込み、ctx->input_hookを設定します。
+ * 使い方: mu_record_open(&rec, ctx, "session.rec");
+ * @param rec 記録
+ * @param ctx MicroUIのコンテキスト
+ * @param path 出力ファイル名
+ * @return int 成功したら1、ファイルを作成できなければ0
+ */
+int mu_record_open(mu_Recorder *rec, mu_Context *ctx, const char *path);
+
+/**
+ * @brief フレームの区切りを記録
+ * mu_endの後に呼び出し、コマンド列のハッシュを書き込みます。
+ * 使い方: mu_record_frame(&rec, ctx);
+ * @param rec 記録
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_record_frame(mu_Recorder *rec, mu_Context *ctx);
+
+/**
+ * @brief 記録の終了
+ * ctx->input_hookを外してファイルを閉じます。
+ * 使い方: mu_record_close(&rec, ctx);
+ * @param rec 記録
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_record_close(mu_Recorder *rec, mu_Context *ctx);
+
+/**
+ * @brief 再生の開始
+ * ファイルを開き、ヘッダーとバージョンを確認します。
+ * 使い方: mu_replay_open(&rep, "session.rec");
+ * @param rep 再生
+ * @param path 記録ファイル名
+ * @return int 成功したら1、開けないか形式が違えば0
+ */
+int mu_replay_open(mu_Replay *rep, const char *path);
+
+/**
+ * @brief 次のフレームの入力を与える
+ * フレームの区切りまでのレコードをmu_input_*で流し、時間の計測を始めます。
+ * 使い方: while (mu_replay_next(&rep, ctx)) { ... }
+ * @param rep 再生
+ * @param ctx MicroUIのコンテキスト
+ * @return int フレームがあれば1、終わり（または壊れている）なら0
+ */
+int mu_replay_next(mu_Replay *rep, mu_Context *ctx);
+
+/**
+ * @brief フレームの確認
+ * mu_endの後に呼び出し、処理時間を集計してハッシュを記録時と比べます。
+ * 使い方: if (!mu_replay_check(&rep, ctx)) { ... }
+ * @param rep 再生
+ * @param ctx MicroUIのコンテキスト
+ * @return int 一致すれば1、一致しなければ0
+ */
+int mu_replay_check(mu_Replay *rep, mu_Context *ctx);
+
+/**
+ * @brief 再生の終了
+ * 使い方: mu_replay_close(&rep);
+ * @param rep 再生
+ * @return なし
+ */
+void mu_replay_close(mu_Replay *rep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
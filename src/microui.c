@@ -2,9 +2,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include "microui.h"
+#include "profile.h"
 
 #define unused(x) ((void) (x))
 
+#if defined(_MSC_VER)
+  typedef __int64 mu_int64;
+#else
+  typedef long long mu_int64;
+#endif
+
 #define expect(x) do {                                               \
     if (!(x)) {                                                      \
       fprintf(stderr, "Fatal error: %s:%d: assertion '%s' failed\n", \
@@ -24,6 +31,21 @@
     (stk).idx--;           \
   } while (0)
 
+/* トレースフックの呼び出し（未設定なら何もしない） */
+#define trace_event(ctx, name, begin) do {                     \
+    if ((ctx)->trace) { (ctx)->trace((ctx)->trace_udata, (name), (begin)); } \
+  } while (0)
+
+/* 入力フックの呼び出し（未設定なら何もしない） */
+#define input_hook(ctx, type, x, y, code, text) do {                                   \
+    if ((ctx)->input_hook) { (ctx)->input_hook((ctx)->input_udata, (type), (x), (y), (code), (text)); } \
+  } while (0)
+
+/* スタックの深さの最大値を統計に記録する */
+#define track_depth(max, stk) do {          \
+    if ((stk).idx > (max)) { (max) = (stk).idx; } \
+  } while (0)
+
 
 static mu_Rect unclipped_rect = { 0, 0, 0x1000000, 0x1000000 };
 
@@ -53,6 +75,22 @@ static mu_Style default_style = {
 };
 
 
+/**
+ * @brief テキスト幅の取得（内部関数）
+ * text_widthコールバックを呼び出し、呼び出し回数を統計に数えます。
+ * 使い方: w = text_width(ctx, font, str, -1);
+ * @param ctx MicroUIのコンテキスト
+ * @param font フォント
+ * @param str 文字列
+ * @param len 長さ（-1なら終端まで）
+ * @return int 幅（ピクセル）
+ */
+static int text_width(mu_Context *ctx, mu_Font font, const char *str, int len) {
+  ctx->stats.text_width_calls++;
+  return ctx->text_width(font, str, len);
+}
+
+
 /**
  * @brief 2次元ベクトル生成
  * x, y座標からmu_Vec2型を生成します。
@@ -144,6 +182,19 @@ static int rect_overlaps_vec2(mu_Rect r, mu_Vec2 p) {
   return p.x >= r.x && p.x < r.x + r.w && p.y >= r.y && p.y < r.y + r.h;
 }
 
+/**
+ * @brief 矩形の包含判定
+ * 矩形rが矩形outerに完全に含まれるか判定します。
+ * 使い方: rect_contains(outer, r);
+ * @param outer 外側の矩形
+ * @param r 判定する矩形
+ * @return int 完全に含まれていれば1、そうでなければ0
+ */
+static int rect_contains(mu_Rect outer, mu_Rect r) {
+  return r.x >= outer.x && r.x + r.w <= outer.x + outer.w &&
+         r.y >= outer.y && r.y + r.h <= outer.y + outer.h;
+}
+
 /**
  * @brief フレーム描画
  * 指定した矩形領域にフレーム（枠線）を描画します。
@@ -177,8 +228,83 @@ void mu_init(mu_Context *ctx) {
   ctx->draw_frame = draw_frame;
   ctx->_style = default_style;
   ctx->style = &ctx->_style;
+  ctx->command_list.items = ctx->command_storage;
+  ctx->text_pool.items = ctx->text_storage;
+  ctx->text_pool_generation = 1;
+}
+
+/**
+ * @brief 入力イベント1つの反映（内部関数）
+ * 同じフレームの状態を上書きしてしまうイベント（押したボタン・キーをもう1度押す、
+ * 押した後に別の位置へ動く、input_textに入りきらないテキスト）なら反映せずに0を返します。
+ * @param ctx MicroUIのコンテキスト
+ * @param e イベント
+ * @param pressed このフレームでマウスボタンが押されていれば1（押したら1にする）
+ * @return int 反映したら1
+ */
+static int apply_event(mu_Context *ctx, const mu_InputEvent *e, int *pressed) {
+  int i, len;
+  switch (e->type) {
+    case MU_EVENT_MOUSEMOVE:
+    case MU_EVENT_MOUSEUP:
+      if (*pressed && (e->x != ctx->mouse_pos.x || e->y != ctx->mouse_pos.y)) { return 0; }
+      ctx->mouse_pos = mu_vec2(e->x, e->y);
+      if (e->type == MU_EVENT_MOUSEUP) { ctx->mouse_down &= ~e->code; }
+      break;
+    case MU_EVENT_MOUSEDOWN:
+      if (ctx->mouse_pressed & e->code) { return 0; }
+      ctx->mouse_pos = mu_vec2(e->x, e->y);
+      ctx->mouse_down |= e->code;
+      ctx->mouse_pressed |= e->code;
+      ctx->mouse_pressed_time = e->time;
+      *pressed = 1;
+      break;
+    case MU_EVENT_SCROLL:
+      ctx->scroll_delta.x += e->x;
+      ctx->scroll_delta.y += e->y;
+      break;
+    case MU_EVENT_KEYDOWN:
+      if (ctx->key_pressed & e->code) { return 0; }
+      ctx->key_pressed |= e->code;
+      ctx->key_down |= e->code;
+      break;
+    case MU_EVENT_KEYUP:
+      ctx->key_down &= ~e->code;
+      break;
+    case MU_EVENT_TEXT:
+      len = strlen(ctx->input_text);
+      if (len + e->len >= (int) sizeof(ctx->input_text)) { return 0; }
+      for (i = 0; i < e->len; i++) {
+        ctx->input_text[len + i] = ctx->input_queue.text[(e->text + i) % MU_INPUTTEXT_SIZE];
+      }
+      ctx->input_text[len + e->len] = '\0';
+      ctx->input_queue.text_head = (ctx->input_queue.text_head + e->len) % MU_INPUTTEXT_SIZE;
+      ctx->input_queue.text_count -= e->len;
+      break;
+  }
+  ctx->last_event_time = e->time;
+  return 1;
+}
+
+
+/**
+ * @brief 入力イベントの反映（内部関数）
+ * キューのイベントを順に状態へ反映し、反映できないイベントに来たら残りを次のフレームに回します。
+ * これにより、押した位置とクリック・キー入力・テキストは1つも失われません。
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+static void consume_input(mu_Context *ctx) {
+  int pressed = 0;
+  while (ctx->input_queue.count > 0 &&
+         apply_event(ctx, &ctx->input_queue.items[ctx->input_queue.head], &pressed))
+  {
+    ctx->input_queue.head = (ctx->input_queue.head + 1) % MU_INPUTQUEUE_SIZE;
+    ctx->input_queue.count--;
+  }
 }
 
+
 /**
  * @brief フレーム開始処理
  * UIフレームの処理を開始します。
@@ -188,7 +314,12 @@ void mu_init(mu_Context *ctx) {
  */
 void mu_begin(mu_Context *ctx) {
   expect(ctx->text_width && ctx->text_height);
-  ctx->command_list.idx = 0;
+  trace_event(ctx, "frame", 1);
+  mu_profile_frame();
+  mu_profile_begin("input");
+  consume_input(ctx);
+  mu_profile_end();
+  mu_clear_commands(ctx);
   ctx->root_list.idx = 0;
   ctx->scroll_target = NULL;
   ctx->hover_root = ctx->next_hover_root;
@@ -196,6 +327,9 @@ void mu_begin(mu_Context *ctx) {
   ctx->mouse_delta.x = ctx->mouse_pos.x - ctx->last_mouse_pos.x;
   ctx->mouse_delta.y = ctx->mouse_pos.y - ctx->last_mouse_pos.y;
   ctx->frame++;
+  memset(&ctx->stats, 0, sizeof(ctx->stats));
+  ctx->stats.input_dropped = ctx->input_queue.dropped;
+  ctx->input_queue.dropped = 0;
 }
 
 
@@ -211,6 +345,218 @@ static int compare_zindex(const void *a, const void *b) {
   return (*(mu_Container**) a)->zindex - (*(mu_Container**) b)->zindex;
 }
 
+
+/**
+ * @brief 遮蔽判定（内部関数）
+ * 矩形が上位コンテナの不透明矩形のいずれかに完全に覆われているか判定します。
+ * 使い方: is_occluded(occ, nocc, rect);
+ * @param occ 不透明矩形の配列
+ * @param nocc 不透明矩形の数
+ * @param r 判定する矩形
+ * @return int 覆われていれば1、そうでなければ0
+ */
+static int is_occluded(const mu_Rect *occ, int nocc, mu_Rect r) {
+  int i;
+  for (i = 0; i < nocc; i++) {
+    if (rect_contains(occ[i], r)) { return 1; }
+  }
+  return 0;
+}
+
+
+#ifdef MU_COMPACT_COMMANDS
+/* 符号化したコマンドの先頭バイト（種類）。RAWは後に構造体がそのまま続く */
+#define COMPACT_RAW    0x40
+#define COMPACT_CULLED 0x80   /* mu_endの遮蔽カリングで隠れたコマンド */
+#define decode_scratch(ctx) (&(ctx)->command_decoded)
+#else
+#define decode_scratch(ctx) NULL
+#endif
+
+
+/**
+ * @brief コマンドを読み飛ばす印を付ける（内部関数）
+ * 構造体のコマンドは次のコマンドへのJUMPに書き換え、符号化したコマンドは
+ * 先頭バイトに隠れた印を付けます。
+ * @param cmd mu_read_commandが返したコマンド
+ * @param at コマンドの位置
+ * @param next 次のコマンドの位置
+ * @return なし
+ */
+static void skip_command(mu_Command *cmd, char *at, char *next) {
+#ifdef MU_COMPACT_COMMANDS
+  if ((unsigned char) *at != COMPACT_RAW) {
+    *at = (char) ((unsigned char) *at | COMPACT_CULLED);
+    return;
+  }
+#else
+  (void) at;
+#endif
+  cmd->type = MU_COMMAND_JUMP;
+  cmd->jump.dst = next;
+}
+
+
+/**
+ * @brief コンテナ内の遮蔽コマンド除去（内部関数）
+ * ルートコンテナのコマンド範囲を走査し、上位の不透明矩形に完全に覆われた
+ * RECT/TEXT/ICONコマンドを次のコマンドへのJUMPに書き換えます。
+ * それ以外の種類（アプリ独自のコマンド）は除去せず、見えるものとして扱います。
+ * 入れ子のルートコンテナの範囲はheadのJUMPで読み飛ばします。
+ * 使い方: cull_container(ctx, cnt, occ, nocc);
+ * @param ctx MicroUIのコンテキスト
+ * @param cnt 対象のルートコンテナ
+ * @param occ 上位コンテナの不透明矩形の配列
+ * @param nocc 不透明矩形の数
+ * @return int 描画コマンドが1つでも残っていれば1、全て隠れていれば0
+ */
+static int cull_container(mu_Context *ctx, mu_Container *cnt,
+  const mu_Rect *occ, int nocc)
+{
+  char *pos = (char*) cnt->head + sizeof(mu_JumpCommand);
+  int visible = 0;
+  for (;;) {
+    char *at = pos;
+    mu_Command *cmd = mu_read_command(ctx, &pos, decode_scratch(ctx));
+    mu_Rect r;
+    if (cmd == cnt->tail) { break; }
+    switch (cmd->type) {
+      case MU_COMMAND_JUMP: pos = cmd->jump.dst; continue;
+      case MU_COMMAND_RECT: r = cmd->rect.rect; break;
+      case MU_COMMAND_ICON: r = cmd->icon.rect; break;
+      case MU_COMMAND_TEXT:
+        /* 幅の計算は高価なので、先に左上・左下が隠れているかだけ確認する */
+        r = mu_rect(cmd->text.pos.x, cmd->text.pos.y,
+          1, ctx->text_height(cmd->text.font));
+        if (is_occluded(occ, nocc, r)) {
+          r.w = text_width(ctx, cmd->text.font, cmd->text.str, cmd->text.len);
+          /* グリフは公称の矩形から少しはみ出すことがあるため余白を持たせる */
+          r = expand_rect(r, ctx->style->padding);
+        }
+        break;
+      case MU_COMMAND_CLIP: continue;
+      default:
+        /* アプリ独自のコマンドは範囲が分からないので、常に見えるものとして残す */
+        visible = 1;
+        continue;
+    }
+    if (is_occluded(occ, nocc, r)) {
+      skip_command(cmd, at, pos);
+    } else {
+      visible = 1;
+    }
+  }
+  return visible;
+}
+
+
+/**
+ * @brief 遮蔽カリング（内部関数）
+ * zindex順にソート済みのルートコンテナを手前から走査し、より手前にある
+ * ウィンドウの不透明な本体に完全に隠れたコマンドを除去します。
+ * 全てのコマンドが隠れたコンテナはculledに1を設定し、JUMPの連結から外します。
+ * 使い方: cull_occluded(ctx, culled);
+ * @param ctx MicroUIのコンテキスト
+ * @param culled コンテナごとの除去フラグ（root_listと同じ並び）
+ * @return なし
+ */
+static void cull_occluded(mu_Context *ctx, char *culled) {
+  mu_Rect occ[MU_ROOTLIST_SIZE];
+  int i, nocc = 0;
+  for (i = ctx->root_list.idx - 1; i >= 0; i--) {
+    mu_Container *cnt = ctx->root_list.items[i];
+    culled[i] = nocc > 0 && !cull_container(ctx, cnt, occ, nocc);
+    if (!culled[i] && cnt->opaque.w > 0 && cnt->opaque.h > 0) {
+      occ[nocc++] = cnt->opaque;
+    }
+  }
+}
+
+
+/* IDで引く表の大きさ（記録できる数の2倍なので必ず空きがある） */
+#define HIT_ID_SLOTS (MU_HITLIST_SIZE * 2)
+
+/**
+ * @brief ヒットテスト用グリッドの作成（内部関数）
+ * 今フレームに記録したコントロールをコピーし、全体を囲む矩形をMU_HITGRID_SIZE四方の
+ * セルに分けて、各セルに重なるコントロールの番号を並べます（数え上げてから詰めるので
+ * コントロール数に比例した時間で済みます）。zindexはウィンドウの並べ替えが済んだ後の値を使います。
+ * mu_hit_kind用に、IDから番号を引く表（線形探索のハッシュ表）も作ります。
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+static void build_hit_grid(mu_Context *ctx) {
+  int i, x, y, total, cells;
+  int next[MU_HITGRID_SIZE * MU_HITGRID_SIZE];
+  mu_Rect b;
+  int n = ctx->hit_count;
+
+  ctx->hit_grid.count = n;
+  memset(ctx->hit_grid.by_id, 0, sizeof(ctx->hit_grid.by_id));
+  if (n == 0) { ctx->hit_grid.size = 0; return; }
+  memcpy(ctx->hit_grid.items, ctx->hit_items, n * sizeof(mu_HitItem));
+
+  /* IDの表（同じIDが複数あれば先に記録したものを残す） */
+  for (i = 0; i < n; i++) {
+    mu_Id id = ctx->hit_items[i].id;
+    int k = id % HIT_ID_SLOTS;
+    while (ctx->hit_grid.by_id[k] && ctx->hit_grid.items[ctx->hit_grid.by_id[k] - 1].id != id) {
+      k = (k + 1) % HIT_ID_SLOTS;
+    }
+    if (!ctx->hit_grid.by_id[k]) { ctx->hit_grid.by_id[k] = (unsigned short) (i + 1); }
+  }
+
+  /* 全体を囲む矩形 */
+  b = ctx->hit_items[0].rect;
+  for (i = 0; i < n; i++) {
+    mu_HitItem *it = &ctx->hit_grid.items[i];
+    int x2 = mu_max(b.x + b.w, it->rect.x + it->rect.w);
+    int y2 = mu_max(b.y + b.h, it->rect.y + it->rect.h);
+    b.x = mu_min(b.x, it->rect.x);
+    b.y = mu_min(b.y, it->rect.y);
+    b.w = x2 - b.x;
+    b.h = y2 - b.y;
+    it->zindex = it->root ? it->root->zindex : 0;
+  }
+  ctx->hit_grid.bounds = b;
+
+  /* セルごとの数を数える（入りきらなければ1セルにする） */
+  for (ctx->hit_grid.size = MU_HITGRID_SIZE;; ctx->hit_grid.size = 1) {
+    int size = ctx->hit_grid.size;
+    ctx->hit_grid.cell_w = mu_max((b.w + size - 1) / size, 1);
+    ctx->hit_grid.cell_h = mu_max((b.h + size - 1) / size, 1);
+    cells = size * size;
+    memset(ctx->hit_grid.start, 0, (cells + 1) * sizeof(int));
+    total = 0;
+    for (i = 0; i < n; i++) {
+      mu_Rect r = ctx->hit_grid.items[i].rect;
+      int x0 = (r.x - b.x) / ctx->hit_grid.cell_w, x1 = (r.x + r.w - 1 - b.x) / ctx->hit_grid.cell_w;
+      int y0 = (r.y - b.y) / ctx->hit_grid.cell_h, y1 = (r.y + r.h - 1 - b.y) / ctx->hit_grid.cell_h;
+      for (y = y0; y <= y1; y++) {
+        for (x = x0; x <= x1; x++) { ctx->hit_grid.start[y * size + x + 1]++; }
+      }
+      total += (x1 - x0 + 1) * (y1 - y0 + 1);
+    }
+    if (total <= (int) (sizeof(ctx->hit_grid.entries) / sizeof(ctx->hit_grid.entries[0]))) { break; }
+  }
+
+  /* 先頭位置に変換して番号を詰める（記録順を保つ） */
+  for (i = 0; i < cells; i++) {
+    ctx->hit_grid.start[i + 1] += ctx->hit_grid.start[i];
+    next[i] = ctx->hit_grid.start[i];
+  }
+  for (i = 0; i < n; i++) {
+    int size = ctx->hit_grid.size;
+    mu_Rect r = ctx->hit_grid.items[i].rect;
+    int x0 = (r.x - b.x) / ctx->hit_grid.cell_w, x1 = (r.x + r.w - 1 - b.x) / ctx->hit_grid.cell_w;
+    int y0 = (r.y - b.y) / ctx->hit_grid.cell_h, y1 = (r.y + r.h - 1 - b.y) / ctx->hit_grid.cell_h;
+    for (y = y0; y <= y1; y++) {
+      for (x = x0; x <= x1; x++) { ctx->hit_grid.entries[next[y * size + x]++] = i; }
+    }
+  }
+}
+
+
 /**
  * @brief フレーム終了処理
  * UIフレームの処理を終了し、入力・状態をリセットします。
@@ -220,11 +566,16 @@ static int compare_zindex(const void *a, const void *b) {
  */
 void mu_end(mu_Context *ctx) {
   int i, n;
+  char culled[MU_ROOTLIST_SIZE];
+  mu_Container *prev = NULL;
+  trace_event(ctx, "mu_end", 1);
   /* スタックのチェック */
+  expect(!ctx->measuring);
   expect(ctx->container_stack.idx == 0);
   expect(ctx->clip_stack.idx      == 0);
   expect(ctx->id_stack.idx        == 0);
   expect(ctx->layout_stack.idx    == 0);
+  mu_commit_commands(ctx);
 
   /* スクロール入力の処理 */
   if (ctx->scroll_target) {
@@ -252,26 +603,145 @@ void mu_end(mu_Context *ctx) {
   ctx->last_mouse_pos = ctx->mouse_pos;
 
   /* ルートコンテナをzindexでソート */
+  mu_profile_begin("sort");
   n = ctx->root_list.idx;
   qsort(ctx->root_list.items, n, sizeof(mu_Container*), compare_zindex);
+  mu_profile_end();
+
+  /* 手前のウィンドウに完全に隠れたコマンド・コンテナを除去 */
+  mu_profile_begin("cull");
+  cull_occluded(ctx, culled);
+  mu_profile_end();
 
-  /* ルートコンテナのジャンプコマンド設定 */
+  /* 次のフレームのヒットテスト用に、今フレームのコントロールを索引にする */
+  mu_profile_begin("hit grid");
+  build_hit_grid(ctx);
+  ctx->hit_count = 0;
+  mu_profile_end();
+
+  /* ルートコンテナのジャンプコマンド設定（除去されたコンテナは飛ばす） */
+  mu_profile_begin("jumps");
   for (i = 0; i < n; i++) {
     mu_Container *cnt = ctx->root_list.items[i];
+    if (culled[i]) { continue; }
     /* 最初のコンテナなら最初のコマンドをジャンプ先にする。
     ** それ以外は前のコンテナのtailをジャンプ先にする */
-    if (i == 0) {
-      mu_Command *cmd = (mu_Command*) ctx->command_list.items;
+    if (!prev) {
+      char *pos = ctx->command_list.items;
+      mu_Command *cmd = mu_read_command(ctx, &pos, decode_scratch(ctx));
       cmd->jump.dst = (char*) cnt->head + sizeof(mu_JumpCommand);
     } else {
-      mu_Container *prev = ctx->root_list.items[i - 1];
       prev->tail->jump.dst = (char*) cnt->head + sizeof(mu_JumpCommand);
     }
-    /* 最後のコンテナのtailはコマンドリストの末尾にジャンプ */
-    if (i == n - 1) {
-      cnt->tail->jump.dst = ctx->command_list.items + ctx->command_list.idx;
-    }
+    prev = cnt;
+  }
+  /* 最後のコンテナのtailはコマンドリストの末尾にジャンプ */
+  if (prev) {
+    prev->tail->jump.dst = ctx->command_list.items + ctx->command_list.idx;
+  }
+  mu_profile_end();
+  ctx->stats.command_bytes = ctx->command_list.idx;
+  ctx->stats.text_bytes = ctx->text_pool.idx;
+  trace_event(ctx, NULL, 0);  /* mu_end */
+  trace_event(ctx, NULL, 0);  /* frame */
+}
+
+
+/**
+ * @brief 計測パスの開始
+ * 入力を一時的に無効にして、ボタンの押下やドラッグが2回処理されないようにします。
+ * 使い方: mu_begin_measure(ctx);
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_begin_measure(mu_Context *ctx) {
+  expect(!ctx->measuring && ctx->container_stack.idx == 0);
+  ctx->measure_saved.command_idx = ctx->command_list.idx;
+  ctx->measure_saved.root_idx = ctx->root_list.idx;
+  ctx->measure_saved.mouse_down = ctx->mouse_down;
+  ctx->measure_saved.mouse_pressed = ctx->mouse_pressed;
+  ctx->measure_saved.key_pressed = ctx->key_pressed;
+  ctx->measure_saved.mouse_delta = ctx->mouse_delta;
+  memcpy(ctx->measure_saved.input_text, ctx->input_text, sizeof(ctx->input_text));
+  ctx->measure_saved.next_hover_root = ctx->next_hover_root;
+  ctx->measure_saved.scroll_target = ctx->scroll_target;
+  ctx->mouse_down = 0;
+  ctx->mouse_pressed = 0;
+  ctx->key_pressed = 0;
+  ctx->mouse_delta = mu_vec2(0, 0);
+  ctx->input_text[0] = '\0';
+  ctx->measuring = 1;
+}
+
+
+/**
+ * @brief 計測パスの終了
+ * 使い方: mu_end_measure(ctx);
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_end_measure(mu_Context *ctx) {
+  expect(ctx->measuring && ctx->container_stack.idx == 0);
+  ctx->command_list.idx = ctx->measure_saved.command_idx;
+  ctx->root_list.idx = ctx->measure_saved.root_idx;
+  ctx->mouse_down = ctx->measure_saved.mouse_down;
+  ctx->mouse_pressed = ctx->measure_saved.mouse_pressed;
+  ctx->key_pressed = ctx->measure_saved.key_pressed;
+  ctx->mouse_delta = ctx->measure_saved.mouse_delta;
+  memcpy(ctx->input_text, ctx->measure_saved.input_text, sizeof(ctx->input_text));
+  ctx->next_hover_root = ctx->measure_saved.next_hover_root;
+  ctx->scroll_target = ctx->measure_saved.scroll_target;
+  ctx->measuring = 0;
+}
+
+
+/**
+ * @brief 指定位置のコントロールを取得
+ * 位置を含むセルのコントロールだけを調べ、zindexが最も大きいもの
+ * （同じなら後に記録したもの）を探します。ウィンドウはコントロールより先に記録されるので、
+ * 自分のコントロールは隠さず、下のウィンドウのコントロールだけを隠します。
+ * 使い方: id = mu_hit_test(ctx, x, y, MU_HIT_ANY);
+ * @param ctx MicroUIのコンテキスト
+ * @param x 画面上のx
+ * @param y 画面上のy
+ * @param kind 探すコントロールの種類（MU_HIT_ANYなら全て）
+ * @return mu_Id 見つかったコントロールのID（なければ0）
+ */
+mu_Id mu_hit_test(mu_Context *ctx, int x, int y, int kind) {
+  mu_HitItem *best = NULL;
+  mu_Rect b = ctx->hit_grid.bounds;
+  mu_Vec2 p = mu_vec2(x, y);
+  int i, c, cx, cy;
+  if (ctx->hit_grid.size == 0 || !rect_overlaps_vec2(b, p)) { return 0; }
+  cx = mu_min((x - b.x) / ctx->hit_grid.cell_w, ctx->hit_grid.size - 1);
+  cy = mu_min((y - b.y) / ctx->hit_grid.cell_h, ctx->hit_grid.size - 1);
+  c = cy * ctx->hit_grid.size + cx;
+  for (i = ctx->hit_grid.start[c]; i < ctx->hit_grid.start[c + 1]; i++) {
+    mu_HitItem *it = &ctx->hit_grid.items[ctx->hit_grid.entries[i]];
+    if (!rect_overlaps_vec2(it->rect, p)) { continue; }
+    if (!best || it->zindex >= best->zindex) { best = it; }
+  }
+  if (!best || (kind && best->kind != kind)) { return 0; }
+  return best->id;
+}
+
+
+/**
+ * @brief コントロールの種類を取得
+ * 使い方: kind = mu_hit_kind(ctx, ctx->focus);
+ * @param ctx MicroUIのコンテキスト
+ * @param id コントロールID
+ * @return int MU_HIT_*（記録されていなければMU_HIT_ANY）
+ */
+int mu_hit_kind(mu_Context *ctx, mu_Id id) {
+  int k = id % HIT_ID_SLOTS;
+  /* 表は記録数の2倍あるので、空きに当たるまでの探索は短い */
+  while (ctx->hit_grid.by_id[k]) {
+    mu_HitItem *it = &ctx->hit_grid.items[ctx->hit_grid.by_id[k] - 1];
+    if (it->id == id) { return it->kind; }
+    k = (k + 1) % HIT_ID_SLOTS;
   }
+  return MU_HIT_ANY;
 }
 
 
@@ -289,16 +759,136 @@ void mu_set_focus(mu_Context *ctx, mu_Id id) {
 }
 
 
-/* 32bit fnv-1a hash */
-#define HASH_INITIAL 2166136261
+/* IDのハッシュ（murmur3の32ビット版と同じ混ぜ方で、4バイトずつ処理する）。
+** 親のIDを初期値にするので、同じIDスタックと同じデータからは毎フレーム同じIDになる */
+#define HASH_INITIAL 2166136261u
+
+static unsigned rotl32(unsigned x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+static unsigned hash_mix(unsigned k) {
+  return rotl32(k * 0xcc9e2d51u, 15) * 0x1b873593u;
+}
+
+static mu_Id hash_word(mu_Id h, unsigned k) {
+  return rotl32(h ^ hash_mix(k), 13) * 5 + 0xe6546b64u;
+}
+
+static mu_Id hash_final(mu_Id h, int size) {
+  h ^= (unsigned) size;
+  h = (h ^ (h >> 16)) * 0x85ebca6bu;
+  h = (h ^ (h >> 13)) * 0xc2b2ae35u;
+  return h ^ (h >> 16);
+}
+
+static mu_Id hash(mu_Id h, const void *data, int size) {
+  const unsigned char *p = data;
+  unsigned k;
+  int n = size;
+  for (; n >= 4; n -= 4, p += 4) {
+    memcpy(&k, p, 4);
+    h = hash_word(h, k);
+  }
+  /* 残りの1〜3バイト */
+  k = 0;
+  switch (n) {
+    case 3: k ^= (unsigned) p[2] << 16; /* fall through */
+    case 2: k ^= (unsigned) p[1] << 8;  /* fall through */
+    case 1: k ^= p[0]; h ^= hash_mix(k);
+  }
+  return hash_final(h, size);
+}
+
+/* hash(h, &ptr, sizeof(ptr))と同じ値（ポインタは4か8バイト） */
+static mu_Id hash_ptr(mu_Id h, const void *ptr) {
+  unsigned k[sizeof(ptr) / 4];
+  int i;
+  memcpy(k, &ptr, sizeof(ptr));
+  for (i = 0; i < (int) (sizeof(ptr) / 4); i++) { h = hash_word(h, k[i]); }
+  return hash_final(h, sizeof(ptr));
+}
+
+
+#ifdef MU_CHECK_IDS
+
+/**
+ * @brief 衝突検出の表の項目（内部関数）
+ * 今フレームにまだ無ければ空の項目を作る（freshを1にする）。
+ * @return int 項目の位置、表が混んでいれば-1（検出しない）
+ */
+static int id_check_slot(mu_Context *ctx, mu_Id id, int *fresh) {
+  int i;
+  for (i = 0; i < 16; i++) {
+    int n = (id + i) & (MU_IDCHECK_SIZE - 1);
+    if (ctx->id_check[n].frame != ctx->frame) {
+      ctx->id_check[n].id = id;
+      ctx->id_check[n].frame = ctx->frame;
+      ctx->id_check[n].control_frame = 0;
+      *fresh = 1;
+      return n;
+    }
+    if (ctx->id_check[n].id == id) { *fresh = 0; return n; }
+  }
+  return -1;
+}
+
+/* 衝突の報告（データが短い文字列ならラベルとして表示する） */
+static void report_id(mu_Context *ctx, mu_Id id, const char *what, const void *data, int size) {
+  const unsigned char *p = data;
+  int i, text = data && size > 0 && size < 64;
+  for (i = 0; text && i < size; i++) { text = p[i] >= 0x20 && p[i] < 0x7f; }
+  ctx->stats.id_collisions++;
+  if (text) {
+    fprintf(stderr, "microui: frame %d: id %08x %s (\"%.*s\")\n", ctx->frame, id, what, size, (const char*) data);
+  } else {
+    fprintf(stderr, "microui: frame %d: id %08x %s\n", ctx->frame, id, what);
+  }
+}
 
-static void hash(mu_Id *hash, const void *data, int size) {
+/**
+ * @brief ハッシュの衝突の検出（内部関数）
+ * IDとは別の計算（FNV-1a）で親のIDとデータのハッシュを求め、
+ * 同じIDを違うデータから作っていれば報告する。
+ */
+static void check_id(mu_Context *ctx, mu_Id id, mu_Id seed, const void *data, int size) {
   const unsigned char *p = data;
-  while (size--) {
-    *hash = (*hash ^ *p++) * 16777619;
+  unsigned h = 2166136261u;
+  int i, n, fresh;
+  for (i = 0; i < 32; i += 8) { h = (h ^ ((seed >> i) & 0xff)) * 16777619u; }
+  for (i = 0; i < size; i++) { h = (h ^ p[i]) * 16777619u; }
+  n = id_check_slot(ctx, id, &fresh);
+  if (n < 0) { return; }
+  if (fresh) {
+    ctx->id_check[n].check = h;
+  } else if (ctx->id_check[n].check != h) {
+    report_id(ctx, id, "hash collision", data, size);
+  }
+}
+
+/**
+ * @brief 同じIDのコントロールの検出（内部関数）
+ * 1フレームに同じIDでmu_update_controlを2回呼んだら報告する。
+ */
+static void check_control_id(mu_Context *ctx, mu_Id id) {
+  int fresh, n = id_check_slot(ctx, id, &fresh);
+  if (n < 0) { return; }
+  if (ctx->id_check[n].control_frame == ctx->frame) {
+    report_id(ctx, id, "used by two controls", NULL, 0);
   }
+  ctx->id_check[n].control_frame = ctx->frame;
 }
 
+#else
+#define check_id(ctx, id, seed, data, size) ((void) 0)
+#define check_control_id(ctx, id)           ((void) 0)
+#endif
+
+
+/* IDスタックの先頭（空ならハッシュの初期値） */
+#define id_seed(ctx) \
+  ((ctx)->id_stack.idx > 0 ? (ctx)->id_stack.items[(ctx)->id_stack.idx - 1] : HASH_INITIAL)
+
 
 /**
  * @brief ID生成
@@ -310,9 +900,42 @@ static void hash(mu_Id *hash, const void *data, int size) {
  * @return mu_Id 生成されたID
  */
 mu_Id mu_get_id(mu_Context *ctx, const void *data, int size) {
-  int idx = ctx->id_stack.idx;
-  mu_Id res = (idx > 0) ? ctx->id_stack.items[idx - 1] : HASH_INITIAL;
-  hash(&res, data, size);
+  mu_Id seed = id_seed(ctx);
+  mu_Id res = hash(seed, data, size);
+  check_id(ctx, res, seed, data, size);
+  ctx->last_id = res;
+  return res;
+}
+
+
+/**
+ * @brief 整数からのID生成
+ * 4バイトの整数1つ分なので、ループせずにhashと同じ値を求める。
+ * 使い方: id = mu_get_id_int(ctx, i);
+ * @param ctx MicroUIのコンテキスト
+ * @param value ID生成用の整数
+ * @return mu_Id 生成されたID
+ */
+mu_Id mu_get_id_int(mu_Context *ctx, int value) {
+  mu_Id seed = id_seed(ctx);
+  mu_Id res = hash_final(hash_word(seed, (unsigned) value), sizeof(value));
+  check_id(ctx, res, seed, &value, sizeof(value));
+  ctx->last_id = res;
+  return res;
+}
+
+
+/**
+ * @brief ポインタからのID生成
+ * 使い方: id = mu_get_id_ptr(ctx, &value);
+ * @param ctx MicroUIのコンテキスト
+ * @param ptr ID生成用のポインタ
+ * @return mu_Id 生成されたID
+ */
+mu_Id mu_get_id_ptr(mu_Context *ctx, const void *ptr) {
+  mu_Id seed = id_seed(ctx);
+  mu_Id res = hash_ptr(seed, ptr);
+  check_id(ctx, res, seed, &ptr, sizeof(ptr));
   ctx->last_id = res;
   return res;
 }
@@ -329,6 +952,33 @@ mu_Id mu_get_id(mu_Context *ctx, const void *data, int size) {
  */
 void mu_push_id(mu_Context *ctx, const void *data, int size) {
   push(ctx->id_stack, mu_get_id(ctx, data, size));
+  track_depth(ctx->stats.max_id_depth, ctx->id_stack);
+}
+
+
+/**
+ * @brief 整数から作ったIDをIDスタックにプッシュ
+ * 使い方: mu_push_id_int(ctx, i);
+ * @param ctx MicroUIのコンテキスト
+ * @param value ID生成用の整数
+ * @return なし
+ */
+void mu_push_id_int(mu_Context *ctx, int value) {
+  push(ctx->id_stack, mu_get_id_int(ctx, value));
+  track_depth(ctx->stats.max_id_depth, ctx->id_stack);
+}
+
+
+/**
+ * @brief ポインタから作ったIDをIDスタックにプッシュ
+ * 使い方: mu_push_id_ptr(ctx, item);
+ * @param ctx MicroUIのコンテキスト
+ * @param ptr ID生成用のポインタ
+ * @return なし
+ */
+void mu_push_id_ptr(mu_Context *ctx, const void *ptr) {
+  push(ctx->id_stack, mu_get_id_ptr(ctx, ptr));
+  track_depth(ctx->stats.max_id_depth, ctx->id_stack);
 }
 
 
@@ -355,6 +1005,7 @@ void mu_pop_id(mu_Context *ctx) {
 void mu_push_clip_rect(mu_Context *ctx, mu_Rect rect) {
   mu_Rect last = mu_get_clip_rect(ctx);
   push(ctx->clip_stack, intersect_rects(rect, last));
+  track_depth(ctx->stats.max_clip_depth, ctx->clip_stack);
 }
 
 
@@ -408,6 +1059,7 @@ static void push_layout(mu_Context *ctx, mu_Rect body, mu_Vec2 scroll) {
   layout.body = mu_rect(body.x - scroll.x, body.y - scroll.y, body.w, body.h);
   layout.max = mu_vec2(-0x1000000, -0x1000000);
   push(ctx->layout_stack, layout);
+  track_depth(ctx->stats.max_layout_depth, ctx->layout_stack);
   mu_layout_row(ctx, 1, &width, 0);
 }
 
@@ -488,6 +1140,7 @@ int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
     }
   }
   expect(n > -1);
+  if (items[n].id) { ctx->stats.pool_evictions++; }
   items[n].id = id;
   mu_pool_update(ctx, items, n);
   return n;
@@ -496,10 +1149,10 @@ int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
 
 int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
   int i;
-  unused(ctx);
   for (i = 0; i < len; i++) {
-    if (items[i].id == id) { return i; }
+    if (items[i].id == id) { ctx->stats.pool_hits++; return i; }
   }
+  ctx->stats.pool_misses++;
   return -1;
 }
 
@@ -513,6 +1166,65 @@ void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx) {
 ** input handlers
 **============================================================================*/
 
+/* キューのi番目（先頭から）のイベント */
+#define queued_event(ctx, i) \
+  (&(ctx)->input_queue.items[((ctx)->input_queue.head + (i)) % MU_INPUTQUEUE_SIZE])
+
+/**
+ * @brief 入力イベントの追加（内部関数）
+ * マウス移動とスクロールは、末尾が同じ種類のイベントならまとめます。
+ * キューが一杯なら、マウスボタンのイベントより後ろにある同じ種類のイベントまで
+ * 遡ってまとめます（押した位置は変わらない）。まとめられなければ捨てて数えます。
+ * @param ctx MicroUIのコンテキスト
+ * @param type MU_EVENT_*
+ * @param x マウスX座標・スクロールX量
+ * @param y マウスY座標・スクロールY量
+ * @param code マウスボタン・キー
+ * @return mu_InputEvent* 追加（または更新）したイベント、捨てたらNULL
+ */
+static mu_InputEvent* push_event(mu_Context *ctx, int type, int x, int y, int code) {
+  mu_InputEvent *e;
+  int i, full = ctx->input_queue.count == MU_INPUTQUEUE_SIZE;
+  if (type == MU_EVENT_MOUSEMOVE || type == MU_EVENT_SCROLL) {
+    for (i = ctx->input_queue.count - 1; i >= 0; i--) {
+      e = queued_event(ctx, i);
+      if (e->type == type) {
+        if (type == MU_EVENT_SCROLL) { x += e->x; y += e->y; }
+        e->x = x;
+        e->y = y;
+        e->time = ctx->input_time;
+        return e;
+      }
+      if (!full || e->type == MU_EVENT_MOUSEDOWN || e->type == MU_EVENT_MOUSEUP) { break; }
+    }
+  }
+  if (full) {
+    ctx->input_queue.dropped++;
+    return NULL;
+  }
+  e = queued_event(ctx, ctx->input_queue.count++);
+  e->type = type;
+  e->x = x;
+  e->y = y;
+  e->code = code;
+  e->text = e->len = 0;
+  e->time = ctx->input_time;
+  return e;
+}
+
+
+/**
+ * @brief UTF-8の文字の途中で切らない長さ（内部関数）
+ * @return int max以下で文字の境界になる最長の長さ（無ければ0）
+ */
+static int text_prefix(const char *text, int len, int max) {
+  int n = mu_min(len, max);
+  /* 続きバイトの前で切る */
+  while (n < len && n > 0 && (text[n] & 0xc0) == 0x80) { n--; }
+  return n > 0 ? n : mu_min(len, max);
+}
+
+
 /**
  * @brief マウス移動入力処理
  * マウス座標を更新します。
@@ -523,7 +1235,8 @@ void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx) {
  * @return なし
  */
 void mu_input_mousemove(mu_Context *ctx, int x, int y) {
-  ctx->mouse_pos = mu_vec2(x, y);
+  input_hook(ctx, MU_EVENT_MOUSEMOVE, x, y, 0, NULL);
+  push_event(ctx, MU_EVENT_MOUSEMOVE, x, y, 0);
 }
 
 
@@ -538,9 +1251,8 @@ void mu_input_mousemove(mu_Context *ctx, int x, int y) {
  * @return なし
  */
 void mu_input_mousedown(mu_Context *ctx, int x, int y, int btn) {
-  mu_input_mousemove(ctx, x, y);
-  ctx->mouse_down |= btn;
-  ctx->mouse_pressed |= btn;
+  input_hook(ctx, MU_EVENT_MOUSEDOWN, x, y, btn, NULL);
+  push_event(ctx, MU_EVENT_MOUSEDOWN, x, y, btn);
 }
 
 
@@ -555,8 +1267,8 @@ void mu_input_mousedown(mu_Context *ctx, int x, int y, int btn) {
  * @return なし
  */
 void mu_input_mouseup(mu_Context *ctx, int x, int y, int btn) {
-  mu_input_mousemove(ctx, x, y);
-  ctx->mouse_down &= ~btn;
+  input_hook(ctx, MU_EVENT_MOUSEUP, x, y, btn, NULL);
+  push_event(ctx, MU_EVENT_MOUSEUP, x, y, btn);
 }
 
 
@@ -570,8 +1282,8 @@ void mu_input_mouseup(mu_Context *ctx, int x, int y, int btn) {
  * @return なし
  */
 void mu_input_scroll(mu_Context *ctx, int x, int y) {
-  ctx->scroll_delta.x += x;
-  ctx->scroll_delta.y += y;
+  input_hook(ctx, MU_EVENT_SCROLL, x, y, 0, NULL);
+  push_event(ctx, MU_EVENT_SCROLL, x, y, 0);
 }
 
 
@@ -584,8 +1296,8 @@ void mu_input_scroll(mu_Context *ctx, int x, int y) {
  * @return なし
  */
 void mu_input_keydown(mu_Context *ctx, int key) {
-  ctx->key_pressed |= key;
-  ctx->key_down |= key;
+  input_hook(ctx, MU_EVENT_KEYDOWN, 0, 0, key, NULL);
+  push_event(ctx, MU_EVENT_KEYDOWN, 0, 0, key);
 }
 
 
@@ -598,23 +1310,64 @@ void mu_input_keydown(mu_Context *ctx, int key) {
  * @return なし
  */
 void mu_input_keyup(mu_Context *ctx, int key) {
-  ctx->key_down &= ~key;
+  input_hook(ctx, MU_EVENT_KEYUP, 0, 0, key, NULL);
+  push_event(ctx, MU_EVENT_KEYUP, 0, 0, key);
 }
 
 
 /**
  * @brief テキスト入力処理
- * 入力テキストをバッファに追加します。
+ * 入力テキストをキューに追加します。input_textに1度に入る長さを超える分は、
+ * UTF-8の文字の途中で切らないように複数のイベントに分けます。
  * 使い方: mu_input_text(ctx, "入力文字");
  * @param ctx MicroUIのコンテキスト
  * @param text 入力文字列
  * @return なし
  */
 void mu_input_text(mu_Context *ctx, const char *text) {
-  int len = strlen(ctx->input_text);
-  int size = strlen(text) + 1;
-  expect(len + size <= (int) sizeof(ctx->input_text));
-  memcpy(ctx->input_text + len, text, size);
+  int i, len = strlen(text);
+  int max = (int) sizeof(ctx->input_text) - 1;
+  input_hook(ctx, MU_EVENT_TEXT, 0, 0, 0, text);
+  while (len > 0) {
+    mu_InputEvent *e = NULL;
+    int n = 0, room = MU_INPUTTEXT_SIZE - ctx->input_queue.text_count;
+    /* 末尾のTEXTに空きがあれば続けて書く（そのテキストはリングの末尾にある） */
+    if (ctx->input_queue.count > 0) {
+      e = queued_event(ctx, ctx->input_queue.count - 1);
+      if (e->type == MU_EVENT_TEXT) { n = text_prefix(text, len, mu_min(max - e->len, room)); }
+    }
+    if (n == 0) {
+      n = text_prefix(text, len, mu_min(max, room));
+      if (n == 0) {
+        /* テキストのリングが一杯 */
+        ctx->input_queue.dropped++;
+        break;
+      }
+      e = push_event(ctx, MU_EVENT_TEXT, 0, 0, 0);
+      if (!e) { break; }
+      e->text = (ctx->input_queue.text_head + ctx->input_queue.text_count) % MU_INPUTTEXT_SIZE;
+    }
+    for (i = 0; i < n; i++) {
+      ctx->input_queue.text[(e->text + e->len + i) % MU_INPUTTEXT_SIZE] = text[i];
+    }
+    e->len += n;
+    ctx->input_queue.text_count += n;
+    text += n;
+    len -= n;
+  }
+}
+
+
+/**
+ * @brief 入力イベントの時刻設定
+ * 使い方: mu_input_time(ctx, GetTickCount());
+ * @param ctx MicroUIのコンテキスト
+ * @param time 現在時刻
+ * @return なし
+ */
+void mu_input_time(mu_Context *ctx, unsigned time) {
+  input_hook(ctx, MU_EVENT_TIME, 0, 0, (int) time, NULL);
+  ctx->input_time = time;
 }
 
 
@@ -629,34 +1382,412 @@ MicroUIのコマンドリストは、UI描画や状態変更のための命令
 コマンドリストの走査は、mu_next_command関数で行い、JUMPコマンドによる分岐もサポートしています。
 **============================================================================*/
 
-/**
- * @brief コマンドをコマンドリストに追加する
- * UI描画や状態変更のためのコマンド（矩形、テキスト、アイコン、クリップなど）を
- * コマンドリストに追加します。コマンドリストはフレームごとに蓄積され、
- * 最終的に走査されて描画処理が行われます。
- * @param ctx MicroUIのコンテキスト
- * @param type コマンド種別（MU_COMMAND_RECTなど）
- * @param size コマンドサイズ（バイト数）
- * @return mu_Command* 追加されたコマンドへのポインタ
- */
-mu_Command* mu_push_command(mu_Context *ctx, int type, int size) {
-  mu_Command *cmd = (mu_Command*) (ctx->command_list.items + ctx->command_list.idx);
-  expect(ctx->command_list.idx + size < MU_COMMANDLIST_SIZE);
-  cmd->base.type = type;
-  cmd->base.size = size;
-  ctx->command_list.idx += size;
-  return cmd;
+#ifdef MU_COMPACT_COMMANDS
+
+/* 符号化したコマンドのバイト数 */
+#define COMPACT_CLIP_BYTES 9    /* 種類, x y w h (i16) */
+#define COMPACT_RECT_BYTES 13   /* 種類, x y w h (i16), 色 */
+#define COMPACT_ICON_BYTES 15   /* 種類, id (i16), x y w h (i16), 色 */
+/* 種類, フォント番号 (u8), x y (i16), 色, 長さ (u16), 文字列のポインタ */
+#define COMPACT_TEXT_BYTES (12 + (int) sizeof(const char*))
+
+/* コマンドリストはプロセス内だけで使うので、16ビット値はネイティブのバイト順で置く */
+static int fits_i16(int v) { return (unsigned) v + 32768u <= 0xffffu; }
+
+static int fits_rect(mu_Rect r) {
+  return (((unsigned) r.x + 32768u) | ((unsigned) r.y + 32768u) |
+          ((unsigned) r.w + 32768u) | ((unsigned) r.h + 32768u)) <= 0xffffu;
 }
 
-/**
- * @brief コマンドリストの次のコマンドを取得する
- * コマンドリストを走査し、次の有効なコマンド（JUMP以外）を取得します。
- * JUMPコマンドの場合はジャンプ先に移動します。
- * @param ctx MicroUIのコンテキスト
- * @param cmd コマンドへのポインタ（NULLの場合は先頭から）
+static unsigned char* put_i16(unsigned char *p, int v) {
+  short s = (short) v;
+  memcpy(p, &s, 2);
+  return p + 2;
+}
+
+static int get_i16(const unsigned char *p) {
+  short s;
+  memcpy(&s, p, 2);
+  return s;
+}
+
+static unsigned char* put_rect(unsigned char *p, mu_Rect r) {
+  short v[4];
+  v[0] = (short) r.x; v[1] = (short) r.y; v[2] = (short) r.w; v[3] = (short) r.h;
+  memcpy(p, v, 8);
+  return p + 8;
+}
+
+static mu_Rect get_rect(const unsigned char *p) {
+  short v[4];
+  memcpy(v, p, 8);
+  return mu_rect(v[0], v[1], v[2], v[3]);
+}
+
+
+/**
+ * @brief フォントの番号（内部関数）
+ * @return int 番号、表が一杯なら-1
+ */
+static int compact_font(mu_Context *ctx, mu_Font font) {
+  int i;
+  for (i = 0; i < ctx->command_font_count; i++) {
+    if (ctx->command_fonts[i] == font) { return i; }
+  }
+  if (i == MU_COMPACT_FONTS) { return -1; }
+  ctx->command_fonts[i] = font;
+  return ctx->command_font_count++;
+}
+
+
+/**
+ * @brief 構造体のままのコマンドの領域確保（内部関数）
+ * 種類RAWの1バイトを書き、構造体の境界まで詰めた位置を返します。
+ * @param ctx MicroUIのコンテキスト
+ * @param size コマンドサイズ（バイト数）
+ * @return mu_Command* 確保した位置
+ */
+static mu_Command* push_raw(mu_Context *ctx, int size) {
+  char *p = ctx->command_list.items + ctx->command_list.idx;
+  size_t align = sizeof(void*);
+  char *cmd = (char*) (((size_t) (p + 1) + align - 1) & ~(align - 1));
+  expect(cmd - ctx->command_list.items + size < MU_COMMANDLIST_SIZE);
+  *p = COMPACT_RAW;
+  ctx->command_list.idx = (int) (cmd - ctx->command_list.items) + size;
+  return (mu_Command*) cmd;
+}
+
+
+/**
+ * @brief 保留中のコマンドの符号化（内部関数）
+ * 16ビットに収まらない値やフォントの番号が足りない場合は構造体のまま書き込みます。
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+static void flush_command(mu_Context *ctx) {
+  mu_Command *cmd = &ctx->command_pending.command;
+  unsigned char *p = (unsigned char*) ctx->command_list.items + ctx->command_list.idx;
+  int n = 0, font = 0;
+  if (!ctx->command_has_pending) { return; }
+  ctx->command_has_pending = 0;
+  switch (cmd->type) {
+    case MU_COMMAND_CLIP:
+      if (fits_rect(cmd->clip.rect)) { n = COMPACT_CLIP_BYTES; }
+      break;
+    case MU_COMMAND_RECT:
+      if (fits_rect(cmd->rect.rect)) { n = COMPACT_RECT_BYTES; }
+      break;
+    case MU_COMMAND_ICON:
+      if (fits_rect(cmd->icon.rect) && fits_i16(cmd->icon.id)) { n = COMPACT_ICON_BYTES; }
+      break;
+    case MU_COMMAND_TEXT:
+      font = compact_font(ctx, cmd->text.font);
+      if (font >= 0 && fits_i16(cmd->text.pos.x) && fits_i16(cmd->text.pos.y) &&
+          (unsigned) cmd->text.len <= 0xffffu) {
+        n = COMPACT_TEXT_BYTES;
+      }
+      break;
+  }
+  if (n == 0) {
+    memcpy(push_raw(ctx, cmd->base.size), cmd, cmd->base.size);
+    return;
+  }
+  expect(ctx->command_list.idx + n < MU_COMMANDLIST_SIZE);
+  *p++ = (unsigned char) cmd->type;
+  switch (cmd->type) {
+    case MU_COMMAND_CLIP: put_rect(p, cmd->clip.rect); break;
+    case MU_COMMAND_RECT: memcpy(put_rect(p, cmd->rect.rect), &cmd->rect.color, 4); break;
+    case MU_COMMAND_ICON:
+      memcpy(put_rect(put_i16(p, cmd->icon.id), cmd->icon.rect), &cmd->icon.color, 4);
+      break;
+    case MU_COMMAND_TEXT:
+      *p++ = (unsigned char) font;
+      p = put_i16(put_i16(p, cmd->text.pos.x), cmd->text.pos.y);
+      memcpy(p, &cmd->text.color, 4);
+      memcpy(put_i16(p + 4, cmd->text.len), &cmd->text.str, sizeof(const char*));
+      break;
+  }
+  ctx->command_list.idx += n;
+}
+
+
+/**
+ * @brief 矩形コマンドを直接符号化して追加（内部関数）
+ * 最も数の多いRECTは保留領域を経由せずに書き込みます。
+ * @return int 追加したら1、16ビットに収まらなければ0（mu_push_commandで追加する）
+ */
+static int push_compact_rect(mu_Context *ctx, mu_Rect rect, mu_Color color) {
+  unsigned char *p;
+  if (!fits_rect(rect)) { return 0; }
+  flush_command(ctx);
+  expect(ctx->command_list.idx + COMPACT_RECT_BYTES < MU_COMMANDLIST_SIZE);
+  p = (unsigned char*) ctx->command_list.items + ctx->command_list.idx;
+  *p = MU_COMMAND_RECT;
+  memcpy(put_rect(p + 1, rect), &color, 4);
+  ctx->command_list.idx += COMPACT_RECT_BYTES;
+  ctx->stats.commands[MU_COMMAND_RECT]++;
+  return 1;
+}
+
+#endif
+
+
+/**
+ * @brief コマンドリストと文字列プールを空にする
+ * 文字列プールの重複検出表は世代を進めて無効にする（表全体を消さずに済む）。
+ * 使い方: mu_clear_commands(ctx);
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_clear_commands(mu_Context *ctx) {
+  ctx->command_list.idx = 0;
+#ifdef MU_COMPACT_COMMANDS
+  ctx->command_has_pending = 0;
+#endif
+  ctx->text_pool.idx = 0;
+  ctx->text_pool_generation++;
+}
+
+/**
+ * @brief 文字列プールのハッシュ（内部関数）
+ * 長さと先頭・中央・末尾の4バイトだけから求めるので、長い文字列でも一定の時間で済む。
+ * 一致の判定はmemcmpで行うので、衝突しても結果は変わらない。
+ * @return unsigned ハッシュ値
+ */
+static unsigned text_hash(const char *str, int len) {
+  unsigned a, b, c, h = (unsigned) len * 2654435761u;
+  if (len >= 4) {
+    memcpy(&a, str, 4);
+    memcpy(&b, str + (len >> 1) - 2, 4);
+    memcpy(&c, str + len - 4, 4);
+  } else {
+    const unsigned char *p = (const unsigned char*) str;
+    a = len > 0 ? p[0] : 0;
+    b = len > 1 ? p[1] : 0;
+    c = len > 2 ? p[2] : 0;
+  }
+  h = (h ^ a) * 0x9e3779b1u;
+  h = (h ^ b) * 0x85ebca77u;
+  h = (h ^ c) * 0xc2b2ae3du;
+  return h ^ (h >> 16);
+}
+
+/**
+ * @brief 文字列プールへの登録
+ * 同じ内容の文字列は1つだけ置く。重複検出表は数回だけ探し、
+ * 空きが見つからなければ登録せずにコピーする。
+ * 使い方: str = mu_intern_text(ctx, "OK", -1);
+ * @param ctx MicroUIのコンテキスト
+ * @param str 文字列
+ * @param len 文字列長（-1なら自動判定）
+ * @return const char* プール内の文字列（終端付き）
+ */
+const char* mu_intern_text(mu_Context *ctx, const char *str, int len) {
+  unsigned h;
+  int i, slot = -1;
+  char *dst;
+  if (len < 0) { len = strlen(str); }
+  h = text_hash(str, len);
+  for (i = 0; i < 8; i++) {
+    int n = (h + i) & (MU_TEXTPOOL_HASH - 1);
+    if (ctx->text_pool_hash[n].generation != ctx->text_pool_generation) {
+      slot = n;
+      break;
+    }
+    if (ctx->text_pool_hash[n].hash == h && ctx->text_pool_hash[n].len == len &&
+        memcmp(ctx->text_pool.items + ctx->text_pool_hash[n].offset, str, len) == 0)
+    {
+      ctx->stats.text_shared++;
+      return ctx->text_pool.items + ctx->text_pool_hash[n].offset;
+    }
+  }
+  expect(ctx->text_pool.idx + len + 1 <= MU_TEXTPOOL_SIZE);
+  dst = ctx->text_pool.items + ctx->text_pool.idx;
+  memcpy(dst, str, len);
+  dst[len] = '\0';
+  if (slot >= 0) {
+    ctx->text_pool_hash[slot].hash = h;
+    ctx->text_pool_hash[slot].offset = ctx->text_pool.idx;
+    ctx->text_pool_hash[slot].len = len;
+    ctx->text_pool_hash[slot].generation = ctx->text_pool_generation;
+  }
+  ctx->text_pool.idx += len + 1;
+  return dst;
+}
+
+/**
+ * @brief コマンドをコマンドリストに追加する
+ * UI描画や状態変更のためのコマンド（矩形、テキスト、アイコン、クリップなど）を
+ * コマンドリストに追加します。コマンドリストはフレームごとに蓄積され、
+ * 最終的に走査されて描画処理が行われます。
+ * MU_COMPACT_COMMANDSでは、描画コマンドは保留領域に書かせて次の追加時に符号化します。
+ * JUMPと保留領域に入らない長さのコマンドは、構造体のままコマンドリストに置きます。
+ * @param ctx MicroUIのコンテキスト
+ * @param type コマンド種別（MU_COMMAND_RECTなど）
+ * @param size コマンドサイズ（バイト数）
+ * @return mu_Command* 追加されたコマンドへのポインタ
+ */
+mu_Command* mu_push_command(mu_Context *ctx, int type, int size) {
+  mu_Command *cmd;
+  mu_profile_begin("push");
+#ifdef MU_COMPACT_COMMANDS
+  flush_command(ctx);
+  if (type == MU_COMMAND_JUMP || size > (int) sizeof(ctx->command_pending)) {
+    cmd = push_raw(ctx, size);
+  } else {
+    cmd = &ctx->command_pending.command;
+    ctx->command_has_pending = 1;
+  }
+#else
+  cmd = (mu_Command*) (ctx->command_list.items + ctx->command_list.idx);
+  expect(ctx->command_list.idx + size < MU_COMMANDLIST_SIZE);
+  ctx->command_list.idx += size;
+#endif
+  cmd->base.type = type;
+  cmd->base.size = size;
+  /* アプリ独自の種類（MU_COMMAND_MAX以降）は空いている0番にまとめて数える */
+  ctx->stats.commands[type > 0 && type < MU_COMMAND_MAX ? type : 0]++;
+  mu_profile_end();
+  return cmd;
+}
+
+/**
+ * @brief 保留中のコマンドの確定
+ * 使い方: mu_commit_commands(ctx);
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_commit_commands(mu_Context *ctx) {
+#ifdef MU_COMPACT_COMMANDS
+  flush_command(ctx);
+#else
+  (void) ctx;
+#endif
+}
+
+/**
+ * @brief 外部から読み込んだコマンドの積み直し
+ * 保存したファイルや通信で受け取ったコマンドを戻す処理で共通に使う。
+ * mu_push_commandで積むので、MU_COMPACT_COMMANDSでもそのまま走査できる。
+ * 使い方: if (!mu_inject_command(ctx, &cmd)) { mu_clear_commands(ctx); }
+ * @param ctx MicroUIのコンテキスト
+ * @param src 積むコマンド（TEXTのstrはlenバイトをプールへコピーする）
+ * @return int 積んだら1、種類が不正か容量が足りなければ0
+ */
+int mu_inject_command(mu_Context *ctx, const mu_Command *src) {
+  mu_Command *cmd;
+  int size;
+  switch (src->type) {
+    case MU_COMMAND_CLIP: size = sizeof(mu_ClipCommand); break;
+    case MU_COMMAND_RECT: size = sizeof(mu_RectCommand); break;
+    case MU_COMMAND_ICON: size = sizeof(mu_IconCommand); break;
+    case MU_COMMAND_TEXT:
+      if (src->text.len < 0 || ctx->text_pool.idx + src->text.len + 1 > MU_TEXTPOOL_SIZE) { return 0; }
+      size = sizeof(mu_TextCommand);
+      break;
+    default: return 0;
+  }
+  /* 確定前のコマンドが構造体のまま書かれても収まるよう、展開先の大きさ分の余裕を見る */
+  if (ctx->command_list.idx + size + (int) sizeof(mu_CommandScratch) + 16 >= MU_COMMANDLIST_SIZE) {
+    return 0;
+  }
+  cmd = mu_push_command(ctx, src->type, size);
+  memcpy((char*) cmd + sizeof(mu_BaseCommand), (const char*) src + sizeof(mu_BaseCommand),
+         size - sizeof(mu_BaseCommand));
+  if (src->type == MU_COMMAND_TEXT) { cmd->text.str = mu_intern_text(ctx, src->text.str, src->text.len); }
+  return 1;
+}
+
+/**
+ * @brief コマンドを1つ読み出す
+ * 使い方: cmd = mu_read_command(ctx, &pos, &scratch);
+ * @param ctx MicroUIのコンテキスト
+ * @param pos 読み出し位置（次のコマンドの位置に進める）
+ * @param scratch 展開先（MU_COMPACT_COMMANDSのみ）
+ * @return mu_Command* コマンド
+ */
+mu_Command* mu_read_command(mu_Context *ctx, char **pos, mu_CommandScratch *scratch) {
+#ifdef MU_COMPACT_COMMANDS
+  const unsigned char *p = (const unsigned char*) *pos;
+  mu_Command *cmd = &scratch->command;
+  int op = p[0], type = op & ~COMPACT_CULLED, n;
+  if (op == COMPACT_RAW) {
+    size_t align = sizeof(void*);
+    cmd = (mu_Command*) (((size_t) (p + 1) + align - 1) & ~(align - 1));
+    *pos = (char*) cmd + cmd->base.size;
+    return cmd;
+  }
+  switch (type) {
+    case MU_COMMAND_CLIP: n = COMPACT_CLIP_BYTES; cmd->base.size = sizeof(mu_ClipCommand); break;
+    case MU_COMMAND_RECT: n = COMPACT_RECT_BYTES; cmd->base.size = sizeof(mu_RectCommand); break;
+    case MU_COMMAND_ICON: n = COMPACT_ICON_BYTES; cmd->base.size = sizeof(mu_IconCommand); break;
+    default: n = COMPACT_TEXT_BYTES; cmd->base.size = sizeof(mu_TextCommand); break;
+  }
+  *pos += n;
+  /* 隠れたコマンドは次のコマンドへのJUMPとして返す */
+  if (op & COMPACT_CULLED) {
+    cmd->base.type = MU_COMMAND_JUMP;
+    cmd->jump.dst = *pos;
+    return cmd;
+  }
+  cmd->base.type = type;
+  switch (type) {
+    case MU_COMMAND_CLIP: cmd->clip.rect = get_rect(p + 1); break;
+    case MU_COMMAND_RECT:
+      cmd->rect.rect = get_rect(p + 1);
+      memcpy(&cmd->rect.color, p + 9, 4);
+      break;
+    case MU_COMMAND_ICON:
+      cmd->icon.id = get_i16(p + 1);
+      cmd->icon.rect = get_rect(p + 3);
+      memcpy(&cmd->icon.color, p + 11, 4);
+      break;
+    default:
+      cmd->text.font = ctx->command_fonts[p[1]];
+      cmd->text.pos = mu_vec2(get_i16(p + 2), get_i16(p + 4));
+      memcpy(&cmd->text.color, p + 6, 4);
+      cmd->text.len = (unsigned short) get_i16(p + 10);
+      memcpy(&cmd->text.str, p + 12, sizeof(const char*));
+      break;
+  }
+  return cmd;
+#else
+  mu_Command *cmd = (mu_Command*) *pos;
+  (void) ctx;
+  (void) scratch;
+  *pos += cmd->base.size;
+  return cmd;
+#endif
+}
+
+/**
+ * @brief コマンドリストの次のコマンドを取得する
+ * コマンドリストを走査し、次の有効なコマンド（JUMP以外）を取得します。
+ * JUMPコマンドの場合はジャンプ先に移動します。
+ * @param ctx MicroUIのコンテキスト
+ * @param cmd コマンドへのポインタ（NULLの場合は先頭から）
  * @return int 有効なコマンドがあれば1、末尾なら0
  */
 int mu_next_command(mu_Context *ctx, mu_Command **cmd) {
+#ifdef MU_COMPACT_COMMANDS
+  char *pos, *end;
+  if (*cmd) {
+    pos = ctx->command_read;
+  } else {
+    flush_command(ctx);
+    pos = ctx->command_list.items;
+  }
+  end = ctx->command_list.items + ctx->command_list.idx;
+  while (pos != end) {
+    *cmd = mu_read_command(ctx, &pos, &ctx->command_decoded);
+    if ((*cmd)->type != MU_COMMAND_JUMP) {
+      ctx->command_read = pos;
+      return 1;
+    }
+    pos = (*cmd)->jump.dst;
+  }
+  return 0;
+#else
   if (*cmd) {
     *cmd = (mu_Command*) (((char*) *cmd) + (*cmd)->base.size);
   } else {
@@ -667,6 +1798,7 @@ int mu_next_command(mu_Context *ctx, mu_Command **cmd) {
     *cmd = (*cmd)->jump.dst;
   }
   return 0;
+#endif
 }
 
 /**
@@ -693,6 +1825,7 @@ static mu_Command* push_jump(mu_Context *ctx, mu_Command *dst) {
  */
 void mu_set_clip(mu_Context *ctx, mu_Rect rect) {
   mu_Command *cmd;
+  if (ctx->measuring) { return; }
   cmd = mu_push_command(ctx, MU_COMMAND_CLIP, sizeof(mu_ClipCommand));
   cmd->clip.rect = rect;
 }
@@ -708,8 +1841,12 @@ void mu_set_clip(mu_Context *ctx, mu_Rect rect) {
  */
 void mu_draw_rect(mu_Context *ctx, mu_Rect rect, mu_Color color) {
   mu_Command *cmd;
+  if (ctx->measuring) { return; }
   rect = intersect_rects(rect, mu_get_clip_rect(ctx));
   if (rect.w > 0 && rect.h > 0) {
+#ifdef MU_COMPACT_COMMANDS
+    if (push_compact_rect(ctx, rect, color)) { return; }
+#endif
     cmd = mu_push_command(ctx, MU_COMMAND_RECT, sizeof(mu_RectCommand));
     cmd->rect.rect = rect;
     cmd->rect.color = color;
@@ -731,6 +1868,36 @@ void mu_draw_box(mu_Context *ctx, mu_Rect rect, mu_Color color) {
   mu_draw_rect(ctx, mu_rect(rect.x + rect.w - 1, rect.y, 1, rect.h), color);
 }
 
+/**
+ * @brief テキスト描画コマンドの追加（内部関数）
+ * 文字列は文字列プールにコピーするが、is_staticならそのまま参照する。
+ * @param is_static 文字列が終端付きで描画まで有効なら1（str[len]は読まない）
+ * @return なし
+ */
+static void draw_text(mu_Context *ctx, mu_Font font, const char *str, int len,
+  mu_Vec2 pos, mu_Color color, int is_static)
+{
+  mu_Command *cmd;
+  mu_Rect rect;
+  int clipped;
+  if (ctx->measuring) { return; }
+  if (len < 0) { len = strlen(str); }
+  rect = mu_rect(pos.x, pos.y, text_width(ctx, font, str, len), ctx->text_height(font));
+  clipped = mu_check_clip(ctx, rect);
+  if (clipped == MU_CLIP_ALL ) { return; }
+  if (clipped == MU_CLIP_PART) { mu_set_clip(ctx, mu_get_clip_rect(ctx)); }
+  /* コマンド追加 */
+  if (!is_static) { str = mu_intern_text(ctx, str, len); }
+  cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand));
+  cmd->text.str = str;
+  cmd->text.len = len;
+  cmd->text.pos = pos;
+  cmd->text.color = color;
+  cmd->text.font = font;
+  /* クリップをリセット */
+  if (clipped) { mu_set_clip(ctx, unclipped_rect); }
+}
+
 /**
  * @brief テキスト描画コマンドをコマンドリストに追加する
  * 指定した位置・フォント・色でテキストを描画するコマンドを追加します。
@@ -746,22 +1913,25 @@ void mu_draw_box(mu_Context *ctx, mu_Rect rect, mu_Color color) {
 void mu_draw_text(mu_Context *ctx, mu_Font font, const char *str, int len,
   mu_Vec2 pos, mu_Color color)
 {
-  mu_Command *cmd;
-  mu_Rect rect = mu_rect(
-    pos.x, pos.y, ctx->text_width(font, str, len), ctx->text_height(font));
-  int clipped = mu_check_clip(ctx, rect);
-  if (clipped == MU_CLIP_ALL ) { return; }
-  if (clipped == MU_CLIP_PART) { mu_set_clip(ctx, mu_get_clip_rect(ctx)); }
-  /* コマンド追加 */
-  if (len < 0) { len = strlen(str); }
-  cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand) + len);
-  memcpy(cmd->text.str, str, len);
-  cmd->text.str[len] = '\0';
-  cmd->text.pos = pos;
-  cmd->text.color = color;
-  cmd->text.font = font;
-  /* クリップをリセット */
-  if (clipped) { mu_set_clip(ctx, unclipped_rect); }
+  draw_text(ctx, font, str, len, pos, color, 0);
+}
+
+/**
+ * @brief テキスト描画コマンドを文字列をコピーせずに追加する
+ * 文字列はコマンドから直接参照するので、描画が終わるまで有効でなければならない。
+ * バックエンドは終端まで読むので、strは終端付きで、lenは-1かstrlen(str)にする。
+ * @param ctx MicroUIのコンテキスト
+ * @param font フォント
+ * @param str 描画する文字列（終端付き）
+ * @param len 文字列長（-1かstrlen(str)）
+ * @param pos 描画位置
+ * @param color 描画色
+ * @return なし
+ */
+void mu_draw_text_static(mu_Context *ctx, mu_Font font, const char *str, int len,
+  mu_Vec2 pos, mu_Color color)
+{
+  draw_text(ctx, font, str, len, pos, color, 1);
 }
 
 /**
@@ -776,8 +1946,10 @@ void mu_draw_text(mu_Context *ctx, mu_Font font, const char *str, int len,
  */
 void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color) {
   mu_Command *cmd;
+  int clipped;
+  if (ctx->measuring) { return; }
   /* 矩形がクリップ矩形内に完全に含まれていない場合はクリップコマンドを発行 */
-  int clipped = mu_check_clip(ctx, rect);
+  clipped = mu_check_clip(ctx, rect);
   if (clipped == MU_CLIP_ALL ) { return; }
   if (clipped == MU_CLIP_PART) { mu_set_clip(ctx, mu_get_clip_rect(ctx)); }
   /* アイコンコマンド発行 */
@@ -819,6 +1991,8 @@ void mu_layout_end_column(mu_Context *ctx) {
   pop(ctx->layout_stack);
   /* 子レイアウトのposition/next_row/maxが大きい場合は継承する */
   a = get_layout(ctx);
+  /* 行の途中で位置がずれることがあるので、この行の計算結果は使えない */
+  a->resolved = 0;
   a->position.x = mu_max(a->position.x, b->position.x + b->body.x - a->body.x);
   a->next_row = mu_max(a->next_row, b->next_row + b->body.y - a->body.y);
   a->max.x = mu_max(a->max.x, b->max.x);
@@ -827,120 +2001,666 @@ void mu_layout_end_column(mu_Context *ctx) {
 
 
 /**
- * @brief レイアウト行の設定
- * 現在のレイアウトに新しい行を設定します。
- * 行内のアイテム数や各アイテムの幅、高さを指定できます。
- * @param ctx MicroUIのコンテキスト
- * @param items 行内のアイテム数
- * @param widths 各アイテムの幅（NULLの場合は自動）
- * @param height 行の高さ
- * @return なし
+ * @brief 行の入力の比較（内部関数）
+ * @return int 現在の行にrの計算結果を使えれば1
+ */
+static int same_row_input(mu_Layout *layout, mu_Style *style, const mu_LayoutRow *r) {
+  return r->items == layout->items && r->height == layout->size.y &&
+         r->body_w == layout->body.w && r->indent == layout->indent &&
+         r->spacing == style->spacing && r->padding == style->padding &&
+         r->size_x == style->size.x && r->size_y == style->size.y &&
+         memcmp(r->widths, layout->widths, r->items * sizeof(int)) == 0;
+}
+
+
+/**
+ * @brief 行の幅・高さの計算結果を更新（内部関数）
+ * 行の指定（アイテム数・幅・高さ）、bodyの幅、スタイルで結果が決まるので、
+ * 同じレイアウトの前の行（自動で次の行に移った場合など）と入力が同じなら
+ * 計算をやり直さずにそのまま使います。
+ * 高さが負の行は行の位置によって結果が変わるので対象外です。
+ * @param ctx MicroUIのコンテキスト
+ * @param layout レイアウト
+ * @return なし
+ */
+static void resolve_row(mu_Context *ctx, mu_Layout *layout) {
+  mu_Style *style = ctx->style;
+  mu_LayoutRow *row = &layout->row;
+  int i, x;
+
+  layout->row_index++;
+  layout->resolved = 0;
+  if (layout->items <= 0 || layout->size.y < 0) { return; }
+  layout->resolved = 1;
+
+  if (same_row_input(layout, style, row)) {
+    ctx->layout_row_reuses++;
+    return;
+  }
+  ctx->layout_row_resolves++;
+
+  row->items = layout->items;
+  row->height = layout->size.y;
+  row->body_w = layout->body.w;
+  row->indent = layout->indent;
+  row->spacing = style->spacing;
+  row->padding = style->padding;
+  row->size_x = style->size.x;
+  row->size_y = style->size.y;
+  for (i = 0, x = row->indent; i < row->items; i++) {
+    int w = row->widths[i] = layout->widths[i];
+    if (w == 0) { w = row->size_x + row->padding * 2; }
+    if (w <  0) { w += row->body_w - x + 1; }
+    row->resolved_w[i] = w;
+    x += w + row->spacing;
+  }
+  row->resolved_h = row->height ? row->height : row->size_y + row->padding * 2;
+}
+
+
+/**
+ * @brief レイアウト行の設定
+ * 現在のレイアウトに新しい行を設定します。
+ * 行内のアイテム数や各アイテムの幅、高さを指定できます。
+ * @param ctx MicroUIのコンテキスト
+ * @param items 行内のアイテム数
+ * @param widths 各アイテムの幅（NULLの場合は自動）
+ * @param height 行の高さ
+ * @return なし
+ */
+void mu_layout_row(mu_Context *ctx, int items, const int *widths, int height) {
+  mu_Layout *layout = get_layout(ctx);
+  if (widths) {
+    expect(items <= MU_MAX_WIDTHS);
+    memcpy(layout->widths, widths, items * sizeof(widths[0]));
+  }
+  layout->items = items;
+  layout->position = mu_vec2(layout->indent, layout->next_row);
+  layout->size.y = height;
+  layout->item_index = 0;
+  resolve_row(ctx, layout);
+}
+
+
+/**
+ * @brief レイアウトの幅を設定
+ * 現在のレイアウトの幅（次のアイテムの幅）を指定します。
+ * @param ctx MicroUIのコンテキスト
+ * @param width 幅
+ * @return なし
+ */
+void mu_layout_width(mu_Context *ctx, int width) {
+  get_layout(ctx)->size.x = width;
+}
+
+
+/**
+ * @brief レイアウトの高さを設定
+ * 現在のレイアウトの高さ（次のアイテムの高さ）を指定します。
+ * @param ctx MicroUIのコンテキスト
+ * @param height 高さ
+ * @return なし
+ */
+void mu_layout_height(mu_Context *ctx, int height) {
+  mu_Layout *layout = get_layout(ctx);
+  layout->size.y = height;
+  layout->resolved = 0;
+}
+
+
+/**
+ * @brief 次のアイテムのレイアウト位置を設定
+ * 次のアイテムの位置・サイズを絶対または相対で指定します。
+ * @param ctx MicroUIのコンテキスト
+ * @param r 指定する矩形
+ * @param relative 相対指定なら1、絶対指定なら0
+ * @return なし
+ */
+void mu_layout_set_next(mu_Context *ctx, mu_Rect r, int relative) {
+  mu_Layout *layout = get_layout(ctx);
+  layout->next = r;
+  layout->next_type = relative ? RELATIVE : ABSOLUTE;
+  /* 相対指定では行の途中で位置がずれるので、この行の計算結果は使えない */
+  layout->resolved = 0;
+}
+
+
+/**
+ * @brief 次のアイテムのレイアウト矩形を取得
+ * 現在のレイアウト情報から次のアイテムの位置・サイズ（矩形）を計算して返します。
+ * 行のアイテム数や幅・高さ、bodyオフセット、インデントなどを考慮します。
+ * @param ctx MicroUIのコンテキスト
+ * @return mu_Rect 次のアイテムの矩形
+ */
+mu_Rect mu_layout_next(mu_Context *ctx) {
+  mu_Layout *layout = get_layout(ctx);
+  mu_Style *style = ctx->style;
+  mu_Rect res;
+
+  mu_profile_begin("layout");
+  if (layout->next_type) {
+    /* mu_layout_set_nextで設定された矩形を処理 */
+    int type = layout->next_type;
+    layout->next_type = 0;
+    res = layout->next;
+    if (type == ABSOLUTE) {
+      ctx->culled = mu_check_clip(ctx, res) == MU_CLIP_ALL;
+      mu_profile_end();
+      return (ctx->last_rect = res);
+    }
+
+  } else if (layout->flex) {
+    /* フレックスレイアウトの次のアイテム（mu_layout_begin_flexで計算済み） */
+    mu_FlexItem *it;
+    expect(layout->flex_index < layout->flex_count);
+    it = &layout->flex[layout->flex_index++];
+    if (layout->flex_dir == MU_FLEX_ROW) {
+      res = mu_rect(it->offset, 0, it->size, layout->body.h);
+    } else {
+      res = mu_rect(0, it->offset, layout->body.w, it->size);
+    }
+
+  } else {
+    /* 次の行を処理 */
+    if (layout->item_index == layout->items) {
+      mu_layout_row(ctx, layout->items, NULL, layout->size.y);
+    }
+
+    /* 位置設定 */
+    res.x = layout->position.x;
+    res.y = layout->position.y;
+
+    /* サイズ設定（行の計算結果があればそれを使う） */
+    if (layout->resolved) {
+      res.w = layout->row.resolved_w[layout->item_index];
+      res.h = layout->row.resolved_h;
+    } else {
+      res.w = layout->items > 0 ? layout->widths[layout->item_index] : layout->size.x;
+      res.h = layout->size.y;
+      if (res.w == 0) { res.w = style->size.x + style->padding * 2; }
+      if (res.h == 0) { res.h = style->size.y + style->padding * 2; }
+      if (res.w <  0) { res.w += layout->body.w - res.x + 1; }
+      if (res.h <  0) { res.h += layout->body.h - res.y + 1; }
+    }
+
+    layout->item_index++;
+  }
+
+  /* 位置更新（フレックスのアイテムは計算済みの位置に置くので進めない） */
+  if (!layout->flex) {
+    layout->position.x += res.w + style->spacing;
+    layout->next_row = mu_max(layout->next_row, res.y + res.h + style->spacing);
+  }
+
+  /* bodyオフセット適用 */
+  res.x += layout->body.x;
+  res.y += layout->body.y;
+
+  /* 最大位置更新 */
+  layout->max.x = mu_max(layout->max.x, res.x + res.w);
+  layout->max.y = mu_max(layout->max.y, res.y + res.h);
+
+  /* スクロールで見えない位置なら、ウィジェットは計測と描画を省略できる */
+  ctx->culled = mu_check_clip(ctx, res) == MU_CLIP_ALL;
+  mu_profile_end();
+  return (ctx->last_rect = res);
+}
+
+
+/**
+ * @brief リストの表示範囲を計算する
+ * 行の間隔（高さ＋spacing）は一定なので、クリップ領域の上端・下端から
+ * 見えている行を割り算で求めます。レイアウトはstart行目から始まるように設定します。
+ * 使い方: mu_list_clipper_begin(ctx, &clip, count, 0);
+ * @param ctx MicroUIのコンテキスト
+ * @param clipper 結果の格納先
+ * @param count 全体の行数
+ * @param row_height 行の高さ（0なら既定の高さ）
+ * @return なし
+ */
+void mu_list_clipper_begin(mu_Context *ctx, mu_ListClipper *clipper, int count, int row_height) {
+  mu_Layout *layout = get_layout(ctx);
+  mu_Rect clip = mu_get_clip_rect(ctx);
+  int stride, y;
+  if (row_height <= 0) { row_height = ctx->style->size.y + ctx->style->padding * 2; }
+  stride = row_height + ctx->style->spacing;
+
+  clipper->count = count;
+  clipper->row_height = row_height;
+  clipper->top = layout->next_row;
+
+  /* 先頭行の画面上のyからクリップ領域までの距離を行数に換算 */
+  y = layout->body.y + clipper->top;
+  clipper->start = mu_clamp((clip.y - y) / stride, 0, count);
+  clipper->end = mu_clamp((clip.y + clip.h - y + stride - 1) / stride, clipper->start, count);
+
+  /* start行目からレイアウトを始める */
+  layout->next_row = clipper->top + clipper->start * stride;
+  mu_layout_row(ctx, layout->items, NULL, row_height);
+}
+
+
+/**
+ * @brief リストの終了
+ * 使い方: mu_list_clipper_end(ctx, &clip);
+ * @param ctx MicroUIのコンテキスト
+ * @param clipper mu_list_clipper_beginで設定したもの
+ * @return なし
+ */
+void mu_list_clipper_end(mu_Context *ctx, mu_ListClipper *clipper) {
+  mu_Layout *layout = get_layout(ctx);
+  int stride = clipper->row_height + ctx->style->spacing;
+  int bottom = clipper->top + clipper->count * stride;
+  /* 作らなかった行も含めて最後の行の後ろまで進める */
+  layout->next_row = mu_max(layout->next_row, bottom);
+  layout->item_index = layout->items;
+  if (clipper->count > 0) {
+    layout->max.y = mu_max(layout->max.y, layout->body.y + bottom - ctx->style->spacing);
+  }
+}
+
+
+/*============================================================================
+** flex layout
+**============================================================================*/
+
+/**
+ * @brief min/maxで制限したサイズ（内部関数）
+ * minとmaxが矛盾する場合はminを優先します。
+ */
+static int flex_clamp(const mu_FlexItem *item, int size) {
+  if (item->max > 0 && size > item->max) { size = item->max; }
+  if (size < item->min) { size = item->min; }
+  return mu_max(size, 0);
+}
+
+
+/**
+ * @brief アイテムの基本サイズ（内部関数）
+ */
+static int flex_basis(const mu_FlexItem *item, int def) {
+  return item->basis > 0 ? item->basis : item->basis == 0 ? def : 0;
+}
+
+
+/**
+ * @brief フレックスアイテムのサイズ計算（内部関数）
+ * 固定されていないアイテムに余り（不足）を比率で分け、min/maxを超えたものを
+ * 固定して分け直します。超過の合計が正ならmin側、負ならmax側だけを固定します。
+ * 1回の繰り返しはO(n)で、分け直すたびに少なくとも1つ固定されるので、
+ * 最悪ではアイテム数回・全体でO(n²)になります（通常は1〜2回で終わります）。
+ * 端数は累積値を丸めて配るので、合計はちょうどavailになります。
+ * stateは計算中の状態（0: 未固定、1: 固定、2: minで制限、3: maxで制限）です。
+ * @param items アイテムの配列
+ * @param count アイテム数
+ * @param avail 間隔を除いた主軸方向の大きさ
+ * @param def basisが0のときの大きさ
+ * @return なし
+ */
+static void flex_solve(mu_FlexItem *items, int count, int avail, int def) {
+  int i, free, prev, next, target, violation;
+  double weight, total, acc;
+
+  /* 伸び（縮み）ないアイテムは基本サイズで固定 */
+  free = avail;
+  for (i = 0; i < count; i++) {
+    free -= flex_clamp(&items[i], flex_basis(&items[i], def));
+  }
+  for (i = 0; i < count; i++) {
+    mu_FlexItem *it = &items[i];
+    it->size = flex_clamp(it, flex_basis(it, def));
+    it->state = (free > 0 ? it->grow : it->shrink) > 0 ? 0 : 1;
+  }
+
+  for (;;) {
+    /* 残りの大きさと比率の合計 */
+    free = avail;
+    total = 0;
+    for (i = 0; i < count; i++) {
+      mu_FlexItem *it = &items[i];
+      if (it->state) { free -= it->size; continue; }
+      free -= flex_basis(it, def);
+    }
+    for (i = 0; i < count; i++) {
+      mu_FlexItem *it = &items[i];
+      if (it->state) { continue; }
+      total += free > 0 ? it->grow : (double) it->shrink * flex_basis(it, def);
+    }
+    if (total <= 0) {
+      for (i = 0; i < count; i++) {
+        if (!items[i].state) { items[i].size = flex_clamp(&items[i], flex_basis(&items[i], def)); }
+      }
+      break;
+    }
+
+    /* 比率で分けてmin/maxで制限 */
+    acc = 0;
+    prev = 0;
+    violation = 0;
+    for (i = 0; i < count; i++) {
+      mu_FlexItem *it = &items[i];
+      if (it->state) { continue; }
+      weight = free > 0 ? it->grow : (double) it->shrink * flex_basis(it, def);
+      acc += free * weight / total;
+      next = acc >= 0 ? (int) (acc + 0.5) : -(int) (-acc + 0.5);
+      target = flex_basis(it, def) + next - prev;
+      prev = next;
+      it->size = flex_clamp(it, target);
+      violation += it->size - target;
+      if (it->size != target) { it->state = it->size > target ? 2 : 3; }
+    }
+    if (violation == 0) { break; }
+
+    /* 超過した側のアイテムだけ固定して分け直す */
+    for (i = 0; i < count; i++) {
+      mu_FlexItem *it = &items[i];
+      if (it->state < 2) { continue; }
+      it->state = (it->state == 2) == (violation > 0) ? 1 : 0;
+    }
+  }
+}
+
+
+/**
+ * @brief フレックスレイアウトの開始
+ * 使い方: mu_layout_begin_flex(ctx, items, 3, MU_FLEX_ROW, 4);
+ * @param ctx MicroUIのコンテキスト
+ * @param items アイテムの配列
+ * @param count アイテム数
+ * @param direction MU_FLEX_ROWまたはMU_FLEX_COLUMN
+ * @param gap アイテム同士の間隔
+ * @return なし
+ */
+void mu_layout_begin_flex(mu_Context *ctx, mu_FlexItem *items, int count, int direction, int gap) {
+  mu_Style *style = ctx->style;
+  mu_Layout *layout;
+  mu_Rect r = mu_layout_next(ctx);
+  int i, pos, avail, def;
+
+  if (direction == MU_FLEX_ROW) {
+    avail = r.w;
+    def = style->size.x + style->padding * 2;
+  } else {
+    avail = r.h;
+    def = style->size.y + style->padding * 2;
+  }
+  flex_solve(items, count, avail - gap * mu_max(count - 1, 0), def);
+  for (i = 0, pos = 0; i < count; i++) {
+    items[i].offset = pos;
+    pos += items[i].size + gap;
+  }
+
+  push_layout(ctx, r, mu_vec2(0, 0));
+  layout = get_layout(ctx);
+  layout->flex = items;
+  layout->flex_count = count;
+  layout->flex_dir = direction;
+}
+
+
+/**
+ * @brief フレックスレイアウトの終了
+ * 使い方: mu_layout_end_flex(ctx);
+ * @param ctx MicroUIのコンテキスト
+ * @return なし
+ */
+void mu_layout_end_flex(mu_Context *ctx) {
+  mu_Layout *a, *b = get_layout(ctx);
+  mu_Rect r;
+  expect(b->flex);
+  r = b->body;
+  pop(ctx->layout_stack);
+  /* 親はフレックスの矩形の後ろへ進める（アイテムの位置は矩形の中に収まっている） */
+  a = get_layout(ctx);
+  a->resolved = 0;
+  a->position.x = mu_max(a->position.x, r.x + r.w + ctx->style->spacing - a->body.x);
+  a->next_row = mu_max(a->next_row, r.y + r.h + ctx->style->spacing - a->body.y);
+  a->max.x = mu_max(a->max.x, b->max.x);
+  a->max.y = mu_max(a->max.y, b->max.y);
+}
+
+
+/*============================================================================
+** virtual list
+**============================================================================*/
+
+/**
+ * @brief フェニック木に差分を加える（内部関数）
+ * @param list 仮想リスト
+ * @param index 行番号
+ * @param delta 送り幅の差分
+ * @return なし
+ */
+static void vlist_add(mu_VirtualList *list, int index, int delta) {
+  int k;
+  for (k = index + 1; k <= list->count; k += k & -k) {
+    list->tree[k - 1] += delta;
+  }
+}
+
+
+/**
+ * @brief 指定した距離を含む行を検索する（内部関数）
+ * フェニック木を上位ビットから辿り、累積の送り幅がoffset以下になる最大の行数を求めます。
+ * @param list 仮想リスト
+ * @param offset 先頭行からの距離
+ * @return int 行番号
+ */
+static int vlist_search(mu_VirtualList *list, int offset) {
+  int pos = 0, step = 1;
+  while (step * 2 <= list->count) { step *= 2; }
+  for (; step > 0; step /= 2) {
+    if (pos + step <= list->count && list->tree[pos + step - 1] <= offset) {
+      pos += step;
+      offset -= list->tree[pos - 1];
+    }
+  }
+  return mu_min(pos, list->count - 1);
+}
+
+
+/**
+ * @brief IDの格納位置（内部関数）
+ * @param list 仮想リスト
+ * @param id 行のID
+ * @return int slotsの位置（見つからなければ空きの位置）
+ */
+static int vlist_slot(mu_VirtualList *list, mu_Id id) {
+  int i = (int) ((id * 2654435761u) & (unsigned) list->slot_mask);
+  while (list->slots[i] && list->rows[list->slots[i] - 1].id != id) {
+    i = (i + 1) & list->slot_mask;
+  }
+  return i;
+}
+
+
+/**
+ * @brief 作成中の行の高さを測る（内部関数）
+ * 行の作成前後のレイアウト位置の差を送り幅として記録します。
+ * @param ctx MicroUIのコンテキスト
+ * @param list 仮想リスト
+ * @return なし
+ */
+static void vlist_measure(mu_Context *ctx, mu_VirtualList *list) {
+  int i = list->current;
+  int h = get_layout(ctx)->next_row - list->row_top;
+  if (i < 0) { return; }
+  if (h > 0 && h != list->rows[i].height) {
+    vlist_add(list, i, h - list->rows[i].height);
+    list->rows[i].height = h;
+  }
+  list->row_top += list->rows[i].height;
+  list->current = -1;
+}
+
+
+/**
+ * @brief 仮想リストの初期化
+ * 使い方: mu_vlist_init(&list, rows, tree, slots, 4096, 8192, 24);
+ * @param list 仮想リスト
+ * @param rows 行の配列
+ * @param tree フェニック木用の配列
+ * @param slots ID検索用の配列（要素数は2のべき乗）
+ * @param capacity rowsの要素数
+ * @param slot_count slotsの要素数
+ * @param default_height 未作成の行の推定送り幅
+ * @return なし
+ */
+void mu_vlist_init(mu_VirtualList *list, mu_VListRow *rows, int *tree, int *slots,
+  int capacity, int slot_count, int default_height)
+{
+  expect((slot_count & (slot_count - 1)) == 0 && slot_count >= capacity * 2);
+  memset(list, 0, sizeof(*list));
+  list->rows = rows;
+  list->tree = tree;
+  list->slots = slots;
+  list->capacity = capacity;
+  list->slot_mask = slot_count - 1;
+  list->default_height = mu_max(default_height, 1);
+  list->current = -1;
+  mu_vlist_clear(list);
+}
+
+
+/**
+ * @brief 仮想リストを空にする
+ * 使い方: mu_vlist_clear(&list);
+ * @param list 仮想リスト
+ * @return なし
+ */
+void mu_vlist_clear(mu_VirtualList *list) {
+  list->count = 0;
+  memset(list->slots, 0, (list->slot_mask + 1) * sizeof(int));
+}
+
+
+/**
+ * @brief 行を末尾に追加する
+ * 新しい節点が受け持つ範囲の合計は、既存の節点を上位ビットの分だけ足せば求まります。
+ * 使い方: mu_vlist_push(&list, id, 0);
+ * @param list 仮想リスト
+ * @param id 行のID
+ * @param height 送り幅（0なら推定値）
+ * @return int 追加した行番号（容量不足なら-1）
  */
-void mu_layout_row(mu_Context *ctx, int items, const int *widths, int height) {
-  mu_Layout *layout = get_layout(ctx);
-  if (widths) {
-    expect(items <= MU_MAX_WIDTHS);
-    memcpy(layout->widths, widths, items * sizeof(widths[0]));
+int mu_vlist_push(mu_VirtualList *list, mu_Id id, int height) {
+  int k = list->count + 1, j, sum;
+  if (list->count >= list->capacity) { return -1; }
+  if (height <= 0) { height = list->default_height; }
+  list->rows[list->count].id = id;
+  list->rows[list->count].height = height;
+  for (sum = height, j = 1; j < (k & -k); j *= 2) {
+    sum += list->tree[k - j - 1];
   }
-  layout->items = items;
-  layout->position = mu_vec2(layout->indent, layout->next_row);
-  layout->size.y = height;
-  layout->item_index = 0;
+  list->tree[k - 1] = sum;
+  list->slots[vlist_slot(list, id)] = k;
+  return list->count++;
 }
 
 
 /**
- * @brief レイアウトの幅を設定
- * 現在のレイアウトの幅（次のアイテムの幅）を指定します。
- * @param ctx MicroUIのコンテキスト
- * @param width 幅
- * @return なし
+ * @brief IDから行番号を検索する
+ * 使い方: i = mu_vlist_find(&list, id);
+ * @param list 仮想リスト
+ * @param id 行のID
+ * @return int 行番号（見つからなければ-1）
  */
-void mu_layout_width(mu_Context *ctx, int width) {
-  get_layout(ctx)->size.x = width;
+int mu_vlist_find(mu_VirtualList *list, mu_Id id) {
+  return list->slots[vlist_slot(list, id)] - 1;
 }
 
 
 /**
- * @brief レイアウトの高さを設定
- * 現在のレイアウトの高さ（次のアイテムの高さ）を指定します。
- * @param ctx MicroUIのコンテキスト
- * @param height 高さ
+ * @brief 行の送り幅を更新する
+ * 使い方: mu_vlist_set_height(&list, id, 48);
+ * @param list 仮想リスト
+ * @param id 行のID
+ * @param height 新しい送り幅
  * @return なし
  */
-void mu_layout_height(mu_Context *ctx, int height) {
-  get_layout(ctx)->size.y = height;
+void mu_vlist_set_height(mu_VirtualList *list, mu_Id id, int height) {
+  int i = mu_vlist_find(list, id);
+  if (i < 0) { return; }
+  height = mu_max(height, 1);
+  vlist_add(list, i, height - list->rows[i].height);
+  list->rows[i].height = height;
 }
 
 
 /**
- * @brief 次のアイテムのレイアウト位置を設定
- * 次のアイテムの位置・サイズを絶対または相対で指定します。
+ * @brief 行のy座標を取得する
+ * 使い方: y = mu_vlist_offset(&list, i);
+ * @param list 仮想リスト
+ * @param index 行番号
+ * @return int 先頭行からの距離
+ */
+int mu_vlist_offset(mu_VirtualList *list, int index) {
+  int k, sum = 0;
+  for (k = mu_min(index, list->count); k > 0; k -= k & -k) {
+    sum += list->tree[k - 1];
+  }
+  return sum;
+}
+
+
+/**
+ * @brief 仮想リストの開始
+ * 使い方: mu_vlist_begin(ctx, &list);
  * @param ctx MicroUIのコンテキスト
- * @param r 指定する矩形
- * @param relative 相対指定なら1、絶対指定なら0
+ * @param list 仮想リスト
  * @return なし
  */
-void mu_layout_set_next(mu_Context *ctx, mu_Rect r, int relative) {
+void mu_vlist_begin(mu_Context *ctx, mu_VirtualList *list) {
   mu_Layout *layout = get_layout(ctx);
-  layout->next = r;
-  layout->next_type = relative ? RELATIVE : ABSOLUTE;
+  mu_Rect clip = mu_get_clip_rect(ctx);
+  list->top = layout->next_row;
+  list->clip_bottom = clip.y + clip.h - layout->body.y;
+  list->current = -1;
+  list->next = 0;
+  if (list->count > 0) {
+    list->next = vlist_search(list, clip.y - layout->body.y - list->top);
+  }
+  list->row_top = list->top + mu_vlist_offset(list, list->next);
 }
 
 
 /**
- * @brief 次のアイテムのレイアウト矩形を取得
- * 現在のレイアウト情報から次のアイテムの位置・サイズ（矩形）を計算して返します。
- * 行のアイテム数や幅・高さ、bodyオフセット、インデントなどを考慮します。
+ * @brief 次に作成する行を取得する
+ * 使い方: while (mu_vlist_next(ctx, &list, &i)) { ... }
  * @param ctx MicroUIのコンテキスト
- * @return mu_Rect 次のアイテムの矩形
+ * @param list 仮想リスト
+ * @param index 作成する行番号の格納先
+ * @return int 作成する行があれば1
  */
-mu_Rect mu_layout_next(mu_Context *ctx) {
+int mu_vlist_next(mu_Context *ctx, mu_VirtualList *list, int *index) {
   mu_Layout *layout = get_layout(ctx);
-  mu_Style *style = ctx->style;
-  mu_Rect res;
-
-  if (layout->next_type) {
-    /* mu_layout_set_nextで設定された矩形を処理 */
-    int type = layout->next_type;
-    layout->next_type = 0;
-    res = layout->next;
-    if (type == ABSOLUTE) { return (ctx->last_rect = res); }
-
-  } else {
-    /* 次の行を処理 */
-    if (layout->item_index == layout->items) {
-      mu_layout_row(ctx, layout->items, NULL, layout->size.y);
-    }
-
-    /* 位置設定 */
-    res.x = layout->position.x;
-    res.y = layout->position.y;
+  vlist_measure(ctx, list);
+  if (list->next >= list->count || list->row_top >= list->clip_bottom) { return 0; }
+  /* 行の上端から新しいレイアウト行を始める */
+  layout->next_row = list->row_top;
+  layout->item_index = layout->items;
+  *index = list->current = list->next++;
+  return 1;
+}
 
-    /* サイズ設定 */
-    res.w = layout->items > 0 ? layout->widths[layout->item_index] : layout->size.x;
-    res.h = layout->size.y;
-    if (res.w == 0) { res.w = style->size.x + style->padding * 2; }
-    if (res.h == 0) { res.h = style->size.y + style->padding * 2; }
-    if (res.w <  0) { res.w += layout->body.w - res.x + 1; }
-    if (res.h <  0) { res.h += layout->body.h - res.y + 1; }
 
-    layout->item_index++;
+/**
+ * @brief 仮想リストの終了
+ * 使い方: mu_vlist_end(ctx, &list);
+ * @param ctx MicroUIのコンテキスト
+ * @param list 仮想リスト
+ * @return なし
+ */
+void mu_vlist_end(mu_Context *ctx, mu_VirtualList *list) {
+  mu_Layout *layout = get_layout(ctx);
+  int bottom;
+  vlist_measure(ctx, list);
+  bottom = list->top + mu_vlist_offset(list, list->count);
+  layout->next_row = mu_max(layout->next_row, bottom);
+  layout->item_index = layout->items;
+  if (list->count > 0) {
+    layout->max.y = mu_max(layout->max.y, layout->body.y + bottom - ctx->style->spacing);
   }
-
-  /* 位置更新 */
-  layout->position.x += res.w + style->spacing;
-  layout->next_row = mu_max(layout->next_row, res.y + res.h + style->spacing);
-
-  /* bodyオフセット適用 */
-  res.x += layout->body.x;
-  res.y += layout->body.y;
-
-  /* 最大位置更新 */
-  layout->max.x = mu_max(layout->max.x, res.x + res.w);
-  layout->max.y = mu_max(layout->max.y, res.y + res.h);
-
-  return (ctx->last_rect = res);
 }
 
 
@@ -991,7 +2711,11 @@ void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect,
 {
   mu_Vec2 pos;
   mu_Font font = ctx->style->font;
-  int tw = ctx->text_width(font, str, -1);
+  int tw;
+  if (mu_check_clip(ctx, rect) == MU_CLIP_ALL) { return; }
+  mu_profile_begin("text width");
+  tw = text_width(ctx, font, str, -1);
+  mu_profile_end();
   mu_push_clip_rect(ctx, rect);
   pos.y = rect.y + (rect.h - ctx->text_height(font)) / 2;
   if (opt & MU_OPT_ALIGNCENTER) {
@@ -1006,6 +2730,63 @@ void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect,
 }
 
 
+/**
+ * @brief 見えないウィジェットの判定（内部関数）
+ * 直前のmu_layout_nextの矩形がクリップ矩形の完全に外側なら、入力処理と描画を省略できます。
+ * フォーカス中のウィジェットはドラッグや入力を続けられるよう通常どおり処理します。
+ * @param ctx MicroUIのコンテキスト
+ * @param id コントロールID
+ * @return int 省略してよければ1
+ */
+static int culled(mu_Context *ctx, mu_Id id) {
+  if (!ctx->culled || ctx->focus == id) { return 0; }
+  if (ctx->hover == id) { ctx->hover = 0; }
+  return 1;
+}
+
+
+/**
+ * @brief ヒットテスト用にコントロールを記録（内部関数）
+ * クリップ矩形で切り取った矩形と、属するルートコンテナを記録します。
+ * 見えない部分しかないコントロールや、MU_HITLIST_SIZEを超えた分は記録しません。
+ * @param ctx MicroUIのコンテキスト
+ * @param id コントロールID
+ * @param rect コントロール矩形
+ * @return なし
+ */
+static void record_hit(mu_Context *ctx, mu_Id id, mu_Rect rect) {
+  mu_HitItem *it;
+  int i = ctx->container_stack.idx;
+  rect = intersect_rects(rect, mu_get_clip_rect(ctx));
+  if (rect.w <= 0 || rect.h <= 0 || ctx->hit_count == MU_HITLIST_SIZE || ctx->measuring) { return; }
+  it = &ctx->hit_items[ctx->hit_count++];
+  it->id = id;
+  it->rect = rect;
+  it->kind = MU_HIT_CONTROL;
+  it->root = NULL;
+  /* ルートコンテナのみheadフィールドがセットされる */
+  while (i--) {
+    if (ctx->container_stack.items[i]->head) { it->root = ctx->container_stack.items[i]; break; }
+  }
+}
+
+
+/**
+ * @brief 記録したコントロールの種類を設定（内部関数）
+ * 直前にmu_update_controlで記録したコントロールがidなら種類を設定します。
+ * @param ctx MicroUIのコンテキスト
+ * @param id コントロールID
+ * @param kind MU_HIT_*
+ * @return なし
+ */
+static void set_hit_kind(mu_Context *ctx, mu_Id id, int kind) {
+  mu_HitItem *it;
+  if (ctx->hit_count == 0) { return; }
+  it = &ctx->hit_items[ctx->hit_count - 1];
+  if (it->id == id) { it->kind = kind; }
+}
+
+
 /**
  * @brief マウスオーバー判定
  * マウスが指定矩形上にあるか判定します。
@@ -1015,6 +2796,7 @@ void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect,
  * @return int マウスが矩形上にあれば1、そうでなければ0
  */
 int mu_mouse_over(mu_Context *ctx, mu_Rect rect) {
+  ctx->stats.hover_tests++;
   return rect_overlaps_vec2(rect, ctx->mouse_pos) &&
     rect_overlaps_vec2(mu_get_clip_rect(ctx), ctx->mouse_pos) &&
     in_hover_root(ctx);
@@ -1032,10 +2814,15 @@ int mu_mouse_over(mu_Context *ctx, mu_Rect rect) {
  * @return なし
  */
 void mu_update_control(mu_Context *ctx, mu_Id id, mu_Rect rect, int opt) {
-  int mouseover = mu_mouse_over(ctx, rect);
+  int mouseover;
+  if (ctx->measuring) { return; }
+  check_control_id(ctx, id);
+  mouseover = mu_mouse_over(ctx, rect);
 
   if (ctx->focus == id) { ctx->updated_focus = 1; }
   if (opt & MU_OPT_NOINTERACT) { return; }
+  mu_profile_begin("hover");
+  record_hit(ctx, id, rect);
   if (mouseover && !ctx->mouse_down) { ctx->hover = id; }
 
   if (ctx->focus == id) {
@@ -1050,6 +2837,7 @@ void mu_update_control(mu_Context *ctx, mu_Id id, mu_Rect rect, int opt) {
       ctx->hover = 0;
     }
   }
+  mu_profile_end();
 }
 
 
@@ -1072,15 +2860,19 @@ void mu_text(mu_Context *ctx, const char *text) {
     mu_Rect r = mu_layout_next(ctx);
     int w = 0;
     start = end = p;
+    mu_profile_begin("text width");
     do {
       const char* word = p;
       while (*p && *p != ' ' && *p != '\n') { p++; }
-      w += ctx->text_width(font, word, p - word);
+      w += text_width(ctx, font, word, p - word);
       if (w > r.w && end != start) { break; }
-      w += ctx->text_width(font, p, 1);
+      w += text_width(ctx, font, p, 1);
       end = p++;
     } while (*end && *end != '\n');
-    mu_draw_text(ctx, font, start, end - start, mu_vec2(r.x, r.y), color);
+    mu_profile_end();
+    if (!ctx->culled) {
+      mu_draw_text(ctx, font, start, end - start, mu_vec2(r.x, r.y), color);
+    }
     p = end + 1;
   } while (*end);
   mu_layout_end_column(ctx);
@@ -1113,9 +2905,12 @@ void mu_label(mu_Context *ctx, const char *text) {
 int mu_button_ex(mu_Context *ctx, const char *label, int icon, int opt) {
   int res = 0;
   mu_Id id = label ? mu_get_id(ctx, label, strlen(label))
-                   : mu_get_id(ctx, &icon, sizeof(icon));
+                   : mu_get_id_int(ctx, icon);
   mu_Rect r = mu_layout_next(ctx);
+  if (culled(ctx, id)) { return res; }
+  mu_profile_begin("button");
   mu_update_control(ctx, id, r, opt);
+  set_hit_kind(ctx, id, MU_HIT_BUTTON);
   /* クリック処理 */
   if (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id) {
     res |= MU_RES_SUBMIT;
@@ -1124,6 +2919,7 @@ int mu_button_ex(mu_Context *ctx, const char *label, int icon, int opt) {
   mu_draw_control_frame(ctx, id, r, MU_COLOR_BUTTON, opt);
   if (label) { mu_draw_control_text(ctx, label, r, MU_COLOR_TEXT, opt); }
   if (icon) { mu_draw_icon(ctx, icon, r, ctx->style->colors[MU_COLOR_TEXT]); }
+  mu_profile_end();
   return res;
 }
 
@@ -1139,10 +2935,13 @@ int mu_button_ex(mu_Context *ctx, const char *label, int icon, int opt) {
  */
 int mu_checkbox(mu_Context *ctx, const char *label, int *state) {
   int res = 0;
-  mu_Id id = mu_get_id(ctx, &state, sizeof(state));
+  mu_Id id = mu_get_id_ptr(ctx, state);
   mu_Rect r = mu_layout_next(ctx);
   mu_Rect box = mu_rect(r.x, r.y, r.h, r.h);
+  if (culled(ctx, id)) { return res; }
+  mu_profile_begin("checkbox");
   mu_update_control(ctx, id, r, 0);
+  set_hit_kind(ctx, id, MU_HIT_CHECKBOX);
   /* クリック処理 */
   if (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id) {
     res |= MU_RES_CHANGE;
@@ -1155,6 +2954,7 @@ int mu_checkbox(mu_Context *ctx, const char *label, int *state) {
   }
   r = mu_rect(r.x + box.w, r.y, r.w - box.w, r.h);
   mu_draw_control_text(ctx, label, r, MU_COLOR_TEXT, 0);
+  mu_profile_end();
   return res;
 }
 
@@ -1175,7 +2975,9 @@ int mu_textbox_raw(mu_Context *ctx, char *buf, int bufsz, mu_Id id, mu_Rect r,
   int opt)
 {
   int res = 0;
+  mu_profile_begin("textbox");
   mu_update_control(ctx, id, r, opt | MU_OPT_HOLDFOCUS);
+  set_hit_kind(ctx, id, MU_HIT_TEXTBOX);
 
   if (ctx->focus == id) {
     /* テキスト入力処理 */
@@ -1206,11 +3008,14 @@ int mu_textbox_raw(mu_Context *ctx, char *buf, int bufsz, mu_Id id, mu_Rect r,
   if (ctx->focus == id) {
     mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
     mu_Font font = ctx->style->font;
-    int textw = ctx->text_width(font, buf, -1);
     int texth = ctx->text_height(font);
-    int ofx = r.w - ctx->style->padding - textw - 1;
-    int textx = r.x + mu_min(ofx, ctx->style->padding);
     int texty = r.y + (r.h - texth) / 2;
+    int textw, ofx, textx;
+    mu_profile_begin("text width");
+    textw = text_width(ctx, font, buf, -1);
+    mu_profile_end();
+    ofx = r.w - ctx->style->padding - textw - 1;
+    textx = r.x + mu_min(ofx, ctx->style->padding);
     mu_push_clip_rect(ctx, r);
     mu_draw_text(ctx, font, buf, -1, mu_vec2(textx, texty), color);
     mu_draw_rect(ctx, mu_rect(textx + textw, texty, 1, texth), color);
@@ -1218,6 +3023,7 @@ int mu_textbox_raw(mu_Context *ctx, char *buf, int bufsz, mu_Id id, mu_Rect r,
   } else {
     mu_draw_control_text(ctx, buf, r, MU_COLOR_TEXT, opt);
   }
+  mu_profile_end();
 
   return res;
 }
@@ -1265,8 +3071,9 @@ static int number_textbox(mu_Context *ctx, mu_Real *value, mu_Rect r, mu_Id id)
  * @return int 入力変化時MU_RES_CHANGE、確定時MU_RES_SUBMIT
  */
 int mu_textbox_ex(mu_Context *ctx, char *buf, int bufsz, int opt) {
-  mu_Id id = mu_get_id(ctx, &buf, sizeof(buf));
+  mu_Id id = mu_get_id_ptr(ctx, buf);
   mu_Rect r = mu_layout_next(ctx);
+  if (culled(ctx, id)) { return 0; }
   return mu_textbox_raw(ctx, buf, bufsz, id, r, opt);
 }
 
@@ -1290,21 +3097,27 @@ int mu_slider_ex(mu_Context *ctx, mu_Real *value, mu_Real low, mu_Real high, mu_
   mu_Rect thumb;
   int x, w, res = 0;
   mu_Real last = *value, v = last;
-  mu_Id id = mu_get_id(ctx, &value, sizeof(value));
+  mu_Id id = mu_get_id_ptr(ctx, value);
   mu_Rect base = mu_layout_next(ctx);
+  if (culled(ctx, id)) { return res; }
+  mu_profile_begin("slider");
 
   /* テキスト入力モードの処理 */
-  if (number_textbox(ctx, &v, base, id)) { return res; }
+  if (number_textbox(ctx, &v, base, id)) {
+    mu_profile_end();
+    return res;
+  }
 
   /* 通常モードの処理 */
   mu_update_control(ctx, id, base, opt);
+  set_hit_kind(ctx, id, MU_HIT_SLIDER);
 
   /* 入力処理 */
   if (ctx->focus == id &&
       (ctx->mouse_down | ctx->mouse_pressed) == MU_MOUSE_LEFT)
   {
     v = low + (ctx->mouse_pos.x - base.x) * (high - low) / base.w;
-    if (step) { v = ((__int64)((v + step / 2) / step)) * step; }
+    if (step) { v = ((mu_int64)((v + step / 2) / step)) * step; }
   }
   /* 値を制約し保存、resを更新 */
   *value = v = mu_clamp(v, low, high);
@@ -1320,6 +3133,7 @@ int mu_slider_ex(mu_Context *ctx, mu_Real *value, mu_Real low, mu_Real high, mu_
   /* テキストを描画 */
   sprintf(buf, fmt, v);
   mu_draw_control_text(ctx, buf, base, MU_COLOR_TEXT, opt);
+  mu_profile_end();
 
   return res;
 }
@@ -1340,15 +3154,21 @@ int mu_number_ex(mu_Context *ctx, mu_Real *value, mu_Real step, const char *fmt,
 {
   char buf[MU_MAX_FMT + 1];
   int res = 0;
-  mu_Id id = mu_get_id(ctx, &value, sizeof(value));
+  mu_Id id = mu_get_id_ptr(ctx, value);
   mu_Rect base = mu_layout_next(ctx);
   mu_Real last = *value;
+  if (culled(ctx, id)) { return res; }
+  mu_profile_begin("number");
 
   /* テキスト入力モードの処理 */
-  if (number_textbox(ctx, value, base, id)) { return res; }
+  if (number_textbox(ctx, value, base, id)) {
+    mu_profile_end();
+    return res;
+  }
 
   /* 通常モードの処理 */
   mu_update_control(ctx, id, base, opt);
+  set_hit_kind(ctx, id, MU_HIT_NUMBER);
 
   /* 入力処理 */
   if (ctx->focus == id && ctx->mouse_down == MU_MOUSE_LEFT) {
@@ -1362,6 +3182,7 @@ int mu_number_ex(mu_Context *ctx, mu_Real *value, mu_Real step, const char *fmt,
   /* テキストを描画 */
   sprintf(buf, fmt, *value);
   mu_draw_control_text(ctx, buf, base, MU_COLOR_TEXT, opt);
+  mu_profile_end();
 
   return res;
 }
@@ -1379,7 +3200,7 @@ int mu_number_ex(mu_Context *ctx, mu_Real *value, mu_Real step, const char *fmt,
  */
 static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
   mu_Rect r;
-  int active, expanded;
+  int active, expanded, hidden;
   mu_Id id = mu_get_id(ctx, label, strlen(label));
   int idx = mu_pool_get(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
   int width = -1;
@@ -1388,7 +3209,11 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
   active = (idx >= 0);
   expanded = (opt & MU_OPT_EXPANDED) ? !active : active;
   r = mu_layout_next(ctx);
-  mu_update_control(ctx, id, r, 0);
+  hidden = culled(ctx, id);
+  if (!hidden) {
+    mu_update_control(ctx, id, r, 0);
+    set_hit_kind(ctx, id, MU_HIT_HEADER);
+  }
 
   /* クリック処理 */
   active ^= (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id);
@@ -1401,7 +3226,8 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
     mu_pool_init(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
   }
 
-  /* 描画 */
+  /* 描画（見えなければ開閉状態の更新だけ行う） */
+  if (hidden) { return expanded ? MU_RES_ACTIVE : 0; }
   if (istreenode) {
     if (ctx->hover == id) { ctx->draw_frame(ctx, r, MU_COLOR_BUTTONHOVER); }
   } else {
@@ -1446,6 +3272,7 @@ int mu_begin_treenode_ex(mu_Context *ctx, const char *label, int opt) {
   if (res & MU_RES_ACTIVE) {
     get_layout(ctx)->indent += ctx->style->indent;
     push(ctx->id_stack, ctx->last_id);
+    track_depth(ctx->stats.max_id_depth, ctx->id_stack);
   }
   return res;
 }
@@ -1464,6 +3291,412 @@ void mu_end_treenode(mu_Context *ctx) {
 }
 
 
+/*============================================================================
+** table
+**============================================================================*/
+
+/**
+ * @brief 行の比較（内部関数）
+ * 比較結果が等しい行は元の行番号順にして、結果を毎回同じにします。
+ * @param t 表
+ * @param ra 行番号
+ * @param rb 行番号
+ * @return int raが先なら負、rbが先なら正
+ */
+static int compare_rows(mu_Table *t, int ra, int rb) {
+  int res = t->compare(t->udata, t->sort_column, ra, rb);
+  if (t->sort_desc) { res = -res; }
+  return res ? res : ra - rb;
+}
+
+
+/**
+ * @brief ヒープの整列（内部関数）
+ * order[root]を子と比べて下ろし、order[0..n)のうちrootより下をヒープに戻します。
+ */
+static void sift_rows(mu_Table *t, int root, int n) {
+  int *order = t->order;
+  for (;;) {
+    int child = root * 2 + 1, tmp;
+    if (child >= n) { return; }
+    if (child + 1 < n && compare_rows(t, order[child], order[child + 1]) < 0) { child++; }
+    if (compare_rows(t, order[root], order[child]) >= 0) { return; }
+    tmp = order[root]; order[root] = order[child]; order[child] = tmp;
+    root = child;
+  }
+}
+
+
+/**
+ * @brief 行番号の並べ替え（内部関数）
+ * 表を引数で渡すヒープソートなので、静的な状態を持たず、別スレッドや入れ子で
+ * 呼ばれても安全です。compare_rowsは同じ値の行も行番号で順序を決めるので、
+ * 安定ソートでなくても結果は毎回同じになります。作業領域も要りません。
+ * @param t 表（orderの先頭row_count個を並べ替える）
+ * @return なし
+ */
+static void sort_rows(mu_Table *t) {
+  int i, tmp, n = t->row_count;
+  for (i = n / 2 - 1; i >= 0; i--) { sift_rows(t, i, n); }
+  for (i = n - 1; i > 0; i--) {
+    tmp = t->order[0]; t->order[0] = t->order[i]; t->order[i] = tmp;
+    sift_rows(t, 0, i);
+  }
+}
+
+
+/**
+ * @brief 表示順の更新（内部関数）
+ * データのバージョン・並べ替える列・行数のいずれかが変わった時だけ作り直します。
+ * @param table 表
+ * @param version データのバージョン
+ * @return なし
+ */
+static void update_table_order(mu_Table *table, int version) {
+  int i;
+  if (!table->order) { return; }
+  if (table->sorted_version == version && table->sorted_rows == table->row_count &&
+      table->sorted_column == table->sort_column && table->sorted_desc == table->sort_desc
+  ) {
+    return;
+  }
+  for (i = 0; i < table->row_count; i++) { table->order[i] = i; }
+  if (table->compare && table->sort_column >= 0) {
+    sort_rows(table);
+  }
+  table->sorted_version = version;
+  table->sorted_rows = table->row_count;
+  table->sorted_column = table->sort_column;
+  table->sorted_desc = table->sort_desc;
+}
+
+
+/**
+ * @brief 指定した位置にかかる列を検索（内部関数）
+ * 列の位置は昇順なので二分探索で求めます。
+ * @param table 表
+ * @param x 表の左端からの位置
+ * @return int x < 右端となる最初の列
+ */
+static int find_table_column(mu_Table *table, int x) {
+  int lo = 0, hi = table->column_count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    mu_TableColumn *col = &table->columns[mid];
+    if (col->x + col->width <= x) { lo = mid + 1; } else { hi = mid; }
+  }
+  return lo;
+}
+
+
+/**
+ * @brief 表の初期化
+ * 使い方: mu_table_init(&table, columns, 50, order, compare, data);
+ * @param table 表
+ * @param columns 列の配列
+ * @param column_count 列数
+ * @param order 表示順の行番号を入れる配列
+ * @param compare 比較関数
+ * @param udata 比較関数に渡すデータ
+ * @return なし
+ */
+void mu_table_init(mu_Table *table, mu_TableColumn *columns, int column_count,
+  int *order, mu_TableCompare compare, void *udata)
+{
+  memset(table, 0, sizeof(*table));
+  table->columns = columns;
+  table->column_count = column_count;
+  table->order = order;
+  table->compare = compare;
+  table->udata = udata;
+  table->sort_column = -1;
+  table->sorted_version = -1;
+  table->sorted_rows = -1;
+}
+
+
+/**
+ * @brief 表の開始
+ * 使い方: mu_begin_table(ctx, &table, rows, version, 0);
+ * @param ctx MicroUIのコンテキスト
+ * @param table 表
+ * @param rows 行数
+ * @param version データのバージョン
+ * @param opt オプション
+ * @return なし
+ */
+void mu_begin_table(mu_Context *ctx, mu_Table *table, int rows, int version, int opt) {
+  mu_Layout *layout = get_layout(ctx);
+  mu_Rect clip = mu_get_clip_rect(ctx);
+  int i, x = 0, top, rh;
+
+  table->opt = opt;
+  table->row_count = rows;
+  table->header_height = ctx->style->size.y + ctx->style->padding * 2;
+  if (table->row_height <= 0) { table->row_height = table->header_height; }
+  rh = table->row_height;
+  table->origin = mu_vec2(layout->body.x + layout->indent, layout->body.y + layout->next_row);
+
+  /* 列の位置 */
+  for (i = 0; i < table->column_count; i++) {
+    table->columns[i].x = x;
+    x += table->columns[i].width;
+  }
+  table->width = x;
+
+  update_table_order(table, version);
+
+  /* 見えている行（行の間隔は一定） */
+  top = table->origin.y + table->header_height;
+  table->row_start = mu_clamp((clip.y - top) / rh, 0, rows);
+  table->row_end = mu_clamp((clip.y + clip.h - top + rh - 1) / rh, table->row_start, rows);
+
+  /* 見えている列 */
+  table->col_start = find_table_column(table, clip.x - table->origin.x);
+  table->col_end = find_table_column(table, clip.x + clip.w - table->origin.x);
+  if (table->col_end < table->column_count &&
+      table->columns[table->col_end].x < clip.x + clip.w - table->origin.x
+  ) {
+    table->col_end++;
+  }
+}
+
+
+/**
+ * @brief 表のセルをレイアウトに設定する
+ * 使い方: mu_table_cell(ctx, &table, r, c);
+ * @param ctx MicroUIのコンテキスト
+ * @param table 表
+ * @param r 表示順の行番号
+ * @param c 列番号
+ * @return mu_Rect セルの矩形
+ */
+mu_Rect mu_table_cell(mu_Context *ctx, mu_Table *table, int r, int c) {
+  mu_Rect rect = mu_rect(
+    table->origin.x + table->columns[c].x,
+    table->origin.y + table->header_height + r * table->row_height,
+    table->columns[c].width, table->row_height);
+  mu_layout_set_next(ctx, rect, 0);
+  return rect;
+}
+
+
+/**
+ * @brief 表示順から元データの行番号を取得する
+ * 使い方: row = mu_table_row(&table, r);
+ * @param table 表
+ * @param r 表示順の行番号
+ * @return int 元データの行番号
+ */
+int mu_table_row(mu_Table *table, int r) {
+  return table->order ? table->order[r] : r;
+}
+
+
+/**
+ * @brief 表の終了
+ * 見出しはセルより後に描画して、スクロール時にセルの上に重ねます。
+ * 使い方: mu_end_table(ctx, &table);
+ * @param ctx MicroUIのコンテキスト
+ * @param table 表
+ * @return なし
+ */
+void mu_end_table(mu_Context *ctx, mu_Table *table) {
+  mu_Layout *layout = get_layout(ctx);
+  mu_Rect clip = mu_get_clip_rect(ctx);
+  int hh = table->header_height;
+  int bottom = table->origin.y + hh + table->row_count * table->row_height;
+  int y = mu_clamp(clip.y, table->origin.y, mu_max(table->origin.y, bottom - hh));
+  int c;
+
+  mu_push_id_ptr(ctx, table);
+  for (c = table->col_start; c < table->col_end; c++) {
+    mu_TableColumn *col = &table->columns[c];
+    mu_Rect r = mu_rect(table->origin.x + col->x, y, col->width, hh);
+    mu_Id id;
+    mu_push_id_int(ctx, c);
+    id = mu_get_id(ctx, "!header", 7);
+
+    /* 列幅の変更（見出しの右端をドラッグ） */
+    if (~table->opt & MU_OPT_NORESIZE) {
+      int sz = ctx->style->padding;
+      mu_Id rid = mu_get_id(ctx, "!resize", 7);
+      mu_Rect handle = mu_rect(r.x + r.w - sz, r.y, sz, r.h);
+      mu_update_control(ctx, rid, handle, 0);
+      if (rid == ctx->focus && ctx->mouse_down == MU_MOUSE_LEFT) {
+        col->width = mu_max(sz * 2, col->width + ctx->mouse_delta.x);
+      }
+      r.w -= sz;
+    }
+
+    /* クリックで並べ替え（同じ列なら昇順・降順を切り替える） */
+    mu_update_control(ctx, id, r, 0);
+    if (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id && table->compare) {
+      table->sort_desc = (table->sort_column == c) ? !table->sort_desc : 0;
+      table->sort_column = c;
+    }
+    mu_draw_control_frame(ctx, id, r, MU_COLOR_BUTTON, 0);
+    if (col->title) { mu_draw_control_text(ctx, col->title, r, MU_COLOR_TEXT, 0); }
+    if (table->sort_column == c) {
+      mu_Rect ir = mu_rect(r.x + r.w - r.h, r.y, r.h, r.h);
+      mu_draw_icon(ctx, table->sort_desc ? MU_ICON_EXPANDED : MU_ICON_COLLAPSED, ir,
+        ctx->style->colors[MU_COLOR_TEXT]);
+    }
+    mu_pop_id(ctx);
+  }
+  mu_pop_id(ctx);
+
+  /* 表全体の大きさだけレイアウトを進める */
+  layout->next_row = mu_max(layout->next_row, bottom - layout->body.y + ctx->style->spacing);
+  layout->item_index = layout->items;
+  layout->max.x = mu_max(layout->max.x, table->origin.x + table->width);
+  layout->max.y = mu_max(layout->max.y, bottom);
+}
+
+
+/*============================================================================
+** tree view
+**============================================================================*/
+
+/**
+ * @brief ツリーの初期化
+ * 使い方: mu_tree_init(&tree, rows, 65536, &source, root);
+ * @param tree ツリー
+ * @param rows 行の配列
+ * @param capacity 行の配列の要素数
+ * @param source データ取得用コールバック
+ * @param root 根のノード
+ * @return なし
+ */
+void mu_tree_init(mu_TreeView *tree, mu_TreeRow *rows, int capacity, const mu_TreeSource *source, mu_Id root) {
+  int i, n;
+  memset(tree, 0, sizeof(*tree));
+  tree->source = *source;
+  tree->root = root;
+  tree->rows = rows;
+  tree->capacity = capacity;
+  n = mu_min(source->child_count(source->udata, root), capacity);
+  for (i = 0; i < n; i++) {
+    rows[i].node = source->child(source->udata, root, i);
+    rows[i].depth = 0;
+    rows[i].expanded = 0;
+  }
+  tree->count = n;
+}
+
+
+/**
+ * @brief 行の展開
+ * 使い方: mu_tree_expand(&tree, i);
+ * @param tree ツリー
+ * @param index 行番号
+ * @return int 展開できれば1
+ */
+int mu_tree_expand(mu_TreeView *tree, int index) {
+  mu_TreeSource *src = &tree->source;
+  mu_TreeRow *row = &tree->rows[index];
+  int i, n;
+  if (row->expanded) { return 0; }
+  n = src->child_count(src->udata, row->node);
+  if (n <= 0 || tree->count + n > tree->capacity) { return 0; }
+  memmove(row + 1 + n, row + 1, (tree->count - index - 1) * sizeof(mu_TreeRow));
+  for (i = 0; i < n; i++) {
+    row[1 + i].node = src->child(src->udata, row->node, i);
+    row[1 + i].depth = row->depth + 1;
+    row[1 + i].expanded = 0;
+  }
+  row->expanded = 1;
+  tree->count += n;
+  return 1;
+}
+
+
+/**
+ * @brief 行の折りたたみ
+ * 使い方: mu_tree_collapse(&tree, i);
+ * @param tree ツリー
+ * @param index 行番号
+ * @return なし
+ */
+void mu_tree_collapse(mu_TreeView *tree, int index) {
+  mu_TreeRow *row = &tree->rows[index];
+  int end = index + 1;
+  if (!row->expanded) { return; }
+  while (end < tree->count && tree->rows[end].depth > row->depth) { end++; }
+  memmove(row + 1, &tree->rows[end], (tree->count - end) * sizeof(mu_TreeRow));
+  tree->count -= end - index - 1;
+  row->expanded = 0;
+}
+
+
+/**
+ * @brief ツリーの描画・操作
+ * 行の高さは一定なのでmu_list_clipperで見えている行を求めます。
+ * 展開・折りたたみは行の配列が変わるため、描画が終わってから反映します。
+ * 使い方: res = mu_tree_view(ctx, &tree);
+ * @param ctx MicroUIのコンテキスト
+ * @param tree ツリー
+ * @return int MU_RES_CHANGE / MU_RES_SUBMIT
+ */
+int mu_tree_view(mu_Context *ctx, mu_TreeView *tree) {
+  mu_TreeSource *src = &tree->source;
+  mu_ListClipper clipper;
+  int i, res = 0, toggle = -1, width = -1;
+
+  mu_push_id_ptr(ctx, tree);
+  mu_layout_row(ctx, 1, &width, tree->row_height);
+  mu_list_clipper_begin(ctx, &clipper, tree->count, tree->row_height);
+  for (i = clipper.start; i < clipper.end; i++) {
+    mu_TreeRow *row = &tree->rows[i];
+    mu_Rect r = mu_layout_next(ctx);
+    mu_Rect arrow;
+    mu_Id id = mu_get_id_int(ctx, (int) row->node);
+    int leaf = !row->expanded && src->child_count(src->udata, row->node) <= 0;
+
+    r.x += row->depth * ctx->style->indent;
+    r.w -= row->depth * ctx->style->indent;
+    arrow = mu_rect(r.x, r.y, r.h, r.h);
+    mu_update_control(ctx, id, r, 0);
+
+    /* クリック処理（矢印なら展開・折りたたみ、それ以外は選択） */
+    if (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id) {
+      if (!leaf && rect_overlaps_vec2(arrow, ctx->mouse_pos)) {
+        toggle = i;
+      } else {
+        tree->selected = row->node;
+        res |= MU_RES_SUBMIT;
+      }
+    }
+
+    /* 描画 */
+    if (tree->selected == row->node) {
+      ctx->draw_frame(ctx, r, MU_COLOR_BUTTONFOCUS);
+    } else if (ctx->hover == id) {
+      ctx->draw_frame(ctx, r, MU_COLOR_BUTTONHOVER);
+    }
+    if (!leaf) {
+      mu_draw_icon(ctx, row->expanded ? MU_ICON_EXPANDED : MU_ICON_COLLAPSED,
+        arrow, ctx->style->colors[MU_COLOR_TEXT]);
+    }
+    r.x += r.h - ctx->style->padding;
+    r.w -= r.h - ctx->style->padding;
+    mu_draw_control_text(ctx, src->label(src->udata, row->node), r, MU_COLOR_TEXT, 0);
+  }
+  mu_list_clipper_end(ctx, &clipper);
+  mu_pop_id(ctx);
+
+  if (toggle >= 0) {
+    if (tree->rows[toggle].expanded) {
+      mu_tree_collapse(tree, toggle);
+    } else {
+      mu_tree_expand(tree, toggle);
+    }
+    res |= MU_RES_CHANGE;
+  }
+  return res;
+}
+
+
 #define scrollbar(ctx, cnt, b, cs, x, y, w, h)                              \
   do {                                                                      \
     /* コンテンツサイズがボディより大きい場合のみスクロールバーを追加 */            \
@@ -1548,6 +3781,7 @@ static void push_container_body(
 
 static void begin_root_container(mu_Context *ctx, mu_Container *cnt) {
   push(ctx->container_stack, cnt);
+  track_depth(ctx->stats.max_container_depth, ctx->container_stack);
   /* ルートリストにコンテナを追加し、headコマンドをプッシュ */
   push(ctx->root_list, cnt);
   cnt->head = push_jump(ctx, NULL);
@@ -1560,6 +3794,7 @@ static void begin_root_container(mu_Context *ctx, mu_Container *cnt) {
   /* ルートコンテナのbegin/endブロック内でさらにルートコンテナが作られた場合、
   ** 内側のルートコンテナが外側にクリップされないようにクリッピングをリセット */
   push(ctx->clip_stack, unclipped_rect);
+  track_depth(ctx->stats.max_clip_depth, ctx->clip_stack);
 }
 
 /**
@@ -1593,18 +3828,31 @@ int mu_begin_window_ex(mu_Context* ctx, const char* title, mu_Rect rect, int opt
 {
     mu_Rect body;
     mu_Id id = mu_get_id(ctx, title, strlen(title));  // ウィンドウタイトルからIDを生成
-    mu_Container* cnt = get_container(ctx, id, opt);  // コンテナを取得または初期化
+    mu_Container* cnt;
+    if (ctx->measuring && ~opt & MU_OPT_AUTOSIZE) { return 0; }  // 計測パスではAUTOSIZEのウィンドウだけ処理
+    cnt = get_container(ctx, id, opt);  // コンテナを取得または初期化
     if (!cnt || !cnt->open) { return 0; }  // コンテナが無効または閉じている場合は終了
     push(ctx->id_stack, id);  // コンテナIDをIDスタックにプッシュ
+    track_depth(ctx->stats.max_id_depth, ctx->id_stack);
+    trace_event(ctx, title, 1);  // mu_end_windowで終了
+    mu_profile_begin("window");  // 枠・タイトルバー・リサイズハンドルの処理
 
     if (cnt->rect.w == 0) { cnt->rect = rect; }  // 初回のみ矩形を設定
     begin_root_container(ctx, cnt);  // ルートコンテナの開始
     rect = body = cnt->rect;  // コンテナの矩形を設定
+    record_hit(ctx, id, rect);  // 下のウィンドウのコントロールを隠すためにウィンドウ自体も記録
+    set_hit_kind(ctx, id, MU_HIT_WINDOW);
 
     /* フレーム描画 */
+    cnt->opaque = mu_rect(0, 0, 0, 0);
     if (~opt & MU_OPT_NOFRAME)
     {
         ctx->draw_frame(ctx, rect, MU_COLOR_WINDOWBG);  // ウィンドウ背景描画
+        /* 標準の枠描画で背景が不透明なら、下のウィンドウを隠す矩形として記録 */
+        if (ctx->draw_frame == draw_frame && ctx->style->colors[MU_COLOR_WINDOWBG].a == 255)
+        {
+            cnt->opaque = rect;
+        }
     }
 
     /* タイトルバー描画 */
@@ -1674,6 +3922,7 @@ int mu_begin_window_ex(mu_Context* ctx, const char* title, mu_Rect rect, int opt
         cnt->open = 0;  // 他の場所クリックでポップアップを閉じる
     }
 
+    mu_profile_end();
     mu_push_clip_rect(ctx, cnt->body);  // ボディ部分のクリッピング設定
     return MU_RES_ACTIVE;  // ウィンドウがアクティブならMU_RES_ACTIVEを返す
 }
@@ -1687,8 +3936,16 @@ int mu_begin_window_ex(mu_Context* ctx, const char* title, mu_Rect rect, int opt
  * @return なし
  */
 void mu_end_window(mu_Context *ctx) {
+  mu_Container *cnt = mu_get_current_container(ctx);
+  mu_Rect body = get_layout(ctx)->body;
   mu_pop_clip_rect(ctx);
   end_root_container(ctx);
+  /* 計測パスでは、計測したコンテンツサイズに合わせて大きさをすぐに決める */
+  if (ctx->measuring) {
+    cnt->rect.w = cnt->content_size.x + (cnt->rect.w - body.w);
+    cnt->rect.h = cnt->content_size.y + (cnt->rect.h - body.h);
+  }
+  trace_event(ctx, NULL, 0);
 }
 
 
@@ -1756,6 +4013,7 @@ void mu_begin_panel_ex(mu_Context *ctx, const char *name, int opt) {
     ctx->draw_frame(ctx, cnt->rect, MU_COLOR_PANELBG);
   }
   push(ctx->container_stack, cnt);
+  track_depth(ctx->stats.max_container_depth, ctx->container_stack);
   push_container_body(ctx, cnt, cnt->rect, opt);
   mu_push_clip_rect(ctx, cnt->body);
 }
@@ -14,20 +14,62 @@ extern "C" {
 
 #define MU_VERSION "2.02"
 
+/* 容量はコンパイル時に-Dで変更できる（ベンチマークなどで大きくする場合） */
+#ifndef MU_COMMANDLIST_SIZE
 #define MU_COMMANDLIST_SIZE     (256 * 1024)
+#endif
+#ifndef MU_TEXTPOOL_SIZE
+#define MU_TEXTPOOL_SIZE        MU_COMMANDLIST_SIZE   /* 1フレームの文字列プールのバイト数 */
+#endif
+#define MU_TEXTPOOL_HASH        1024          /* 文字列プールの重複検出表の大きさ（2のべき） */
+#ifndef MU_ROOTLIST_SIZE
 #define MU_ROOTLIST_SIZE        32
+#endif
+#ifndef MU_CONTAINERSTACK_SIZE
 #define MU_CONTAINERSTACK_SIZE  32
+#endif
+#ifndef MU_CLIPSTACK_SIZE
 #define MU_CLIPSTACK_SIZE       32
+#endif
+#ifndef MU_IDSTACK_SIZE
 #define MU_IDSTACK_SIZE         32
+#endif
+#ifndef MU_LAYOUTSTACK_SIZE
 #define MU_LAYOUTSTACK_SIZE     16
+#endif
+#ifndef MU_CONTAINERPOOL_SIZE
 #define MU_CONTAINERPOOL_SIZE   48
+#endif
+#ifndef MU_TREENODEPOOL_SIZE
 #define MU_TREENODEPOOL_SIZE    48
+#endif
 #define MU_MAX_WIDTHS           16
+#ifndef MU_HITLIST_SIZE
+#define MU_HITLIST_SIZE         1024
+#endif
+#define MU_HITGRID_SIZE         16
+#ifndef MU_INPUTQUEUE_SIZE
+#define MU_INPUTQUEUE_SIZE      256
+#endif
+#ifndef MU_INPUTTEXT_SIZE
+#define MU_INPUTTEXT_SIZE       4096          /* 貼り付けなど長いテキストはこれを超えた分を捨てる */
+#endif
 #define MU_REAL                 float
 #define MU_REAL_FMT             "%.3g"
 #define MU_SLIDER_FMT           "%.2f"
 #define MU_MAX_FMT              127
 
+/* MU_COMPACT_COMMANDSを定義すると、コマンドリストを小さな符号化で格納する。
+** 1バイトの種類に続けて座標・ID・文字列長を16ビット、フォントを番号で持つ（RECTは24→13バイト）。
+** 16ビットに収まらないコマンドとJUMPは従来の構造体のまま格納する。
+** mu_next_commandが走査しながら展開するので、バックエンドの変更は要らない */
+#define MU_COMPACT_FONTS        16     /* 番号に置き換えられるフォントの数 */
+
+/* MU_CHECK_IDSを定義すると、1フレーム内のIDの衝突を検出して標準エラーに報告する（デバッグ用）。
+** 違うデータから同じIDができた場合（ハッシュの衝突）と、同じIDのコントロールが
+** 2つある場合（同じラベルのボタンなど）を数え、stats.id_collisionsに加える */
+#define MU_IDCHECK_SIZE         4096   /* 衝突検出に覚えるIDの数（2のべき） */
+
 #define mu_stack(T, n)          struct { int idx; T items[n]; }
 #define mu_min(a, b)            ((a) < (b) ? (a) : (b))
 #define mu_max(a, b)            ((a) > (b) ? (a) : (b))
@@ -84,6 +126,37 @@ extern "C" {
 		MU_RES_CHANGE = (1 << 2)
 	};
 
+	enum
+	{
+		MU_EVENT_MOUSEMOVE = 1,
+		MU_EVENT_MOUSEDOWN,
+		MU_EVENT_MOUSEUP,
+		MU_EVENT_SCROLL,
+		MU_EVENT_KEYDOWN,
+		MU_EVENT_KEYUP,
+		MU_EVENT_TEXT,
+		MU_EVENT_TIME          /* mu_input_time（キューには積まず、input_hookにだけ渡す） */
+	};
+
+	enum
+	{
+		MU_HIT_ANY,
+		MU_HIT_CONTROL,
+		MU_HIT_BUTTON,
+		MU_HIT_CHECKBOX,
+		MU_HIT_TEXTBOX,
+		MU_HIT_SLIDER,
+		MU_HIT_NUMBER,
+		MU_HIT_HEADER,
+		MU_HIT_WINDOW
+	};
+
+	enum
+	{
+		MU_FLEX_ROW,
+		MU_FLEX_COLUMN
+	};
+
 	enum
 	{
 		MU_OPT_ALIGNCENTER = (1 << 0),
@@ -132,7 +205,8 @@ extern "C" {
 	typedef struct { mu_BaseCommand base; void* dst; } mu_JumpCommand;
 	typedef struct { mu_BaseCommand base; mu_Rect rect; } mu_ClipCommand;
 	typedef struct { mu_BaseCommand base; mu_Rect rect; mu_Color color; } mu_RectCommand;
-	typedef struct { mu_BaseCommand base; mu_Font font; mu_Vec2 pos; mu_Color color; char str[1]; } mu_TextCommand;
+	/* strは終端付きで、文字列プール（mu_draw_text）か呼び出し側の文字列（mu_draw_text_static）を指す */
+	typedef struct { mu_BaseCommand base; mu_Font font; mu_Vec2 pos; mu_Color color; int len; const char* str; } mu_TextCommand;
 	typedef struct { mu_BaseCommand base; mu_Rect rect; int id; mu_Color color; } mu_IconCommand;
 
 	typedef union
@@ -146,6 +220,31 @@ extern "C" {
 		mu_IconCommand icon;
 	} mu_Command;
 
+	/* 符号化したコマンドの展開先 */
+	typedef struct { mu_Command command; } mu_CommandScratch;
+
+	/* 行の幅・高さの計算結果と、それを決める入力 */
+	typedef struct
+	{
+		int items, height, body_w, indent, spacing;
+		int size_x, size_y, padding;
+		int widths[MU_MAX_WIDTHS];   /* 入力（itemsが0なら無効） */
+		int resolved_w[MU_MAX_WIDTHS];
+		int resolved_h;
+	} mu_LayoutRow;
+
+	/* フレックスレイアウトの1アイテム（配列は呼び出し側が用意する） */
+	typedef struct
+	{
+		int basis;       /* 基本サイズ（0なら既定の大きさ、負なら0から伸ばす） */
+		int grow;        /* 余りを分ける比率 */
+		int shrink;      /* 不足を削る比率（basisとの積で分ける） */
+		int min, max;    /* 主軸方向の最小・最大（maxが0なら上限なし） */
+		int size;        /* 結果: 主軸方向のサイズ */
+		int offset;      /* 結果: 主軸方向の位置（body基準） */
+		int state;       /* 計算中の状態（内部で使う） */
+	} mu_FlexItem;
+
 	typedef struct
 	{
 		mu_Rect body;
@@ -159,8 +258,105 @@ extern "C" {
 		int next_row;
 		int next_type;
 		int indent;
+		int row_index;   /* このレイアウト内の行番号 */
+		int resolved;    /* 1ならrowが現在の行の計算結果 */
+		mu_LayoutRow row;
+		mu_FlexItem* flex;   /* フレックスレイアウト中ならアイテム配列 */
+		int flex_count, flex_index, flex_dir;
 	} mu_Layout;
 
+	/* 固定高さの行を並べたリストのうち、表示する範囲（mu_list_clipper_beginで設定） */
+	typedef struct
+	{
+		int count;       /* 全体の行数 */
+		int row_height;  /* 行の高さ */
+		int start, end;  /* 表示する行の範囲 [start, end) */
+		int top;         /* 先頭行のy（レイアウトbody基準） */
+	} mu_ListClipper;
+
+	/* 可変高さリストの1行 */
+	typedef struct
+	{
+		mu_Id id;        /* 行の安定したID */
+		int height;      /* 行の送り幅（高さ＋spacing） */
+	} mu_VListRow;
+
+	/* 可変高さの仮想リスト（配列は呼び出し側が用意する） */
+	typedef struct
+	{
+		mu_VListRow* rows;
+		int* tree;       /* 行の送り幅のフェニック木（rowsと同じ要素数） */
+		int* slots;      /* IDから行番号への表（行番号+1、0は空き） */
+		int count, capacity;
+		int slot_mask;   /* slotsの要素数-1 */
+		int default_height; /* 未作成の行の推定送り幅 */
+		int top;         /* 先頭行のy（レイアウトbody基準） */
+		int current;     /* 作成中の行（-1なら無し） */
+		int next;        /* 次に作成する行 */
+		int row_top;     /* 作成中の行のy（レイアウトbody基準） */
+		int clip_bottom; /* クリップ領域の下端（レイアウトbody基準） */
+	} mu_VirtualList;
+
+	/* 表の列 */
+	typedef struct
+	{
+		const char* title;  /* 見出し */
+		int width;          /* 列幅（見出しの右端をドラッグすると変わる） */
+		int x;              /* 表の左端からの位置（mu_begin_tableで計算） */
+	} mu_TableColumn;
+
+	/* 並べ替え用の比較関数（a, bは元データの行番号） */
+	typedef int (*mu_TableCompare)(void* udata, int column, int a, int b);
+
+	/* 仮想化された表（配列は呼び出し側が用意する） */
+	typedef struct
+	{
+		mu_TableColumn* columns;
+		int column_count;
+		int* order;        /* 表示順の行番号（NULLなら並べ替えなし） */
+		mu_TableCompare compare;
+		void* udata;
+		int row_count;
+		int row_height;
+		int sort_column;   /* 並べ替える列（-1なら元の順番） */
+		int sort_desc;     /* 降順なら1 */
+		int sorted_version, sorted_column, sorted_desc, sorted_rows; /* orderを作成した時の状態 */
+		int row_start, row_end; /* 表示する行の範囲 [start, end) */
+		int col_start, col_end; /* 表示する列の範囲 [start, end) */
+		mu_Vec2 origin;    /* 表の左上（画面座標） */
+		int header_height;
+		int width;         /* 全列の幅の合計 */
+		int opt;
+	} mu_Table;
+
+	/* ツリーのデータ取得用コールバック（ノードはmu_Idで識別する） */
+	typedef struct
+	{
+		int (*child_count)(void* udata, mu_Id node);         /* 子の数 */
+		mu_Id (*child)(void* udata, mu_Id node, int index);  /* index番目の子 */
+		const char* (*label)(void* udata, mu_Id node);      /* 表示する文字列 */
+		void* udata;
+	} mu_TreeSource;
+
+	/* 展開されて見えているノード1つ分の行 */
+	typedef struct
+	{
+		mu_Id node;
+		int depth;
+		int expanded;
+	} mu_TreeRow;
+
+	/* 仮想化されたツリー（行の配列は呼び出し側が用意する） */
+	typedef struct
+	{
+		mu_TreeSource source;
+		mu_Id root;
+		mu_TreeRow* rows;  /* 見えているノードを上から順に並べたもの */
+		int count, capacity;
+		int row_height;    /* 0なら既定の高さ */
+		mu_Id selected;    /* 最後にクリックされたノード */
+	} mu_TreeView;
+
 	typedef struct
 	{
 		mu_Command* head, * tail;
@@ -168,10 +364,50 @@ extern "C" {
 		mu_Rect body;
 		mu_Vec2 content_size;
 		mu_Vec2 scroll;
+		mu_Rect opaque; /* 不透明で塗りつぶした領域（w == 0なら無し） */
 		int zindex;
 		int open;
 	} mu_Container;
 
+	/* 入力イベント（mu_input_*が積み、mu_beginが取り出す） */
+	typedef struct
+	{
+		int type;              /* MU_EVENT_* */
+		int x, y;              /* マウス位置・スクロール量 */
+		int code;              /* マウスボタン・キー */
+		int text, len;         /* テキストのinput_queue.text上の位置と長さ */
+		unsigned time;         /* mu_input_timeで設定した時刻 */
+	} mu_InputEvent;
+
+	/* ヒットテスト用に記録したコントロール */
+	typedef struct
+	{
+		mu_Id id;
+		mu_Rect rect;          /* クリップ済みの画面上の矩形 */
+		int kind;              /* MU_HIT_* */
+		int zindex;            /* 記録中はrootで、索引を作る時にzindexを入れる */
+		mu_Container* root;
+	} mu_HitItem;
+
+	/* 1フレーム分の統計（mu_beginで0にする。mu_endの後、次のmu_beginまで読める） */
+	typedef struct
+	{
+		int command_bytes;             /* コマンドリストの使用量（mu_endで設定） */
+		int text_bytes;                /* 文字列プールの使用量（mu_endで設定） */
+		int text_shared;               /* 文字列プールで同じ文字列を使い回した回数 */
+		int commands[MU_COMMAND_MAX];  /* 種類ごとのコマンド数（クリップはcommands[MU_COMMAND_CLIP]、
+		                                  アプリ独自の種類はまとめてcommands[0]） */
+		int pool_hits, pool_misses;    /* mu_pool_getで見つかった・見つからなかった回数 */
+		int pool_evictions;            /* mu_pool_initが使用中の項目を取り替えた回数 */
+		int text_width_calls;          /* text_widthコールバックの呼び出し回数 */
+		int hover_tests;               /* mu_mouse_overの呼び出し回数 */
+		int input_dropped;             /* 前のmu_begin以降、入力キューに入らずに捨てたイベント数 */
+		int id_collisions;             /* 検出したIDの衝突（MU_CHECK_IDSのみ） */
+		int max_container_depth, max_clip_depth, max_id_depth, max_layout_depth;
+		/* 以下はバックエンドが描画時に加算する */
+		int vertices, draw_calls, flushes;
+	} mu_FrameStats;
+
 	typedef struct
 	{
 		mu_Font font;
@@ -191,7 +427,13 @@ extern "C" {
 		int (*text_width)(mu_Font font, const char* str, int len);
 		int (*text_height)(mu_Font font);
 		void (*draw_frame)(mu_Context* ctx, mu_Rect rect, int colorid);
-		void (*draw_text)(mu_Context* ctx, mu_Font font, const char* str, int len, mu_Vec2 pos, mu_Color color); // ǉ
+		void (*draw_text)(mu_Context* ctx, mu_Font font, const char* str, int len, mu_Vec2 pos, mu_Color color); // 追加
+		/* 区間の開始（begin=1）・終了（begin=0）の通知。NULLなら呼ばない（trace.hを参照） */
+		void (*trace)(void* udata, const char* name, int begin);
+		void* trace_udata;
+		/* mu_input_*の呼び出しの通知（MU_EVENT_*、TIMEではcodeに時刻）。NULLなら呼ばない（input_record.hを参照） */
+		void (*input_hook)(void* udata, int type, int x, int y, int code, const char* text);
+		void* input_udata;
 
 		/* core state */
 		mu_Style _style;
@@ -200,6 +442,7 @@ extern "C" {
 		mu_Id focus;
 		mu_Id last_id;
 		mu_Rect last_rect;
+		int culled;   /* last_rectがクリップ矩形の完全に外側なら1（mu_layout_nextが設定） */
 		int last_zindex;
 		int updated_focus;
 		int frame;
@@ -209,7 +452,8 @@ extern "C" {
 		char number_edit_buf[MU_MAX_FMT];
 		mu_Id number_edit;
 		/* stacks */
-		mu_stack(char, MU_COMMANDLIST_SIZE) command_list;
+		/* itemsは通常command_storageを指す。command_mailboxで別のバッファに差し替えられる */
+		struct { int idx; char* items; } command_list;
 		mu_stack(mu_Container*, MU_ROOTLIST_SIZE) root_list;
 		mu_stack(mu_Container*, MU_CONTAINERSTACK_SIZE) container_stack;
 		mu_stack(mu_Rect, MU_CLIPSTACK_SIZE) clip_stack;
@@ -219,6 +463,46 @@ extern "C" {
 		mu_PoolItem container_pool[MU_CONTAINERPOOL_SIZE];
 		mu_Container containers[MU_CONTAINERPOOL_SIZE];
 		mu_PoolItem treenode_pool[MU_TREENODEPOOL_SIZE];
+		/* 同じレイアウトの前の行の計算結果をそのまま使えた回数・計算し直した回数
+		 * （累計、利用側でリセットしてよい） */
+		int layout_row_reuses;
+		int layout_row_resolves;
+		/* 今フレームに記録した操作可能なコントロール */
+		mu_HitItem hit_items[MU_HITLIST_SIZE];
+		int hit_count;
+		/* 前フレームのコントロールの一様グリッド（mu_endで作成） */
+		struct
+		{
+			mu_HitItem items[MU_HITLIST_SIZE];
+			int count;
+			mu_Rect bounds;    /* 全コントロールを囲む矩形 */
+			int cell_w, cell_h, size;
+			int start[MU_HITGRID_SIZE * MU_HITGRID_SIZE + 1]; /* セルごとのentriesの範囲 */
+			unsigned short entries[MU_HITLIST_SIZE * 4];
+			unsigned short by_id[MU_HITLIST_SIZE * 2]; /* IDで引く表（itemsの番号+1、0は空き） */
+		} hit_grid;
+		/* 既定のコマンドバッファ */
+		char command_storage[MU_COMMANDLIST_SIZE];
+		/* TEXTコマンドの文字列プール（mu_clear_commandsで空にする）。
+		** itemsは通常text_storageを指す。command_mailboxで別のバッファに差し替えられる */
+		struct { int idx; char* items; } text_pool;
+		/* 同じ文字列を1つにまとめるための表（generationが今の世代の項目だけ有効） */
+		struct { unsigned hash; int offset, len; unsigned generation; } text_pool_hash[MU_TEXTPOOL_HASH];
+		unsigned text_pool_generation;
+		char text_storage[MU_TEXTPOOL_SIZE];
+#ifdef MU_COMPACT_COMMANDS
+		/* 符号化前のコマンド（次のmu_push_commandかmu_commit_commandsで符号化する） */
+		mu_CommandScratch command_pending;
+		int command_has_pending;
+		mu_CommandScratch command_decoded;  /* mu_next_commandの展開先 */
+		char* command_read;                 /* mu_next_commandの次の読み出し位置 */
+		mu_Font command_fonts[MU_COMPACT_FONTS];  /* フォントの番号（mu_init以降追加のみ） */
+		int command_font_count;
+#endif
+#ifdef MU_CHECK_IDS
+		/* 今フレームに作ったID（frameが今のフレームの項目だけ有効） */
+		struct { mu_Id id; unsigned check; int frame, control_frame; } id_check[MU_IDCHECK_SIZE];
+#endif
 		/* input state */
 		mu_Vec2 mouse_pos;
 		mu_Vec2 last_mouse_pos;
@@ -229,166 +513,281 @@ extern "C" {
 		int key_down;
 		int key_pressed;
 		char input_text[32];
+		/* 入力イベントのリングバッファ（テキストも別のリングに保持する） */
+		struct
+		{
+			mu_InputEvent items[MU_INPUTQUEUE_SIZE];
+			int head, count;
+			char text[MU_INPUTTEXT_SIZE];
+			int text_head, text_count;
+			int dropped;       /* 入りきらずに捨てたイベント数 */
+		} input_queue;
+		unsigned input_time;          /* 次に積むイベントの時刻 */
+		unsigned last_event_time;     /* このフレームで最後に取り出したイベントの時刻 */
+		unsigned mouse_pressed_time;  /* 最後にマウスボタンが押された時刻 */
+		/* measure pass */
+		int measuring;
+		struct
+		{
+			int command_idx, root_idx;
+			int mouse_down, mouse_pressed, key_pressed;
+			mu_Vec2 mouse_delta;
+			char input_text[32];
+			mu_Container* next_hover_root;
+			mu_Container* scroll_target;
+		} measure_saved;
+		/* 今フレームの統計 */
+		mu_FrameStats stats;
 	};
 
 
 	/**
-	 * @brief 2xNg
-	 * x, yWmu_Vec2^𐶐܂B
-	 * g: mu_vec2(x, y);
-	 * @param x XW
-	 * @param y YW
-	 * @return mu_Vec2 ꂽxNg
+	 * @brief 2次元ベクトル生成
+	 * x, y座標からmu_Vec2型を生成します。
+	 * 使い方: mu_vec2(x, y);
+	 * @param x X座標
+	 * @param y Y座標
+	 * @return mu_Vec2 生成されたベクトル
 	 */
 	mu_Vec2 mu_vec2(int x, int y);
 
 	/**
-	 * @brief `
-	 * x, y, w, hmu_Rect^𐶐܂B
-	 * g: mu_rect(x, y, w, h);
-	 * @param x XW
-	 * @param y YW
-	 * @param w 
-	 * @param h 
-	 * @return mu_Rect ꂽ`
+	 * @brief 矩形生成
+	 * x, y, w, hからmu_Rect型を生成します。
+	 * 使い方: mu_rect(x, y, w, h);
+	 * @param x X座標
+	 * @param y Y座標
+	 * @param w 幅
+	 * @param h 高さ
+	 * @return mu_Rect 生成された矩形
 	 */
 	mu_Rect mu_rect(int x, int y, int w, int h);
 
 	/**
-	 * @brief F
-	 * RGBAlmu_Color^𐶐܂B
-	 * g: mu_color(r, g, b, a);
-	 * @param r 
-	 * @param g 
-	 * @param b 
-	 * @param a At@
-	 * @return mu_Color ꂽF
+	 * @brief 色生成
+	 * RGBA値からmu_Color型を生成します。
+	 * 使い方: mu_color(r, g, b, a);
+	 * @param r 赤
+	 * @param g 緑
+	 * @param b 青
+	 * @param a アルファ
+	 * @return mu_Color 生成された色
 	 */
 	mu_Color mu_color(int r, int g, int b, int a);
 
 	/**
-	 * @brief MicroUIReLXg
-	 * MicroUȈԂ܂B
-	 * g: mu_init(ctx);
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief MicroUIコンテキスト初期化
+	 * MicroUIの状態を初期化します。
+	 * 使い方: mu_init(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_init(mu_Context* ctx);
 
 	/**
-	 * @brief t[Jn
-	 * UIt[̏Jn܂B
-	 * g: mu_begin(ctx);
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief フレーム開始処理
+	 * UIフレームの処理を開始します。
+	 * 使い方: mu_begin(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_begin(mu_Context* ctx);
 
 	/**
-	 * @brief t[I
-	 * UIt[̏IÁEԂZbg܂B
-	 * g: mu_end(ctx);
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief フレーム終了処理
+	 * UIフレームの処理を終了し、入力・状態をリセットします。
+	 * 使い方: mu_end(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_end(mu_Context* ctx);
 
 	/**
-	 * @brief tH[JXݒ
-	 * wIDɃtH[JXݒ肵܂B
-	 * g: mu_set_focus(ctx, id);
-	 * @param ctx MicroUĨReLXg
-	 * @param id tH[JXݒ肷ID
-	 * @return Ȃ
+	 * @brief 計測パスの開始
+	 * MU_OPT_AUTOSIZEのウィンドウの大きさを同じフレーム内で決めるための計測パスを開始します。
+	 * mu_end_measureまでの間は、AUTOSIZEでないウィンドウは開かず（mu_begin_window_exが0を返す）、
+	 * 描画コマンドを出さず、入力も処理しません。計測したコンテンツサイズは
+	 * 続く通常のパスでウィンドウの大きさにそのまま反映されるので、1フレーム遅れがなくなります。
+	 * 使い方: mu_begin(ctx);
+	 *         mu_begin_measure(ctx); build_ui(ctx); mu_end_measure(ctx);
+	 *         build_ui(ctx);
+	 *         mu_end(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
+	 */
+	void mu_begin_measure(mu_Context* ctx);
+
+	/**
+	 * @brief 計測パスの終了
+	 * コマンドリスト・ルートリスト・入力状態を計測パス開始時の状態に戻します。
+	 * 使い方: mu_end_measure(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
+	 */
+	void mu_end_measure(mu_Context* ctx);
+
+	/**
+	 * @brief 指定位置のコントロールを取得
+	 * 前フレームで操作可能だったコントロールのうち、指定位置で最前面にあるもののIDを返します。
+	 * mu_update_controlが記録した矩形（クリップ済み）をmu_endで一様グリッドにまとめてあるので、
+	 * 1つのセルに入ったコントロールだけを調べます。フレームを作る前のタッチ処理などで使います。
+	 * ウィンドウ自体もMU_HIT_WINDOWとして記録されるため、手前のウィンドウの余白の下にある
+	 * コントロールは返しません。最前面のものがkindと違う場合も0を返します。
+	 * フレーム内のホバー判定（mu_mouse_over）はこのグリッドを使いません。今フレームの矩形と
+	 * 1回比べるだけで済み、グリッドは前フレームの結果なので使うと1フレーム遅れるためです。
+	 * 使い方: id = mu_hit_test(ctx, x, y, MU_HIT_SLIDER);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param x 画面上のx
+	 * @param y 画面上のy
+	 * @param kind 探すコントロールの種類（MU_HIT_ANYなら全て）
+	 * @return mu_Id 見つかったコントロールのID（なければ0）
+	 */
+	mu_Id mu_hit_test(mu_Context* ctx, int x, int y, int kind);
+
+	/**
+	 * @brief コントロールの種類を取得
+	 * 前フレームに記録したコントロールから、指定IDの種類を返します。
+	 * 使い方: if (mu_hit_kind(ctx, ctx->focus) == MU_HIT_TEXTBOX) { ... }
+	 * @param ctx MicroUIのコンテキスト
+	 * @param id コントロールID
+	 * @return int MU_HIT_*（記録されていなければMU_HIT_ANY）
+	 */
+	int mu_hit_kind(mu_Context* ctx, mu_Id id);
+
+	/**
+	 * @brief フォーカス設定
+	 * 指定IDにフォーカスを設定します。
+	 * 使い方: mu_set_focus(ctx, id);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param id フォーカスを設定するID
+	 * @return なし
 	 */
 	void mu_set_focus(mu_Context* ctx, mu_Id id);
 
 	/**
-	 * @brief ID
-	 * CӃf[^ӂID𐶐܂B
-	 * g: mu_get_id(ctx, data, size);
-	 * @param ctx MicroUĨReLXg
-	 * @param data IDpf[^
-	 * @param size f[^TCY
-	 * @return mu_Id ꂽID
+	 * @brief ID生成
+	 * 任意データから一意なIDを生成します。
+	 * 使い方: mu_get_id(ctx, data, size);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param data ID生成用データ
+	 * @param size データサイズ
+	 * @return mu_Id 生成されたID
 	 */
 	mu_Id mu_get_id(mu_Context* ctx, const void* data, int size);
 
 	/**
-	 * @brief IDX^bNIDvbV
-	 * ݂IDX^bNIDǉ܂B
-	 * g: mu_push_id(ctx, data, size);
-	 * @param ctx MicroUĨReLXg
-	 * @param data IDpf[^
-	 * @param size f[^TCY
-	 * @return Ȃ
+	 * @brief 整数からのID生成
+	 * mu_get_id(ctx, &value, sizeof(value))と同じIDを、バイト列を走査せずに生成します。
+	 * 使い方: id = mu_get_id_int(ctx, i);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param value ID生成用の整数（配列の添字など）
+	 * @return mu_Id 生成されたID
+	 */
+	mu_Id mu_get_id_int(mu_Context* ctx, int value);
+
+	/**
+	 * @brief ポインタからのID生成
+	 * mu_get_id(ctx, &ptr, sizeof(ptr))と同じIDを、バイト列を走査せずに生成します。
+	 * 使い方: id = mu_get_id_ptr(ctx, &value);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param ptr ID生成用のポインタ（指す先は読まない）
+	 * @return mu_Id 生成されたID
+	 */
+	mu_Id mu_get_id_ptr(mu_Context* ctx, const void* ptr);
+
+	/**
+	 * @brief IDスタックにIDをプッシュ
+	 * 現在のIDスタックにIDを追加します。
+	 * 使い方: mu_push_id(ctx, data, size);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param data ID生成用データ
+	 * @param size データサイズ
+	 * @return なし
 	 */
 	void mu_push_id(mu_Context* ctx, const void* data, int size);
 
 	/**
-	 * @brief IDX^bNID|bv
-	 * IDX^bÑgbv폜܂B
-	 * g: mu_pop_id(ctx);
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief 整数から作ったIDをIDスタックにプッシュ
+	 * 使い方: mu_push_id_int(ctx, i);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param value ID生成用の整数
+	 * @return なし
+	 */
+	void mu_push_id_int(mu_Context* ctx, int value);
+
+	/**
+	 * @brief ポインタから作ったIDをIDスタックにプッシュ
+	 * 使い方: mu_push_id_ptr(ctx, item);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param ptr ID生成用のポインタ
+	 * @return なし
+	 */
+	void mu_push_id_ptr(mu_Context* ctx, const void* ptr);
+
+	/**
+	 * @brief IDスタックからIDをポップ
+	 * IDスタックのトップを削除します。
+	 * 使い方: mu_pop_id(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_pop_id(mu_Context* ctx);
 
 	/**
-	 * @brief Nbv`vbV
-	 * Nbv`X^bNɐV`ǉ܂B
-	 * g: mu_push_clip_rect(ctx, rect);
-	 * @param ctx MicroUĨReLXg
-	 * @param rect Nbv`
-	 * @return Ȃ
+	 * @brief クリップ矩形をプッシュ
+	 * クリップ矩形スタックに新しい矩形を追加します。
+	 * 使い方: mu_push_clip_rect(ctx, rect);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param rect クリップ矩形
+	 * @return なし
 	 */
 	void mu_push_clip_rect(mu_Context* ctx, mu_Rect rect);
 
 	/**
-	 * @brief Nbv`|bv
-	 * Nbv`X^bÑgbv폜܂B
-	 * g: mu_pop_clip_rect(ctx);
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief クリップ矩形をポップ
+	 * クリップ矩形スタックのトップを削除します。
+	 * 使い方: mu_pop_clip_rect(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_pop_clip_rect(mu_Context* ctx);
 
 	/**
-	 * @brief ݂̃Nbv`擾
-	 * Nbv`X^bÑgbv擾܂B
-	 * g: mu_get_clip_rect(ctx);
-	 * @param ctx MicroUĨReLXg
-	 * @return mu_Rect ݂̃Nbv`
+	 * @brief 現在のクリップ矩形取得
+	 * クリップ矩形スタックのトップを取得します。
+	 * 使い方: mu_get_clip_rect(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return mu_Rect 現在のクリップ矩形
 	 */
 	mu_Rect mu_get_clip_rect(mu_Context* ctx);
 
 	/**
-	 * @brief Nbv
-	 * w`Nbv͈͓肵܂B
-	 * g: mu_check_clip(ctx, rect);
-	 * @param ctx MicroUĨReLXg
-	 * @param rect 肷`
-	 * @return int NbvԁiMU_CLIP_ALL, MU_CLIP_PART, 0j
+	 * @brief クリップ判定
+	 * 指定矩形がクリップ範囲内か判定します。
+	 * 使い方: mu_check_clip(ctx, rect);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param rect 判定する矩形
+	 * @return int クリップ状態（MU_CLIP_ALL, MU_CLIP_PART, 0）
 	 */
 	int mu_check_clip(mu_Context* ctx, mu_Rect r);
 	mu_Container* mu_get_current_container(mu_Context* ctx);
 	/**
- * @brief Rei擾
- * Ow肵ăRei擾܂B
- * g: mu_get_container(ctx, "Rei");
- * @param ctx MicroUĨReLXg
- * @param name Rei
- * @return mu_Container* Reiւ̃|C^
+ * @brief コンテナ取得
+ * 名前を指定してコンテナを取得します。
+ * 使い方: mu_get_container(ctx, "コンテナ名");
+ * @param ctx MicroUIのコンテキスト
+ * @param name コンテナ名
+ * @return mu_Container* コンテナへのポインタ
  */
 	mu_Container* mu_get_container(mu_Context* ctx, const char* name);
 
 	/**
-	 * @brief Rei̍őOʉ
-	 * w肵ReiőOʂɎĂ܂B
-	 * g: mu_bring_to_front(ctx, cnt);
-	 * @param ctx MicroUĨReLXg
-	 * @param cnt Reiւ̃|C^
-	 * @return Ȃ
+	 * @brief コンテナの最前面化
+	 * 指定したコンテナを最前面に持ってきます。
+	 * 使い方: mu_bring_to_front(ctx, cnt);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param cnt コンテナへのポインタ
+	 * @return なし
 	 */
 	void mu_bring_to_front(mu_Context* ctx, mu_Container* cnt);
 
@@ -396,6 +795,15 @@ extern "C" {
 	int mu_pool_get(mu_Context* ctx, mu_PoolItem* items, int len, mu_Id id);
 	void mu_pool_update(mu_Context* ctx, mu_PoolItem* items, int idx);
 
+	/*
+	 * 入力関数はイベントをキューに積むだけで、状態はmu_beginで更新されます。
+	 * マウス移動とスクロールは直前の同じイベントにまとめます。ボタン・キーの押下と
+	 * テキストは全て残し、1フレームで反映しきれない分（同じボタンの2回目の押下、
+	 * input_textに入りきらないテキストなど）は次のフレームに持ち越します。
+	 * キューが一杯になったら、マウス移動とスクロールはさらに前の同じイベントにまとめ、
+	 * それ以外のイベントとテキストの入りきらない分は捨てて、次のmu_beginで
+	 * stats.input_droppedに数えます（異常終了はしません）。
+	 */
 	void mu_input_mousemove(mu_Context* ctx, int x, int y);
 	void mu_input_mousedown(mu_Context* ctx, int x, int y, int btn);
 	void mu_input_mouseup(mu_Context* ctx, int x, int y, int btn);
@@ -404,181 +812,423 @@ extern "C" {
 	void mu_input_keyup(mu_Context* ctx, int key);
 	void mu_input_text(mu_Context* ctx, const char* text);
 
+	/**
+	 * @brief 入力イベントの時刻設定
+	 * 以降に積むイベントの時刻を設定します。単位は呼び出し側で決めてください（ミリ秒など）。
+	 * 使い方: mu_input_time(ctx, GetTickCount());
+	 * @param ctx MicroUIのコンテキスト
+	 * @param time 現在時刻
+	 * @return なし
+	 */
+	void mu_input_time(mu_Context* ctx, unsigned time);
+
+	/**
+	 * @brief コマンドリストと文字列プールを空にする
+	 * mu_beginが呼び出します。mu_begin～mu_endの外でコマンドを積み直す場合
+	 * （コマンドの再投入など）は、積む前に呼び出してください。
+	 * 使い方: mu_clear_commands(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
+	 */
+	void mu_clear_commands(mu_Context* ctx);
+
+	/**
+	 * @brief 文字列プールへの登録
+	 * 文字列を今フレームの文字列プールに終端付きでコピーして返します。
+	 * 同じフレームで同じ内容を登録済みなら、コピーせずにそれを返します。
+	 * 返した文字列は次のmu_clear_commands（mu_begin）まで有効です。
+	 * 使い方: str = mu_intern_text(ctx, "OK", -1);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param str 文字列
+	 * @param len 文字列長（-1なら自動判定）
+	 * @return const char* プール内の文字列
+	 */
+	const char* mu_intern_text(mu_Context* ctx, const char* str, int len);
+
 	mu_Command* mu_push_command(mu_Context* ctx, int type, int size);
 
 	/**
-	 * @brief R}hXg̎̃R}h擾
-	 * R}hXg𑖍A̗LȃR}hiJUMPȊOj擾܂B
-	 * JUMPR}h̏ꍇ̓WvɈړ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param cmd R}hւ̃|C^iNULL̏ꍇ͐擪j
-	 * @return int LȃR}h1AȂ0
+	 * @brief 保留中のコマンドの確定
+	 * MU_COMPACT_COMMANDSでは、mu_push_commandが返したコマンドは次のmu_push_commandで
+	 * 符号化されます。mu_end・mu_next_commandは自分で確定するので、mu_begin～mu_endの外で
+	 * mu_push_commandを使ったとき（コマンドの再投入など）だけ、走査の前に呼び出してください。
+	 * MU_COMPACT_COMMANDSでなければ何もしません。
+	 * 使い方: mu_commit_commands(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
+	 */
+	void mu_commit_commands(mu_Context* ctx);
+
+	/**
+	 * @brief 外部から読み込んだコマンドの積み直し
+	 * 保存したファイルや通信で受け取ったコマンドを、mu_clear_commands～mu_commit_commandsの
+	 * 間で1つずつ積みます。コマンドリストと文字列プールに収まるか先に確かめるので、
+	 * 壊れたデータや大きすぎるフレームでも異常終了しません。
+	 * TEXTの文字列はsrc->text.strからtext.lenバイトを文字列プールへコピーします（終端は不要）。
+	 * 使い方: if (!mu_inject_command(ctx, &cmd)) { mu_clear_commands(ctx); }
+	 * @param ctx MicroUIのコンテキスト
+	 * @param src 積むコマンド（CLIP・RECT・ICON・TEXT、base.sizeは見ない）
+	 * @return int 積んだら1、種類が不正か容量が足りなければ0
+	 */
+	int mu_inject_command(mu_Context* ctx, const mu_Command* src);
+
+	/**
+	 * @brief コマンドリストの次のコマンドを取得する
+	 * コマンドリストを走査し、次の有効なコマンド（JUMP以外）を取得します。
+	 * JUMPコマンドの場合はジャンプ先に移動します。
+	 * MU_COMPACT_COMMANDSでは返すコマンドは展開先（ctx内）を指し、次の呼び出しで上書きされます。
+	 * また走査の位置をctxに持つので、同時に走査できるのは1つだけです。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param cmd コマンドへのポインタ（NULLの場合は先頭から）
+	 * @return int 有効なコマンドがあれば1、末尾なら0
 	 */
 	int mu_next_command(mu_Context* ctx, mu_Command** cmd);
 
 	/**
-	 * @brief NbvR}hR}hXgɒǉ
-	 * w肵`̈ŕ`NbvijR}hǉ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param rect Nbv`̈
-	 * @return Ȃ
+	 * @brief コマンドを1つ読み出す
+	 * posの位置のコマンドを返し、posを次のコマンドの位置へ進めます。JUMPは辿らずに返します
+	 * （辿るときはposをjump.dstにする）。ルートコンテナの範囲だけを走査する場合や、
+	 * 複数のスレッドで別々の範囲を走査する場合に使います。
+	 * MU_COMPACT_COMMANDSでは符号化したコマンドをscratchへ展開して返します
+	 * （符号化しなかったコマンドはコマンドリスト内を指す）。それ以外ではscratchは使いません。
+	 * 使い方: cmd = mu_read_command(ctx, &pos, &scratch);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param pos 読み出し位置（コマンドリスト内）
+	 * @param scratch 展開先
+	 * @return mu_Command* コマンド
+	 */
+	mu_Command* mu_read_command(mu_Context* ctx, char** pos, mu_CommandScratch* scratch);
+
+	/**
+	 * @brief クリップコマンドをコマンドリストに追加する
+	 * 指定した矩形領域で描画をクリップ（制限）するコマンドを追加します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param rect クリップする矩形領域
+	 * @return なし
 	 */
 	void mu_set_clip(mu_Context* ctx, mu_Rect rect);
 
 	/**
-	 * @brief ``R}hR}hXgɒǉ
-	 * w肵`̈ƐFŋ``悷R}hǉ܂B
-	 * Nbv̈ƌĂꍇ̂ݒǉ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param rect `悷`
-	 * @param color `F
-	 * @return Ȃ
+	 * @brief 矩形描画コマンドをコマンドリストに追加する
+	 * 指定した矩形領域と色で矩形を描画するコマンドを追加します。
+	 * クリップ領域と交差している場合のみ追加されます。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param rect 描画する矩形
+	 * @param color 描画色
+	 * @return なし
 	 */
 	void mu_draw_rect(mu_Context* ctx, mu_Rect rect, mu_Color color);
 
 	/**
-	 * @brief g`R}hR}hXgɒǉ
-	 * w肵`̈̎lӂɘg`悷R}hǉ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param rect g`悷`
-	 * @param color gF
-	 * @return Ȃ
+	 * @brief 枠線描画コマンドをコマンドリストに追加する
+	 * 指定した矩形領域の四辺に枠線を描画するコマンドを追加します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param rect 枠線を描画する矩形
+	 * @param color 枠線色
+	 * @return なし
 	 */
 	void mu_draw_box(mu_Context* ctx, mu_Rect rect, mu_Color color);
 
 	/**
-	 * @brief eLXg`R}hR}hXgɒǉ
-	 * w肵ʒuEtHgEFŃeLXg`悷R}hǉ܂B
-	 * Nbv̈ɉăNbvR}hǉ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param font tHg
-	 * @param str `悷镶
-	 * @param len 񒷁i-1Ȃ玩j
-	 * @param pos `ʒu
-	 * @param color `F
-	 * @return Ȃ
+	 * @brief テキスト描画コマンドをコマンドリストに追加する
+	 * 指定した位置・フォント・色でテキストを描画するコマンドを追加します。
+	 * クリップ領域に応じてクリップコマンドも追加されます。
+	 * 文字列は今フレームの文字列プールにコピーされます（同じ内容は1つにまとめます）。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param font フォント
+	 * @param str 描画する文字列
+	 * @param len 文字列長（-1なら自動判定）
+	 * @param pos 描画位置
+	 * @param color 描画色
+	 * @return なし
 	 */
 	void mu_draw_text(mu_Context* ctx, mu_Font font, const char* str, int len, mu_Vec2 pos, mu_Color color);
 
 	/**
-	 * @brief ACR`R}hR}hXgɒǉ
-	 * w肵ʒuETCYEFŃACR`悷R}hǉ܂B
-	 * Nbv̈ɉăNbvR}hǉ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param id ACRID
-	 * @param rect `悷`
-	 * @param color `F
-	 * @return Ȃ
+	 * @brief テキスト描画コマンドを文字列をコピーせずに追加する
+	 * mu_draw_textと同じですが、文字列を文字列プールへコピーせず、コマンドから直接参照します。
+	 * 文字列は描画が終わるまで（次のmu_beginまで）変更・解放しないでください。
+	 * 文字列リテラルや固定のラベルに使います。コマンドのstrは終端付きなので、
+	 * strも終端付きでなければなりません（部分文字列はmu_draw_textを使ってください）。
+	 * 使い方: mu_draw_text_static(ctx, font, "Title", -1, pos, color);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param font フォント
+	 * @param str 描画する文字列（終端付き）
+	 * @param len 文字列長（-1かstrlen(str)）
+	 * @param pos 描画位置
+	 * @param color 描画色
+	 * @return なし
+	 */
+	void mu_draw_text_static(mu_Context* ctx, mu_Font font, const char* str, int len, mu_Vec2 pos, mu_Color color);
+
+	/**
+	 * @brief アイコン描画コマンドをコマンドリストに追加する
+	 * 指定した位置・サイズ・色でアイコンを描画するコマンドを追加します。
+	 * クリップ領域に応じてクリップコマンドも追加されます。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param id アイコンID
+	 * @param rect 描画する矩形
+	 * @param color 描画色
+	 * @return なし
 	 */
 	void mu_draw_icon(mu_Context* ctx, int id, mu_Rect rect, mu_Color color);
 
 	/**
-	 * @brief CAEgs̐ݒ
-	 * ݂̃CAEgɐVsݒ肵܂B
-	 * s̃ACeeACe̕Awł܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param items s̃ACe
-	 * @param widths eACe̕iNULL̏ꍇ͎j
-	 * @param height s̍
-	 * @return Ȃ
+	 * @brief レイアウト行の設定
+	 * 現在のレイアウトに新しい行を設定します。
+	 * 行内のアイテム数や各アイテムの幅、高さを指定できます。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param items 行内のアイテム数
+	 * @param widths 各アイテムの幅（NULLの場合は自動）
+	 * @param height 行の高さ
+	 * @return なし
 	 */
 	void mu_layout_row(mu_Context* ctx, int items, const int* widths, int height);
 
 	/**
-	 * @brief CAEg̕ݒ
-	 * ݂̃CAEg̕ĩACe̕jw肵܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param width 
-	 * @return Ȃ
+	 * @brief レイアウトの幅を設定
+	 * 現在のレイアウトの幅（次のアイテムの幅）を指定します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param width 幅
+	 * @return なし
 	 */
 	void mu_layout_width(mu_Context* ctx, int width);
 
 	/**
-	 * @brief CAEg̍ݒ
-	 * ݂̃CAEg̍ĩACe̍jw肵܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param height 
-	 * @return Ȃ
+	 * @brief レイアウトの高さを設定
+	 * 現在のレイアウトの高さ（次のアイテムの高さ）を指定します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param height 高さ
+	 * @return なし
 	 */
 	void mu_layout_height(mu_Context* ctx, int height);
 
 	/**
-	 * @brief JCAEg̊Jn
-	 * ݂̃CAEgʒuɐVJicуCAEgjJn܂B
-	 * J̗vf͏cɐςݏd˂܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief カラムレイアウトの開始
+	 * 現在のレイアウト位置に新しいカラム（縦並びレイアウト）を開始します。
+	 * カラム内の要素は縦方向に積み重ねられます。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_layout_begin_column(mu_Context* ctx);
 
 	/**
-	 * @brief JCAEg̏I
-	 * ݂̃JCAEgIAeCAEgɍőʒus𔽉f܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief カラムレイアウトの終了
+	 * 現在のカラムレイアウトを終了し、親レイアウトに最大位置や行情報を反映します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_layout_end_column(mu_Context* ctx);
 
 	/**
-	 * @brief ̃ACẽCAEgʒuݒ
-	 * ̃ACëʒuETCY΂܂͑΂Ŏw肵܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param r w肷`
-	 * @param relative ΎwȂ1AΎwȂ0
-	 * @return Ȃ
+	 * @brief フレックスレイアウトの開始
+	 * 現在のレイアウト位置の矩形を、itemsの指定に従って横（MU_FLEX_ROW）または
+	 * 縦（MU_FLEX_COLUMN）に分割します。各アイテムは基本サイズから始まり、
+	 * 余りがあればgrowの比率で伸び、足りなければshrinkの比率で縮みます。
+	 * min/maxに達したアイテムは固定して残りで分け直します。サイズは開始時に
+	 * まとめて計算するので、アイテム数が増えても1行ずつ計算し直すことはありません。
+	 * 以降のmu_layout_next（ウィジェット）はアイテムの矩形を順に返します。
+	 * 交差方向はレイアウト位置の矩形いっぱいに広がります。
+	 * 使い方: mu_FlexItem items[3] = { { 80 }, { 0, 1 }, { 60 } };
+	 *         mu_layout_begin_flex(ctx, items, 3, MU_FLEX_ROW, 4);
+	 *         mu_label(ctx, "Name"); mu_textbox(ctx, buf, sizeof(buf)); mu_button(ctx, "OK");
+	 *         mu_layout_end_flex(ctx);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param items アイテムの配列（sizeとoffsetに結果が入る）
+	 * @param count アイテム数
+	 * @param direction MU_FLEX_ROWまたはMU_FLEX_COLUMN
+	 * @param gap アイテム同士の間隔
+	 * @return なし
+	 */
+	void mu_layout_begin_flex(mu_Context* ctx, mu_FlexItem* items, int count, int direction, int gap);
+
+	/**
+	 * @brief フレックスレイアウトの終了
+	 * 親レイアウトに最大位置や行情報を反映します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
+	 */
+	void mu_layout_end_flex(mu_Context* ctx);
+
+	/**
+	 * @brief 次のアイテムのレイアウト位置を設定
+	 * 次のアイテムの位置・サイズを絶対または相対で指定します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param r 指定する矩形
+	 * @param relative 相対指定なら1、絶対指定なら0
+	 * @return なし
 	 */
 	void mu_layout_set_next(mu_Context* ctx, mu_Rect r, int relative);
 
 	/**
-	 * @brief ̃ACẽCAEg`擾
-	 * ݂̃CAEg񂩂玟̃ACëʒuETCYi`jvZĕԂ܂B
-	 * s̃ACe╝EAbodyItZbgACfgȂǂl܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return mu_Rect ̃ACe̋`
+	 * @brief 次のアイテムのレイアウト矩形を取得
+	 * 現在のレイアウト情報から次のアイテムの位置・サイズ（矩形）を計算して返します。
+	 * 行のアイテム数や幅・高さ、bodyオフセット、インデントなどを考慮します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return mu_Rect 次のアイテムの矩形
 	 */
 	mu_Rect mu_layout_next(mu_Context* ctx);
 
 	/**
-	 * @brief Rg[t[`
-	 * Rg[̘gwi`悵܂B
-	 * tH[JXEzo[ԂɉĐFύX܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param id Rg[ID
-	 * @param rect `悷`
-	 * @param colorid FID
-	 * @param opt IvV
+	 * @brief リストの表示範囲を計算する
+	 * count行（1行につきレイアウト1行）のうち、クリップ領域に見えている行の範囲を
+	 * clipper->start～endに設定し、レイアウト位置をstart行目まで進めます。
+	 * 見えている行だけウィジェットを作ればよいので、コストは全体の行数によりません。
+	 * 使い方: mu_list_clipper_begin(ctx, &clip, 100000, 0);
+	 *         for (i = clip.start; i < clip.end; i++) { mu_label(ctx, items[i]); }
+	 *         mu_list_clipper_end(ctx, &clip);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param clipper 結果の格納先
+	 * @param count 全体の行数
+	 * @param row_height 行の高さ（0なら既定の高さ）
+	 * @return なし
+	 */
+	void mu_list_clipper_begin(mu_Context* ctx, mu_ListClipper* clipper, int count, int row_height);
+
+	/**
+	 * @brief リストの終了
+	 * レイアウト位置を最後の行の後ろまで進め、コンテンツサイズに全行分の高さを反映します。
+	 * これによりスクロールバーは全行を作った場合と同じになります。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param clipper mu_list_clipper_beginで設定したもの
+	 * @return なし
+	 */
+	void mu_list_clipper_end(mu_Context* ctx, mu_ListClipper* clipper);
+
+	/**
+	 * @brief 仮想リストの初期化
+	 * 呼び出し側が用意した配列を設定します。slotsの要素数は2のべき乗で、capacityの2倍以上にしてください。
+	 * 使い方: mu_vlist_init(&list, rows, tree, slots, 4096, 8192, 24);
+	 * @param list 仮想リスト
+	 * @param rows 行の配列
+	 * @param tree フェニック木用の配列（rowsと同じ要素数）
+	 * @param slots ID検索用の配列
+	 * @param capacity rowsの要素数
+	 * @param slot_count slotsの要素数
+	 * @param default_height 未作成の行の推定送り幅
+	 * @return なし
+	 */
+	void mu_vlist_init(mu_VirtualList* list, mu_VListRow* rows, int* tree, int* slots,
+		int capacity, int slot_count, int default_height);
+
+	/**
+	 * @brief 仮想リストを空にする
+	 * @param list 仮想リスト
+	 * @return なし
+	 */
+	void mu_vlist_clear(mu_VirtualList* list);
+
+	/**
+	 * @brief 行を末尾に追加する
+	 * O(log n)で追加します。チャットやログのように末尾に増えていくリスト向けです。
+	 * 使い方: mu_vlist_push(&list, message_id, 0);
+	 * @param list 仮想リスト
+	 * @param id 行のID（リスト内で一意）
+	 * @param height 送り幅（0なら推定値、作成時に実測値へ更新される）
+	 * @return int 追加した行番号（容量不足なら-1）
+	 */
+	int mu_vlist_push(mu_VirtualList* list, mu_Id id, int height);
+
+	/**
+	 * @brief IDから行番号を検索する
+	 * @param list 仮想リスト
+	 * @param id 行のID
+	 * @return int 行番号（見つからなければ-1）
+	 */
+	int mu_vlist_find(mu_VirtualList* list, mu_Id id);
+
+	/**
+	 * @brief 行の送り幅を更新する
+	 * 行の内容が変わって高さが変わった場合に呼び出します。O(log n)です。
+	 * @param list 仮想リスト
+	 * @param id 行のID
+	 * @param height 新しい送り幅
+	 * @return なし
+	 */
+	void mu_vlist_set_height(mu_VirtualList* list, mu_Id id, int height);
+
+	/**
+	 * @brief 行のy座標を取得する
+	 * 先頭行からindex行目の上端までの距離を返します。O(log n)です。
+	 * @param list 仮想リスト
+	 * @param index 行番号
+	 * @return int 先頭行からの距離
+	 */
+	int mu_vlist_offset(mu_VirtualList* list, int index);
+
+	/**
+	 * @brief 仮想リストの開始
+	 * クリップ領域の上端に見えている行をO(log n)で求め、レイアウト位置をその行に合わせます。
+	 * 使い方: mu_vlist_begin(ctx, &list);
+	 *         while (mu_vlist_next(ctx, &list, &i)) { mu_layout_row(...); mu_text(ctx, msgs[i]); }
+	 *         mu_vlist_end(ctx, &list);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param list 仮想リスト
+	 * @return なし
+	 */
+	void mu_vlist_begin(mu_Context* ctx, mu_VirtualList* list);
+
+	/**
+	 * @brief 次に作成する行を取得する
+	 * 前の行で実際に進んだ高さを測って送り幅を更新し、次の行へ進みます。
+	 * 行がクリップ領域の下端を越えたら0を返します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param list 仮想リスト
+	 * @param index 作成する行番号の格納先
+	 * @return int 作成する行があれば1
+	 */
+	int mu_vlist_next(mu_Context* ctx, mu_VirtualList* list, int* index);
+
+	/**
+	 * @brief 仮想リストの終了
+	 * レイアウト位置を全行の後ろまで進め、コンテンツサイズに全行分の高さを反映します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param list 仮想リスト
+	 * @return なし
+	 */
+	void mu_vlist_end(mu_Context* ctx, mu_VirtualList* list);
+
+	/**
+	 * @brief コントロールフレーム描画
+	 * コントロールの枠線や背景を描画します。
+	 * フォーカス・ホバー状態に応じて色を変更します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param id コントロールID
+	 * @param rect 描画する矩形
+	 * @param colorid 色ID
+	 * @param opt オプション
 	 */
 	void mu_draw_control_frame(mu_Context* ctx, mu_Id id, mu_Rect rect, int colorid, int opt);
 
 	/**
-	 * @brief Rg[eLXg`
-	 * Rg[ɃeLXg`悵܂B
-	 * zuIvVɉăeLXgʒu𒲐܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param str `悷eLXg
-	 * @param rect `悷`
-	 * @param colorid eLXgFID
-	 * @param opt zuIvV
+	 * @brief コントロールテキスト描画
+	 * コントロール内にテキストを描画します。
+	 * 配置オプションに応じてテキスト位置を調整します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param str 描画するテキスト
+	 * @param rect 描画する矩形
+	 * @param colorid テキスト色ID
+	 * @param opt 配置オプション
 	 */
 	void mu_draw_control_text(mu_Context* ctx, const char* str, mu_Rect rect, int colorid, int opt);
 
 	/**
-	 * @brief }EXI[o[
-	 * }EXw`ɂ邩肵܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param rect 肷`
-	 * @return int }EX`ɂ1AłȂ0
+	 * @brief マウスオーバー判定
+	 * マウスが指定矩形上にあるか判定します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param rect 判定する矩形
+	 * @return int マウスが矩形上にあれば1、そうでなければ0
 	 */
 	int mu_mouse_over(mu_Context* ctx, mu_Rect rect);
 
 	/**
-	 * @brief Rg[ԍXV
-	 * Rg[̃zo[ƃtH[JXԂXV܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param id Rg[ID
-	 * @param rect Rg[`
-	 * @param opt Rg[IvV
-	 * @return Ȃ
+	 * @brief コントロール状態更新
+	 * コントロールのホバーとフォーカス状態を更新します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param id コントロールID
+	 * @param rect コントロール矩形
+	 * @param opt コントロールオプション
+	 * @return なし
 	 */
 	void mu_update_control(mu_Context* ctx, mu_Id id, mu_Rect rect, int opt);
 
@@ -592,182 +1242,291 @@ extern "C" {
 #define mu_begin_panel(ctx, name)         mu_begin_panel_ex(ctx, name, 0)
 
 	/**
-	 * @brief eLXg`
-	 * s̃eLXg`悵܂BIɐ܂Ԃ܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param text `悷eLXg
-	 * @return Ȃ
+	 * @brief テキスト描画
+	 * 複数行のテキストを描画します。自動的に折り返します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param text 描画するテキスト
+	 * @return なし
 	 */
 	void mu_text(mu_Context* ctx, const char* text);
 
 	/**
-	 * @brief x`
-	 * Ps̃xeLXg`悵܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param text `悷eLXg
-	 * @return Ȃ
+	 * @brief ラベル描画
+	 * 単一行のラベルテキストを描画します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param text 描画するテキスト
+	 * @return なし
 	 */
 	void mu_label(mu_Context* ctx, const char* text);
 
 	/**
-	 * @brief g{^`E
-	 * eLXg܂̓ACRt̃{^`悵As܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param label {^xiNULL̏ꍇ̓ACR̂݁j
-	 * @param icon ACRIDi0̏ꍇ̓eLXĝ݁j
-	 * @param opt {^IvV
-	 * @return int ꂽMU_RES_SUBMITAłȂ0
+	 * @brief 拡張ボタン描画・押下判定
+	 * テキストまたはアイコン付きのボタンを描画し、押下判定を行います。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param label ボタンラベル（NULLの場合はアイコンのみ）
+	 * @param icon アイコンID（0の場合はテキストのみ）
+	 * @param opt ボタンオプション
+	 * @return int 押されたらMU_RES_SUBMIT、そうでなければ0
 	 */
 	int mu_button_ex(mu_Context* ctx, const char* label, int icon, int opt);
 
 	/**
-	 * @brief `FbN{bNX`EԍXV
-	 * `FbN{bNX`悵AԂXV܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param label `FbN{bNXx
-	 * @param state `FbNԂi[ϐւ̃|C^
-	 * @return int ԂωMU_RES_CHANGEAłȂ0
+	 * @brief チェックボックス描画・状態更新
+	 * チェックボックスを描画し、状態を更新します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param label チェックボックスラベル
+	 * @param state チェック状態を格納する変数へのポインタ
+	 * @return int 状態が変化したらMU_RES_CHANGE、そうでなければ0
 	 */
 	int mu_checkbox(mu_Context* ctx, const char* label, int* state);
 
 	/**
-	 * @brief eLXg{bNX`E͏i{֐j
-	 * eLXg{bNX`悵AeLXg͏s܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param buf ̓eLXgi[obt@
-	 * @param bufsz obt@TCY
-	 * @param id eLXg{bNXID
-	 * @param r eLXg{bNX`
-	 * @param opt IvV
-	 * @return int ͕ωMU_RES_CHANGEAm莞MU_RES_SUBMIT
+	 * @brief テキストボックス描画・入力処理（基本関数）
+	 * テキストボックスを描画し、テキスト入力処理を行います。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param buf 入力テキスト格納バッファ
+	 * @param bufsz バッファサイズ
+	 * @param id テキストボックスID
+	 * @param r テキストボックス矩形
+	 * @param opt オプション
+	 * @return int 入力変化時MU_RES_CHANGE、確定時MU_RES_SUBMIT
 	 */
 	int mu_textbox_raw(mu_Context* ctx, char* buf, int bufsz, mu_Id id, mu_Rect r, int opt);
 
 	/**
-	 * @brief eLXg{bNX`E͏ig֐j
-	 * eLXg{bNX`悵AeLXg͏s܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param buf ̓eLXgi[obt@
-	 * @param bufsz obt@TCY
-	 * @param opt IvV
-	 * @return int ͕ωMU_RES_CHANGEAm莞MU_RES_SUBMIT
+	 * @brief テキストボックス描画・入力処理（拡張関数）
+	 * テキストボックスを描画し、テキスト入力処理を行います。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param buf 入力テキスト格納バッファ
+	 * @param bufsz バッファサイズ
+	 * @param opt オプション
+	 * @return int 入力変化時MU_RES_CHANGE、確定時MU_RES_SUBMIT
 	 */
 	int mu_textbox_ex(mu_Context* ctx, char* buf, int bufsz, int opt);
 
 	/**
-	 * @brief XC_[`El擾
-	 * XC_[`悵Al擾܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param value XC_[limu_Real*j
-	 * @param low ŏl
-	 * @param high ől
-	 * @param step Xebvl
-	 * @param fmt \tH[}bg
-	 * @param opt IvV
-	 * @return int lωMU_RES_CHANGE
+	 * @brief スライダー描画・値取得
+	 * スライダーを描画し、値を取得します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param value スライダー値（mu_Real*）
+	 * @param low 最小値
+	 * @param high 最大値
+	 * @param step ステップ値
+	 * @param fmt 表示フォーマット
+	 * @param opt オプション
+	 * @return int 値変化時MU_RES_CHANGE
 	 */
 	int mu_slider_ex(mu_Context* ctx, mu_Real* value, mu_Real low, mu_Real high, mu_Real step, const char* fmt, int opt);
 
 	/**
-	 * @brief l͕`El擾
-	 * l̓Rg[`悵Al擾܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param value llimu_Real*j
-	 * @param step Xebvl
-	 * @param fmt \tH[}bg
-	 * @param opt IvV
-	 * @return int lωMU_RES_CHANGE
+	 * @brief 数値入力描画・値取得
+	 * 数値入力コントロールを描画し、値を取得します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param value 数値値（mu_Real*）
+	 * @param step ステップ値
+	 * @param fmt 表示フォーマット
+	 * @param opt オプション
+	 * @return int 値変化時MU_RES_CHANGE
 	 */
 	int mu_number_ex(mu_Context* ctx, mu_Real* value, mu_Real step, const char* fmt, int opt);
 
 	/**
-	 * @brief wb_[`EԊǗ
-	 * ܂肽݉\ȃwb_[`悵܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param label wb_[eLXg
-	 * @param opt IvV
-	 * @return int WJĂMU_RES_ACTIVEAłȂ0
+	 * @brief ヘッダー描画・状態管理
+	 * 折りたたみ可能なヘッダーを描画します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param label ヘッダーテキスト
+	 * @param opt オプション
+	 * @return int 展開されていればMU_RES_ACTIVE、そうでなければ0
 	 */
 	int mu_header_ex(mu_Context* ctx, const char* label, int opt);
 
 	/**
-	 * @brief c[m[hJn
-	 * ܂肽݉\ȃc[m[hJn܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param label m[hx
-	 * @param opt IvV
-	 * @return int WJĂMU_RES_ACTIVEAłȂ0
+	 * @brief ツリーノード開始
+	 * 折りたたみ可能なツリーノードを開始します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param label ノードラベル
+	 * @param opt オプション
+	 * @return int 展開されていればMU_RES_ACTIVE、そうでなければ0
 	 */
 	int mu_begin_treenode_ex(mu_Context* ctx, const char* label, int opt);
 
 	/**
-	 * @brief c[m[hI
-	 * mu_begin_treenodeŊJnc[m[hI܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief ツリーノード終了
+	 * mu_begin_treenodeで開始したツリーノードを終了します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_end_treenode(mu_Context* ctx);
 
 	/**
-	 * @brief EBhEJn֐
-	 * MicroUĨEBhEJnA`EǗs܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param title EBhE^Cg
-	 * @param rect EBhËʒuƃTCY
-	 * @param opt EBhE̓IvV
-	 * @return int EBhEANeBuȂMU_RES_ACTIVEAANeBuȂ0
+	 * @brief 表の初期化
+	 * 列の配列と並べ替え用の設定を表に設定します。
+	 * 使い方: mu_table_init(&table, columns, 50, order, compare, data);
+	 * @param table 表
+	 * @param columns 列の配列
+	 * @param column_count 列数
+	 * @param order 表示順の行番号を入れる配列（行数分、NULLなら並べ替えなし）
+	 * @param compare 比較関数（NULLなら並べ替えなし）
+	 * @param udata 比較関数に渡すデータ
+	 * @return なし
+	 */
+	void mu_table_init(mu_Table* table, mu_TableColumn* columns, int column_count,
+		int* order, mu_TableCompare compare, void* udata);
+
+	/**
+	 * @brief 表の開始
+	 * 列の位置を計算し、クリップ領域に見えている行と列の範囲を
+	 * row_start～row_end、col_start～col_endに設定します。並べ替えの順番は
+	 * versionか並べ替える列、行数が変わった時だけ作り直します。
+	 * 使い方: mu_begin_table(ctx, &table, rows, version, 0);
+	 *         for (r = table.row_start; r < table.row_end; r++) {
+	 *           for (c = table.col_start; c < table.col_end; c++) {
+	 *             mu_table_cell(ctx, &table, r, c);
+	 *             mu_label(ctx, cell_text(mu_table_row(&table, r), c));
+	 *           }
+	 *         }
+	 *         mu_end_table(ctx, &table);
+	 * @param ctx MicroUIのコンテキスト
+	 * @param table 表
+	 * @param rows 行数
+	 * @param version データのバージョン（データが変わったら変える）
+	 * @param opt オプション（MU_OPT_NORESIZEで列幅を固定）
+	 * @return なし
+	 */
+	void mu_begin_table(mu_Context* ctx, mu_Table* table, int rows, int version, int opt);
+
+	/**
+	 * @brief 表のセルをレイアウトに設定する
+	 * 次のウィジェットがr行目（表示順）c列目のセルに配置されるようにします。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param table 表
+	 * @param r 表示順の行番号
+	 * @param c 列番号
+	 * @return mu_Rect セルの矩形
+	 */
+	mu_Rect mu_table_cell(mu_Context* ctx, mu_Table* table, int r, int c);
+
+	/**
+	 * @brief 表示順から元データの行番号を取得する
+	 * @param table 表
+	 * @param r 表示順の行番号
+	 * @return int 元データの行番号
+	 */
+	int mu_table_row(mu_Table* table, int r);
+
+	/**
+	 * @brief 表の終了
+	 * 見出しを描画し（スクロールしても上端に残る）、クリックによる並べ替えと
+	 * 列幅の変更を処理します。レイアウトとコンテンツサイズは表全体の大きさだけ進めます。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param table 表
+	 * @return なし
+	 */
+	void mu_end_table(mu_Context* ctx, mu_Table* table);
+
+	/**
+	 * @brief ツリーの初期化
+	 * rootの子を最上位の行として並べます。それより下はデータ取得用コールバックで
+	 * 展開した時にだけ読み込むため、ツリー全体の大きさによらず動作します。
+	 * 使い方: mu_tree_init(&tree, rows, 65536, &source, root);
+	 * @param tree ツリー
+	 * @param rows 行の配列
+	 * @param capacity 行の配列の要素数（同時に見えるノードの上限）
+	 * @param source データ取得用コールバック
+	 * @param root 根のノード（表示しない）
+	 * @return なし
+	 */
+	void mu_tree_init(mu_TreeView* tree, mu_TreeRow* rows, int capacity, const mu_TreeSource* source, mu_Id root);
+
+	/**
+	 * @brief 行の展開
+	 * index行目のノードの子をその直後に挿入します。ずらすのは後ろの行だけです。
+	 * @param tree ツリー
+	 * @param index 行番号
+	 * @return int 展開できれば1（子が無い・容量不足なら0）
+	 */
+	int mu_tree_expand(mu_TreeView* tree, int index);
+
+	/**
+	 * @brief 行の折りたたみ
+	 * index行目より深い後続の行（子孫）を取り除きます。
+	 * @param tree ツリー
+	 * @param index 行番号
+	 * @return なし
+	 */
+	void mu_tree_collapse(mu_TreeView* tree, int index);
+
+	/**
+	 * @brief ツリーの描画・操作
+	 * クリップ領域に見えている行だけを描画します。矢印のクリックで展開・折りたたみし、
+	 * ラベルのクリックでselectedを更新します。
+	 * 使い方: if (mu_tree_view(ctx, &tree) & MU_RES_SUBMIT) { open(tree.selected); }
+	 * @param ctx MicroUIのコンテキスト
+	 * @param tree ツリー
+	 * @return int 展開状態が変わればMU_RES_CHANGE、選択されればMU_RES_SUBMIT
+	 */
+	int mu_tree_view(mu_Context* ctx, mu_TreeView* tree);
+
+	/**
+	 * @brief ウィンドウ開始関数
+	 * MicroUIのウィンドウを開始し、描画・管理を行います。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param title ウィンドウタイトル文字列
+	 * @param rect ウィンドウの位置とサイズ
+	 * @param opt ウィンドウの動作オプション
+	 * @return int ウィンドウがアクティブならMU_RES_ACTIVE、非アクティブなら0
 	 */
 	int mu_begin_window_ex(mu_Context* ctx, const char* title, mu_Rect rect, int opt);
 
 	/**
-	 * @brief EBhEI֐
-	 * mu_begin_window_exŊJnEBhȄI܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief ウィンドウ終了関数
+	 * mu_begin_window_exで開始したウィンドウの処理を終了します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_end_window(mu_Context* ctx);
 
 	/**
-	 * @brief |bvAbvEBhEJ
-	 * w肵Õ|bvAbvEBhE}EXʒuɕ\܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param name |bvAbvEBhE
-	 * @return Ȃ
+	 * @brief ポップアップウィンドウを開く
+	 * 指定した名前のポップアップウィンドウをマウス位置に表示します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param name ポップアップウィンドウ名
+	 * @return なし
 	 */
 	void mu_open_popup(mu_Context* ctx, const char* name);
 
 	/**
-	 * @brief |bvAbvEBhEJn֐
-	 * |bvAbvEBhE̕`EǗJn܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param name |bvAbvEBhE
-	 * @return int |bvAbvANeBuȂMU_RES_ACTIVEAANeBuȂ0
+	 * @brief ポップアップウィンドウ開始関数
+	 * ポップアップウィンドウの描画・管理を開始します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param name ポップアップウィンドウ名
+	 * @return int ポップアップがアクティブならMU_RES_ACTIVE、非アクティブなら0
 	 */
 	int mu_begin_popup(mu_Context* ctx, const char* name);
 
 	/**
-	 * @brief |bvAbvEBhEI֐
-	 * mu_begin_popupŊJn|bvAbvEBhȄI܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief ポップアップウィンドウ終了関数
+	 * mu_begin_popupで開始したポップアップウィンドウの処理を終了します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_end_popup(mu_Context* ctx);
 
 	/**
-	 * @brief plJn֐
-	 * pl̕`EǗJn܂B
-	 * @param ctx MicroUĨReLXg
-	 * @param name pl
-	 * @param opt pl̓IvV
-	 * @return Ȃ
+	 * @brief パネル開始関数
+	 * パネルの描画・管理を開始します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @param name パネル名
+	 * @param opt パネルの動作オプション
+	 * @return なし
 	 */
 	void mu_begin_panel_ex(mu_Context* ctx, const char* name, int opt);
 
 	/**
-	 * @brief plI֐
-	 * mu_begin_panel_exŊJnpl̏I܂B
-	 * @param ctx MicroUĨReLXg
-	 * @return Ȃ
+	 * @brief パネル終了関数
+	 * mu_begin_panel_exで開始したパネルの処理を終了します。
+	 * @param ctx MicroUIのコンテキスト
+	 * @return なし
 	 */
 	void mu_end_panel(mu_Context* ctx);
 
@@ -0,0 +1,240 @@
+﻿/*
+** 階層プロファイラ (microui用)
+** 区間はスレッドごとのリングバッファに終了時に書き込みます。
+** 子の区間が親より先に記録されますが、表示は時刻と深さだけで行うので問題ありません。
+*/
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include <stdio.h>
+#include <string.h>
+#include "profile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+#define MU_THREAD_LOCAL __declspec(thread)
+#else
+#define MU_THREAD_LOCAL __thread
+#endif
+
+/* 呼び出したスレッドの記録先 */
+static MU_THREAD_LOCAL mu_ProfileBuffer *current;
+
+static const mu_Color zone_colors[] = {
+  { 196, 120,  64, 255 }, {  90, 150, 200, 255 }, { 120, 180,  90, 255 },
+  { 200, 170,  70, 255 }, { 160, 110, 190, 255 }, {  80, 170, 160, 255 },
+};
+
+
+/**
+ * @brief 現在時刻（内部関数）
+ * @return mu_ProfileTime 単調増加する時刻（ナノ秒）
+ */
+static mu_ProfileTime profile_now(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if (!freq.QuadPart) { QueryPerformanceFrequency(&freq); }
+  QueryPerformanceCounter(&t);
+  return (mu_ProfileTime) ((double) t.QuadPart * 1e9 / (double) freq.QuadPart);
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (mu_ProfileTime) t.tv_sec * 1000000000 + t.tv_nsec;
+#endif
+}
+
+
+void mu_profile_thread(mu_ProfileBuffer *buf, const char *thread) {
+  if (buf) {
+    memset(buf, 0, sizeof(*buf));
+    buf->thread = thread;
+    buf->frame_start[0] = profile_now();
+  }
+  current = buf;
+}
+
+
+void mu_profile_enter(const char *name) {
+  mu_ProfileBuffer *b = current;
+  if (!b) { return; }
+  /* 深すぎる区間は数だけ合わせて記録しない */
+  if (b->depth < MU_PROFILE_DEPTH) {
+    b->stack_name[b->depth] = name;
+    b->stack_start[b->depth] = profile_now();
+  }
+  b->depth++;
+}
+
+
+void mu_profile_leave(void) {
+  mu_ProfileBuffer *b = current;
+  mu_ProfileZone *z;
+  if (!b || b->depth == 0) { return; }
+  b->depth--;
+  if (b->depth >= MU_PROFILE_DEPTH) { return; }
+  z = &b->zones[b->zone_count & (MU_PROFILE_ZONES - 1)];
+  z->name = b->stack_name[b->depth];
+  z->start = b->stack_start[b->depth];
+  z->end = profile_now();
+  z->depth = b->depth;
+  z->frame = b->frame;
+  b->zone_count++;
+}
+
+
+void mu_profile_next_frame(void) {
+  mu_ProfileBuffer *b = current;
+  if (!b) { return; }
+  b->frame++;
+  b->frame_start[b->frame & (MU_PROFILE_FRAMES - 1)] = profile_now();
+}
+
+
+/*============================================================================
+** window
+**============================================================================*/
+
+/**
+ * @brief 区間の色（内部関数）
+ * 名前から色を決めるので、同じ区間はどのフレームでも同じ色になります。
+ */
+static mu_Color zone_color(const char *name) {
+  unsigned h = 2166136261u;
+  while (*name) { h = (h ^ (unsigned char) *name++) * 16777619u; }
+  return zone_colors[h % (sizeof(zone_colors) / sizeof(zone_colors[0]))];
+}
+
+
+/**
+ * @brief フレームの長さ（内部関数）
+ * @return mu_ProfileTime 開始時刻の差（ナノ秒）
+ */
+static mu_ProfileTime frame_length(const mu_ProfileBuffer *b, int f) {
+  return b->frame_start[(f + 1) & (MU_PROFILE_FRAMES - 1)] - b->frame_start[f & (MU_PROFILE_FRAMES - 1)];
+}
+
+
+/**
+ * @brief 1スレッド分のフレームグラフ（内部関数）
+ * リングバッファを新しい方から走査して、フレームfの区間を深さごとの段に描画します。
+ * @param ctx MicroUIのコンテキスト
+ * @param b 記録先
+ * @param f 表示するフレーム
+ * @param info マウスが乗っている区間の説明の格納先
+ * @return なし
+ */
+static void flame_graph(mu_Context *ctx, const mu_ProfileBuffer *b, int f, char *info) {
+  mu_Font font = ctx->style->font;
+  int row_h = ctx->text_height(font) + 4;
+  int i, first, depth = 0, full = -1;
+  mu_ProfileTime fs = b->frame_start[f & (MU_PROFILE_FRAMES - 1)];
+  mu_ProfileTime len = frame_length(b, f);
+  mu_Rect r;
+
+  first = mu_max(b->zone_count - MU_PROFILE_ZONES, 0);
+  for (i = b->zone_count - 1; i >= first; i--) {
+    const mu_ProfileZone *z = &b->zones[i & (MU_PROFILE_ZONES - 1)];
+    if (z->frame < f) { break; }
+    if (z->frame == f) { depth = mu_max(depth, z->depth + 1); }
+  }
+
+  mu_layout_row(ctx, 1, &full, 0);
+  mu_label(ctx, b->thread ? b->thread : "thread");
+  mu_layout_row(ctx, 1, &full, mu_max(depth, 1) * row_h);
+  r = mu_layout_next(ctx);
+  mu_draw_rect(ctx, r, ctx->style->colors[MU_COLOR_BASE]);
+  if (len <= 0) { return; }
+
+  mu_push_clip_rect(ctx, r);
+  for (i = b->zone_count - 1; i >= first; i--) {
+    const mu_ProfileZone *z = &b->zones[i & (MU_PROFILE_ZONES - 1)];
+    mu_Rect zr;
+    if (z->frame < f) { break; }
+    if (z->frame != f) { continue; }
+    zr.x = r.x + (int) ((double) (z->start - fs) * r.w / len);
+    zr.w = mu_max((int) ((double) (z->end - z->start) * r.w / len), 1);
+    zr.y = r.y + z->depth * row_h;
+    zr.h = row_h - 1;
+    mu_draw_rect(ctx, zr, zone_color(z->name));
+    if (zr.w > ctx->text_width(font, z->name, -1) + 4) {
+      mu_push_clip_rect(ctx, zr);
+      mu_draw_text(ctx, font, z->name, -1, mu_vec2(zr.x + 2, zr.y + 2), ctx->style->colors[MU_COLOR_TEXT]);
+      mu_pop_clip_rect(ctx);
+    }
+    if (mu_mouse_over(ctx, zr)) {
+      sprintf(info, "%.40s  %.3f ms", z->name, (z->end - z->start) / 1e6);
+    }
+  }
+  mu_pop_clip_rect(ctx);
+}
+
+
+void mu_profile_window(mu_Context *ctx, const char *title, mu_ProfileView *view,
+  mu_ProfileBuffer **buffers, int count)
+{
+  const mu_ProfileBuffer *base;
+  char info[64];
+  int i, f, n, oldest, latest, selected, full = -1;
+  mu_ProfileTime longest = 1;
+  mu_Id id;
+  mu_Rect r;
+
+  if (!mu_begin_window(ctx, title, mu_rect(40, 40, 640, 360))) { return; }
+  base = count > 0 ? buffers[0] : NULL;
+  if (!base || base->frame < 2) {
+    mu_layout_row(ctx, 1, &full, 0);
+    mu_label(ctx, "No profile data (build with MU_PROFILE)");
+    mu_end_window(ctx);
+    return;
+  }
+
+  /* 完了したフレーム（次のフレームの開始時刻がある）の範囲 */
+  latest = base->frame - 1;
+  oldest = mu_max(base->frame - MU_PROFILE_FRAMES + 1, 1);
+  if (view->pinned < oldest || view->pinned > latest) { view->pinned = -1; }
+  selected = view->pinned >= 0 ? view->pinned : latest;
+
+  /* タイムライン: 直近のフレーム時間の棒グラフ */
+  mu_layout_row(ctx, 1, &full, 60);
+  r = mu_layout_next(ctx);
+  id = mu_get_id(ctx, "!timeline", 9);
+  mu_update_control(ctx, id, r, 0);
+  mu_draw_rect(ctx, r, ctx->style->colors[MU_COLOR_BASE]);
+  n = latest - oldest + 1;
+  for (f = oldest; f <= latest; f++) { longest = mu_max(longest, frame_length(base, f)); }
+  for (f = oldest; f <= latest; f++) {
+    int x0 = r.x + (f - oldest) * r.w / n, x1 = r.x + (f - oldest + 1) * r.w / n;
+    int h = mu_max((int) ((double) frame_length(base, f) * (r.h - 2) / longest), 1);
+    mu_Rect bar = mu_rect(x0, r.y + r.h - h, mu_max(x1 - x0 - 1, 1), h);
+    int colorid = f == selected ? MU_COLOR_BUTTONFOCUS : MU_COLOR_BUTTON;
+    mu_draw_rect(ctx, bar, ctx->style->colors[colorid]);
+    if (ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id &&
+        ctx->mouse_pos.x >= x0 && ctx->mouse_pos.x < x1)
+    {
+      view->pinned = view->pinned == f ? -1 : f;
+    }
+  }
+
+  /* フレームグラフ: スレッドごとに選んだフレームの区間 */
+  sprintf(info, "frame %d  %.3f ms%s", selected, frame_length(base, selected) / 1e6,
+    view->pinned >= 0 ? "  (pinned)" : "");
+  for (i = 0; i < count; i++) {
+    const mu_ProfileBuffer *b = buffers[i];
+    if (!b) { continue; }
+    /* 他のスレッドは同じ番号のフレームがなければ最新の完了したフレームを表示 */
+    f = selected;
+    if (b != base && (f >= b->frame || f <= b->frame - MU_PROFILE_FRAMES)) { f = b->frame - 1; }
+    if (f < 0) { continue; }
+    flame_graph(ctx, b, f, info);
+  }
+
+  mu_layout_row(ctx, 1, &full, 0);
+  mu_label(ctx, info);
+  mu_end_window(ctx);
+}
@@ -0,0 +1,134 @@
+/**
+ * 階層プロファイラ (microui用)
+ * mu_profile_begin/mu_profile_endで囲んだ区間の開始・終了時刻を、スレッドごとの
+ * リングバッファに記録します。microui.cはレイアウト、ホバー更新、テキスト計測、
+ * コマンド追加、mu_endの並べ替え・ジャンプ設定などを、renderer.cは描画の
+ * フラッシュを区間として記録します。mu_profile_windowは直近のフレームを
+ * タイムラインとフレームグラフで表示します。
+ *
+ * MU_PROFILEを定義してビルドした場合だけ記録します。定義しなければ
+ * mu_profile_begin/end/frameは空のマクロになり、コストはかかりません。
+ *
+ * 使い方:
+ *   static mu_ProfileBuffer ui_prof;             ... スレッドごとに1つ（静的領域かヒープ）
+ *   mu_profile_thread(&ui_prof, "UI");           ... スレッドの開始時に1度
+ *   mu_profile_begin("update"); ... mu_profile_end();
+ *   static mu_ProfileView view;                  ... ウィンドウごとの表示状態
+ *   mu_profile_window(ctx, "Profiler", &view, buffers, 1);  ... 記録したフレームの表示
+ *
+ * mu_beginがmu_profile_frameを呼んでフレームを区切ります。microuiを使わない
+ * スレッド（描画スレッドなど）は、自分のループの先頭でmu_profile_frameを呼んでください。
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MU_PROFILE_ZONES
+#define MU_PROFILE_ZONES  65536  /* 記録できる区間の数（2のべき乗） */
+#endif
+#define MU_PROFILE_FRAMES 128    /* フレームの開始時刻を覚えておく数（2のべき乗） */
+#define MU_PROFILE_DEPTH  32     /* 区間の入れ子の深さ */
+
+#if defined(_MSC_VER)
+  typedef __int64 mu_ProfileTime;
+#else
+  typedef long long mu_ProfileTime;
+#endif
+
+/* 記録した区間（時刻はナノ秒） */
+typedef struct {
+  const char *name;      /* 文字列リテラルなど、表示するまで残るもの */
+  mu_ProfileTime start, end;
+  int depth;
+  int frame;
+} mu_ProfileZone;
+
+/* スレッドごとの記録先 */
+typedef struct {
+  const char *thread;
+  mu_ProfileZone zones[MU_PROFILE_ZONES];
+  int zone_count;        /* 記録した区間の累計（zones[zone_count % MU_PROFILE_ZONES]が次） */
+  mu_ProfileTime frame_start[MU_PROFILE_FRAMES];
+  int frame;             /* 現在のフレーム番号 */
+  const char *stack_name[MU_PROFILE_DEPTH];
+  mu_ProfileTime stack_start[MU_PROFILE_DEPTH];
+  int depth;
+} mu_ProfileBuffer;
+
+/* プロファイラウィンドウの表示状態（ウィンドウごとに1つ、0で初期化してよい） */
+typedef struct {
+  int pinned;            /* 固定したフレーム（範囲外なら最新を表示） */
+} mu_ProfileView;
+
+#ifdef MU_PROFILE
+#define mu_profile_begin(name) mu_profile_enter(name)
+#define mu_profile_end()       mu_profile_leave()
+#define mu_profile_frame()     mu_profile_next_frame()
+#else
+#define mu_profile_begin(name) ((void) 0)
+#define mu_profile_end()       ((void) 0)
+#define mu_profile_frame()     ((void) 0)
+#endif
+
+/**
+ * @brief 記録先の設定
+ * 呼び出したスレッドの記録先を設定します。設定していないスレッドでは何も記録しません。
+ * 使い方: mu_profile_thread(&ui_prof, "UI");
+ * @param buf 記録先（約2MBあるので静的領域かヒープに置く。NULLなら記録をやめる）
+ * @param thread 表示用のスレッド名
+ * @return なし
+ */
+void mu_profile_thread(mu_ProfileBuffer *buf, const char *thread);
+
+/**
+ * @brief 区間の開始（mu_profile_beginから呼ばれる）
+ * 使い方: mu_profile_enter("layout");
+ * @param name 区間の名前
+ * @return なし
+ */
+void mu_profile_enter(const char *name);
+
+/**
+ * @brief 区間の終了（mu_profile_endから呼ばれる）
+ * 直前に開始した区間を閉じて記録します。
+ * 使い方: mu_profile_leave();
+ * @return なし
+ */
+void mu_profile_leave(void);
+
+/**
+ * @brief フレームの区切り（mu_profile_frameから呼ばれる）
+ * フレーム番号を進め、開始時刻を記録します。
+ * 使い方: mu_profile_next_frame();
+ * @return なし
+ */
+void mu_profile_next_frame(void);
+
+/**
+ * @brief プロファイラウィンドウ
+ * 上段に直近のフレーム時間の棒グラフ（タイムライン）を、下段に選んだフレームの
+ * 区間をスレッドごとに入れ子の深さで積んだフレームグラフを表示します。
+ * 棒をクリックするとそのフレームに固定し、もう1度クリックすると最新に戻ります。
+ * 区間にマウスを乗せると名前と時間を表示します。MU_PROFILEなしでビルドした場合は
+ * その旨だけを表示します。他のスレッドの記録は書き込み中でない完了済みのフレームだけを読みます。
+ * 使い方: mu_profile_window(ctx, "Profiler", &view, buffers, 2);
+ * @param ctx MicroUIのコンテキスト
+ * @param title ウィンドウのタイトル
+ * @param view 表示状態（固定したフレーム。ウィンドウやコンテキストごとに別のものを渡す）
+ * @param buffers 表示する記録先の配列（先頭のスレッドのフレームをタイムラインに使う）
+ * @param count 配列の要素数
+ * @return なし
+ */
+void mu_profile_window(mu_Context *ctx, const char *title, mu_ProfileView *view,
+  mu_ProfileBuffer **buffers, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
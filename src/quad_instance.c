@@ -0,0 +1,317 @@
+﻿/**
+ * 四角形インスタンス変換モジュール (microui用)
+ * 詳細はquad_instance.hを参照してください。
+ */
+#include <string.h>
+#include "quad_instance.h"
+
+static mu_Rect unclipped_rect = { 0, 0, 0x1000000, 0x1000000 };
+
+/* インスタンスが16バイトに収まっていることをコンパイル時に確認 */
+typedef char quad_instance_size_check[sizeof(mu_QuadInstance) == 16 ? 1 : -1];
+
+
+void mu_quad_list_init(mu_QuadList *list, mu_QuadInstance *items, int capacity,
+  mu_QuadBatch *batches, int batch_capacity)
+{
+  memset(list, 0, sizeof(*list));
+  list->items = items;
+  list->capacity = capacity;
+  list->batches = batches;
+  list->batch_capacity = batch_capacity;
+}
+
+
+/**
+ * @brief UTF-8を1文字デコード（内部関数）
+ * 不正なバイト列は読み飛ばし、0を返します。
+ * @param p 読み取り位置（進められる）
+ * @return unsigned コードポイント（不正な場合0）
+ */
+static unsigned decode_utf8(const unsigned char **p) {
+  const unsigned char *s = *p;
+  unsigned cp;
+  int n, i;
+  if      ((*s & 0x80) == 0x00) { *p = s + 1; return *s; }
+  else if ((*s & 0xe0) == 0xc0) { cp = *s & 0x1f; n = 1; }
+  else if ((*s & 0xf0) == 0xe0) { cp = *s & 0x0f; n = 2; }
+  else if ((*s & 0xf8) == 0xf0) { cp = *s & 0x07; n = 3; }
+  else { *p = s + 1; return 0; }
+  for (i = 1; i <= n; i++) {
+    if ((s[i] & 0xc0) != 0x80) { *p = s + i; return 0; }
+    cp = (cp << 6) | (s[i] & 0x3f);
+  }
+  *p = s + n + 1;
+  return cp;
+}
+
+
+/**
+ * @brief インスタンスを1つ追加（内部関数）
+ * @return int 追加できれば1、容量不足なら0
+ */
+static int push_instance(mu_QuadList *list, mu_Rect dst, int u, int v, mu_Color color) {
+  mu_QuadInstance *q;
+  if (list->count >= list->capacity) { list->overflow = 1; return 0; }
+  q = &list->items[list->count++];
+  q->x = (short) mu_clamp(dst.x, -0x8000, 0x7fff);
+  q->y = (short) mu_clamp(dst.y, -0x8000, 0x7fff);
+  q->w = (unsigned short) mu_clamp(dst.w, 0, 0xffff);
+  q->h = (unsigned short) mu_clamp(dst.h, 0, 0xffff);
+  q->u = (unsigned short) u;
+  q->v = (unsigned short) v;
+  q->color = color;
+  list->batches[list->batch_count - 1].count++;
+  return 1;
+}
+
+
+/**
+ * @brief クリップ矩形の切り替え（内部関数）
+ * 現在のバッチが空ならクリップ矩形を差し替え、そうでなければ新しいバッチを開始します。
+ * @return int 成功なら1、バッチ配列の容量不足なら0
+ */
+static int set_clip(mu_QuadList *list, mu_Rect clip) {
+  mu_QuadBatch *b = &list->batches[list->batch_count - 1];
+  if (b->count == 0) { b->clip = clip; return 1; }
+  if (memcmp(&b->clip, &clip, sizeof(clip)) == 0) { return 1; }
+  if (list->batch_count >= list->batch_capacity) { list->overflow = 1; return 0; }
+  b = &list->batches[list->batch_count++];
+  b->offset = list->count;
+  b->count = 0;
+  b->clip = clip;
+  return 1;
+}
+
+
+/**
+ * @brief コマンド1つをインスタンスに変換（内部関数）
+ * @return なし
+ */
+static void emit_command(mu_QuadList *list, const mu_QuadAtlas *atlas, mu_Command *cmd) {
+  int solid_u = (atlas->white.x + atlas->white.w / 2) | MU_QUAD_SOLID;
+  int solid_v = atlas->white.y + atlas->white.h / 2;
+  switch (cmd->type) {
+    case MU_COMMAND_CLIP:
+      set_clip(list, cmd->clip.rect);
+      break;
+
+    case MU_COMMAND_RECT:
+      push_instance(list, cmd->rect.rect, solid_u, solid_v, cmd->rect.color);
+      break;
+
+    case MU_COMMAND_ICON: {
+      mu_Rect src, r = cmd->icon.rect;
+      int id = cmd->icon.id;
+      if (id < MU_ICON_CLOSE || id >= MU_ICON_MAX) {
+        /* 未定義のアイコンは単色矩形として描画 */
+        push_instance(list, r, solid_u, solid_v, cmd->icon.color);
+        break;
+      }
+      src = atlas->icons[id];
+      r = mu_rect(r.x + (r.w - src.w) / 2, r.y + (r.h - src.h) / 2, src.w, src.h);
+      push_instance(list, r, src.x, src.y, cmd->icon.color);
+      break;
+    }
+
+    case MU_COMMAND_TEXT: {
+      const unsigned char *p = (const unsigned char*) cmd->text.str;
+      int x = cmd->text.pos.x;
+      while (*p) {
+        mu_Rect src;
+        mu_Vec2 ofs;
+        int adv;
+        unsigned cp = decode_utf8(&p);
+        if (!cp || !atlas->glyph(atlas->udata, cp, &src, &ofs, &adv)) { continue; }
+        if (src.w > 0 && src.h > 0) {
+          mu_Rect dst = mu_rect(x + ofs.x, cmd->text.pos.y + ofs.y, src.w, src.h);
+          if (!push_instance(list, dst, src.x, src.y, cmd->text.color)) { break; }
+        }
+        x += adv;
+      }
+      break;
+    }
+  }
+}
+
+
+/**
+ * @brief 出力の初期化（内部関数）
+ * 先頭のバッチを指定したクリップ矩形で作成します。
+ * @return int 成功なら1、バッチ配列が空なら0
+ */
+static int reset_list(mu_QuadList *list, mu_Rect clip) {
+  list->count = 0;
+  list->overflow = 0;
+  if (list->batch_capacity < 1) { list->overflow = 1; return 0; }
+  list->batch_count = 1;
+  list->batches[0].offset = 0;
+  list->batches[0].count = 0;
+  list->batches[0].clip = clip;
+  return 1;
+}
+
+
+/**
+ * @brief コマンドが出力しうるインスタンス数の上限（内部関数）
+ * TEXTは1バイト1インスタンスとして数えるので、文字列を走査せずに求まります。
+ * @return int インスタンス数の上限
+ */
+static int instance_bound(mu_Command *cmd) {
+  switch (cmd->type) {
+    case MU_COMMAND_RECT: return 1;
+    case MU_COMMAND_ICON: return 1;
+    case MU_COMMAND_TEXT: return cmd->text.len;
+  }
+  return 0;
+}
+
+
+int mu_quad_build(mu_Context *ctx, const mu_QuadAtlas *atlas, mu_QuadList *list) {
+  mu_Command *cmd = NULL;
+  if (!reset_list(list, unclipped_rect)) { return 0; }
+  while (!list->overflow && mu_next_command(ctx, &cmd)) {
+    emit_command(list, atlas, cmd);
+  }
+  return list->count;
+}
+
+
+int mu_quad_split(mu_Context *ctx, mu_QuadList *list, mu_QuadJob *jobs, int max_jobs, int chunk) {
+  mu_CommandScratch scratch;
+  char *pos = ctx->command_list.items;
+  char *end = ctx->command_list.items + ctx->command_list.idx;
+  mu_Rect clip = unclipped_rect;
+  mu_QuadJob *job = NULL;
+  int n = 0, offset = 0, batch_offset = 0;
+  list->count = 0;
+  list->batch_count = 0;
+  list->overflow = 0;
+
+  /* ジョブの境目をコマンドの位置で持つため、mu_next_commandではなく1つずつ読み出す */
+  while (pos != end) {
+    char *at = pos;
+    mu_Command *cmd = mu_read_command(ctx, &pos, &scratch);
+    int bound, batches, next;
+    if (cmd->type == MU_COMMAND_JUMP) { pos = cmd->jump.dst; continue; }
+    bound = instance_bound(cmd);
+    batches = (cmd->type == MU_COMMAND_CLIP) ? 1 : 0;
+    /* 担当分がchunkを超えたらコマンドの境目で次のジョブに切り替える */
+    next = !job || (job->capacity >= chunk && n < max_jobs);
+    if (next && n >= max_jobs) { break; }
+    /* 新しいジョブは先頭のバッチを1つ使うので、それも含めて収まるかを先に確かめる */
+    if (offset + bound > list->capacity || batch_offset + next + batches > list->batch_capacity) {
+      /* 収まらない分は変換しない（mu_quad_buildと同じく途中で打ち切る） */
+      list->overflow = 1;
+      if (job) { job->end = at; }
+      break;
+    }
+    if (next) {
+      if (job) { job->end = at; }
+      job = &jobs[n++];
+      job->ctx = ctx;
+      job->begin = at;
+      job->end = NULL;
+      job->clip = clip;
+      job->offset = offset;
+      job->capacity = 0;
+      job->batch_offset = batch_offset;
+      job->batch_capacity = 1;
+      batch_offset++;
+    }
+    if (cmd->type == MU_COMMAND_CLIP) { clip = cmd->clip.rect; }
+    job->capacity += bound;
+    job->batch_capacity += batches;
+    offset += bound;
+    batch_offset += batches;
+  }
+  if (job && !job->end) { job->end = end; }
+  return n;
+}
+
+
+void mu_quad_run(const mu_QuadAtlas *atlas, mu_QuadList *list, mu_QuadJob *job) {
+  mu_QuadList sub;
+  mu_CommandScratch scratch;
+  char *pos = job->begin;
+  sub.items = list->items + job->offset;
+  sub.capacity = job->capacity;
+  sub.batches = list->batches + job->batch_offset;
+  sub.batch_capacity = job->batch_capacity;
+  reset_list(&sub, job->clip);
+  while (pos != job->end) {
+    mu_Command *cmd = mu_read_command(job->ctx, &pos, &scratch);
+    if (cmd->type == MU_COMMAND_JUMP) { pos = cmd->jump.dst; continue; }
+    emit_command(&sub, atlas, cmd);
+  }
+  /* 上限より少なかった分は大きさ0のインスタンスで埋め、先頭から一括で描画しても安全にする */
+  memset(sub.items + sub.count, 0, (sub.capacity - sub.count) * sizeof(mu_QuadInstance));
+  job->count = sub.count;
+  job->batch_count = sub.batch_count;
+}
+
+
+int mu_quad_merge(mu_QuadList *list, const mu_QuadJob *jobs, int count) {
+  int i, k;
+  list->batch_count = 0;
+  list->count = 0;
+  for (i = 0; i < count; i++) {
+    const mu_QuadJob *job = &jobs[i];
+    for (k = 0; k < job->batch_count; k++) {
+      mu_QuadBatch b = list->batches[job->batch_offset + k];
+      mu_QuadBatch *last = list->batch_count ? &list->batches[list->batch_count - 1] : NULL;
+      if (b.count == 0) { continue; }
+      b.offset += job->offset;
+      /* 前のジョブと連続していて同じクリップなら1つにまとめる */
+      if (last && last->offset + last->count == b.offset &&
+          memcmp(&last->clip, &b.clip, sizeof(b.clip)) == 0) {
+        last->count += b.count;
+        continue;
+      }
+      list->batches[list->batch_count++] = b;
+    }
+    if (job->count > 0) { list->count = job->offset + job->count; }
+  }
+  return list->count;
+}
+
+
+void mu_quad_expand(const mu_QuadInstance *items, int count,
+  const mu_QuadAtlas *atlas, mu_QuadVertex *out)
+{
+  float iw = 1.0f / (float) atlas->width;
+  float ih = 1.0f / (float) atlas->height;
+  int i, k;
+  for (i = 0; i < count; i++) {
+    const mu_QuadInstance *q = &items[i];
+    unsigned color = ((unsigned) q->color.a << 24) | ((unsigned) q->color.r << 16) |
+                     ((unsigned) q->color.g << 8) | q->color.b;
+    int solid = q->u & MU_QUAD_SOLID;
+    float u0 = (float) (q->u & 0x7fff) * iw;
+    float v0 = (float) q->v * ih;
+    float du = solid ? 0.0f : q->w * iw;
+    float dv = solid ? 0.0f : q->h * ih;
+    /* 頂点の並びはpush_quadと同じ（左上・右上・左下・右下） */
+    for (k = 0; k < 4; k++) {
+      int cx = k & 1, cy = k >> 1;
+      out->x = (float) (q->x + cx * q->w);
+      out->y = (float) (q->y + cy * q->h);
+      out->z = 0.5f;
+      out->color = color;
+      out->u = u0 + cx * du;
+      out->v = v0 + cy * dv;
+      out++;
+    }
+  }
+}
+
+
+void mu_quad_indices(unsigned short *out, int quads) {
+  int i;
+  for (i = 0; i < quads; i++) {
+    unsigned short base = (unsigned short) (i * 4);
+    out[0] = base + 0; out[1] = base + 1; out[2] = base + 2;
+    out[3] = base + 2; out[4] = base + 1; out[5] = base + 3;
+    out += 6;
+  }
+}
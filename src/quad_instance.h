@@ -0,0 +1,178 @@
+/**
+ * 四角形インスタンス変換モジュール (microui用)
+ * コマンドリストを1四角形あたり16バイトのインスタンス列に変換します。
+ * プラットフォーム非依存（Windows/D3Dヘッダーを使わない）なので
+ * Linuxでもそのままビルド・計測できます。
+ *
+ * push_quadは1四角形ごとに24バイトの頂点4つとインデックス6つ（約108バイト）を
+ * 書き込みますが、インスタンス形式なら16バイトで済みます。
+ * バックエンドは頂点シェーダーで次のように展開します。
+ *
+ *   corner = (0,0) (1,0) (0,1) (1,1)
+ *   pos    = (x, y) + corner * (w, h)
+ *   uv     = (u & 0x7fff, v) + ((u & MU_QUAD_SOLID) ? 0 : corner * (w, h))
+ *   uv    /= (atlas.width, atlas.height)
+ *
+ * グリフとアイコンはアトラス上と同じ大きさで描画されるため、
+ * アトラス矩形は左上座標だけを持ちます。単色矩形は白パッチの1テクセルを
+ * 引き伸ばして描画します（MU_QUAD_SOLID）。
+ */
+#ifndef QUAD_INSTANCE_H
+#define QUAD_INSTANCE_H
+
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* uの最上位ビット: 単色矩形（アトラス上の1点をサンプリング） */
+#define MU_QUAD_SOLID 0x8000
+
+/* 四角形インスタンス（16バイト） */
+typedef struct {
+  short x, y;            /* 描画先の左上 */
+  unsigned short w, h;   /* 描画先のサイズ（グリフ・アイコンはアトラス上のサイズと同じ） */
+  unsigned short u, v;   /* アトラス上の左上（uにMU_QUAD_SOLIDを含むことがある） */
+  mu_Color color;        /* RGBA8 */
+} mu_QuadInstance;
+
+/* 同じクリップ矩形で描画できるインスタンスの範囲 */
+typedef struct {
+  int offset, count;
+  mu_Rect clip;
+} mu_QuadBatch;
+
+/* 変換結果の格納先（配列は呼び出し側が用意する） */
+typedef struct {
+  mu_QuadInstance *items;
+  int count, capacity;
+  mu_QuadBatch *batches;
+  int batch_count, batch_capacity;
+  int overflow;          /* 容量不足で打ち切った場合1 */
+} mu_QuadList;
+
+/* アトラスの情報とグリフ検索コールバック */
+typedef struct {
+  int width, height;               /* アトラス画像のサイズ */
+  mu_Rect white;                   /* 白パッチ */
+  mu_Rect icons[MU_ICON_MAX];      /* アイコン（MU_ICON_CLOSEから） */
+  /* コードポイントのグリフを返す。offsetは描画位置からのずれ。見つからなければ0 */
+  int (*glyph)(void *udata, unsigned codepoint, mu_Rect *src, mu_Vec2 *offset, int *xadvance);
+  void *udata;
+} mu_QuadAtlas;
+
+/* 並列変換の1ジョブ分（mu_quad_splitが作成し、mu_quad_runが埋める） */
+typedef struct {
+  mu_Context *ctx;           /* 走査するコンテキスト（MU_COMPACT_COMMANDSの展開に使う） */
+  char *begin, *end;         /* 担当するコマンドの範囲（コマンドリスト内の位置。z順に走査、endは含まない） */
+  mu_Rect clip;              /* 開始時点のクリップ矩形 */
+  int offset, capacity;      /* 出力先インスタンスのスライス */
+  int batch_offset, batch_capacity; /* 出力先バッチのスライス */
+  int count, batch_count;    /* 実際に出力した数 */
+} mu_QuadJob;
+
+/* CPU展開用の頂点（renderer.hのstruct Vertexと同じ24バイトの並び） */
+typedef struct {
+  float x, y, z;
+  unsigned color;        /* D3DCOLOR形式（ARGB） */
+  float u, v;
+} mu_QuadVertex;
+
+/**
+ * @brief インスタンスリストの初期化
+ * 呼び出し側が用意した配列をインスタンスリストに設定します。
+ * 使い方: mu_quad_list_init(&list, items, 4096, batches, 256);
+ * @param list インスタンスリスト
+ * @param items インスタンス配列
+ * @param capacity インスタンス配列の要素数
+ * @param batches バッチ配列
+ * @param batch_capacity バッチ配列の要素数
+ * @return なし
+ */
+void mu_quad_list_init(mu_QuadList *list, mu_QuadInstance *items, int capacity,
+  mu_QuadBatch *batches, int batch_capacity);
+
+/**
+ * @brief コマンドリストをインスタンスに変換
+ * mu_end後のコマンドリストを走査し、RECT/TEXT/ICONを1四角形につき1インスタンスとして
+ * 出力します。CLIPコマンドごとにバッチを区切ります。
+ * 使い方: mu_quad_build(ctx, &atlas, &list);
+ * @param ctx MicroUIのコンテキスト
+ * @param atlas アトラス情報
+ * @param list 出力先（countとbatch_countは先頭から書き直される）
+ * @return int 出力したインスタンス数
+ */
+int mu_quad_build(mu_Context *ctx, const mu_QuadAtlas *atlas, mu_QuadList *list);
+
+/**
+ * @brief 並列変換用にコマンドリストを分割
+ * mu_end後のコマンドリストをz順に走査し、インスタンス数の上限がおよそchunkになるよう
+ * コマンドの境目で区切ってジョブを作成します。各ジョブには出力先のスライス
+ * （上限分）が重ならないように割り当てられるので、ワーカーは互いに干渉せず
+ * 最終的な配列へ直接書き込めます。文字列は走査しないので分割は軽量です。
+ * 使い方: n = mu_quad_split(ctx, &list, jobs, 64, 4096);
+ * @param ctx MicroUIのコンテキスト
+ * @param list 出力先（容量が足りなければ途中で打ち切りoverflowを1にする）
+ * @param jobs ジョブ配列
+ * @param max_jobs ジョブ配列の要素数（足りなければ最後のジョブが残りを全て受け持つ）
+ * @param chunk 1ジョブあたりのインスタンス数の目安
+ * @return int 作成したジョブ数
+ */
+int mu_quad_split(mu_Context *ctx, mu_QuadList *list, mu_QuadJob *jobs, int max_jobs, int chunk);
+
+/**
+ * @brief ジョブ1つ分の変換（ワーカースレッド）
+ * 担当範囲のコマンドを自分のスライスへ変換します。別々のジョブは
+ * 同時に実行できます（atlas->glyphはスレッドセーフである必要があります）。
+ * 使い方: mu_quad_run(&atlas, &list, &jobs[i]);
+ * @param atlas アトラス情報
+ * @param list 出力先（mu_quad_splitに渡したもの）
+ * @param job 実行するジョブ
+ * @return なし
+ */
+void mu_quad_run(const mu_QuadAtlas *atlas, mu_QuadList *list, mu_QuadJob *job);
+
+/**
+ * @brief ジョブの結果をまとめる
+ * 全ジョブの完了後に呼び出し、各ジョブのバッチをz順に詰めてlistのバッチにします。
+ * インスタンスは移動しません。スライスの余りは大きさ0のインスタンスで埋まっているため、
+ * countまで一括で描画しても、バッチごとに描画しても結果は同じです。
+ * 使い方: mu_quad_merge(&list, jobs, n);
+ * @param list 出力先
+ * @param jobs ジョブ配列
+ * @param count ジョブ数
+ * @return int 描画するインスタンスの範囲（先頭からの数）
+ */
+int mu_quad_merge(mu_QuadList *list, const mu_QuadJob *jobs, int count);
+
+/**
+ * @brief インスタンスを頂点に展開（CPU参照実装）
+ * 頂点シェーダーと同じ計算でインスタンスを4頂点ずつに展開します。
+ * インスタンス描画ができないバックエンドや、シェーダーの検証に使います。
+ * 使い方: mu_quad_expand(list.items, list.count, &atlas, vertices);
+ * @param items インスタンス配列
+ * @param count インスタンス数
+ * @param atlas アトラス情報（UV正規化用）
+ * @param out 出力先（count * 4頂点）
+ * @return なし
+ */
+void mu_quad_expand(const mu_QuadInstance *items, int count,
+  const mu_QuadAtlas *atlas, mu_QuadVertex *out);
+
+/**
+ * @brief 四角形用インデックスの生成
+ * 0,1,2,2,1,3の並びをquads個分書き込みます。
+ * インデックスはフレームごとに変わらないので起動時に1度だけ作成します。
+ * 使い方: mu_quad_indices(indices, MAX_VERTICES / 4);
+ * @param out 出力先（quads * 6要素）
+ * @param quads 四角形の数（16384以下）
+ * @return なし
+ */
+void mu_quad_indices(unsigned short *out, int quads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,721 @@
+﻿/**
+ * リモート表示モジュール (microui用)
+ * 詳細はremote.hを参照してください。
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include "remote.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define close_socket closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#define close_socket close
+#endif
+
+#define NO_SOCKET ((mu_Socket) -1)
+
+#define MSG_FRAME 1
+#define MSG_INPUT 2
+#define MSG_RESYNC 3
+
+#define SEGMENT_REF  0
+#define SEGMENT_DATA 1
+
+#define LZ_HASH_BITS 12
+#define LZ_MIN_MATCH 4
+#define LZ_WINDOW    65535
+
+
+/*============================================================================
+** buffer
+**============================================================================*/
+
+static unsigned char* buffer_reserve(mu_RemoteBuffer *b, int n) {
+  if (b->size + n > b->capacity) {
+    int capacity = b->capacity ? b->capacity : 4096;
+    unsigned char *data;
+    while (capacity < b->size + n) { capacity *= 2; }
+    data = realloc(b->data, capacity);
+    if (!data) { return NULL; }
+    b->data = data;
+    b->capacity = capacity;
+  }
+  return b->data + b->size;
+}
+
+static void buffer_put(mu_RemoteBuffer *b, const void *src, int n) {
+  unsigned char *p = buffer_reserve(b, n);
+  if (p) { memcpy(p, src, n); b->size += n; }
+}
+
+static void buffer_byte(mu_RemoteBuffer *b, int v) {
+  unsigned char c = (unsigned char) v;
+  buffer_put(b, &c, 1);
+}
+
+static void buffer_uint(mu_RemoteBuffer *b, unsigned v) {
+  while (v >= 0x80) {
+    buffer_byte(b, (v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  buffer_byte(b, v);
+}
+
+static void buffer_int(mu_RemoteBuffer *b, int v) {
+  buffer_uint(b, ((unsigned) v << 1) ^ (unsigned) -(v < 0));
+}
+
+static void buffer_u32(mu_RemoteBuffer *b, unsigned v) {
+  unsigned char c[4];
+  c[0] = v & 0xff; c[1] = v >> 8 & 0xff; c[2] = v >> 16 & 0xff; c[3] = v >> 24 & 0xff;
+  buffer_put(b, c, 4);
+}
+
+static void buffer_free(mu_RemoteBuffer *b) {
+  free(b->data);
+  b->data = NULL;
+  b->size = b->capacity = 0;
+}
+
+
+/* 読み出し位置（範囲外を読もうとしたらokを0にする） */
+typedef struct {
+  const unsigned char *p, *end;
+  int ok;
+} Reader;
+
+static unsigned read_uint(Reader *r) {
+  unsigned v = 0;
+  int shift = 0;
+  for (;;) {
+    int c;
+    if (r->p >= r->end || shift > 28) { r->ok = 0; return 0; }
+    c = *r->p++;
+    v |= (unsigned) (c & 0x7f) << shift;
+    if (!(c & 0x80)) { return v; }
+    shift += 7;
+  }
+}
+
+static int read_int(Reader *r) {
+  unsigned v = read_uint(r);
+  return (int) (v >> 1) ^ -(int) (v & 1);
+}
+
+static unsigned read_u32(const unsigned char *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (unsigned) p[3] << 24;
+}
+
+static unsigned hash_bytes(unsigned h, const unsigned char *p, int n) {
+  while (n-- > 0) { h = (h ^ *p++) * 16777619u; }
+  return h;
+}
+
+
+/*============================================================================
+** compression
+**============================================================================*/
+
+/**
+ * @brief LZ77圧縮（内部関数）
+ * 直前64KB以内の4バイト以上の一致を（長さ, 距離）に置き換えます。
+ * 出力は「リテラル長, リテラル, 一致長-4, 距離」の繰り返しで、最後はリテラルで終わります。
+ * @param src 入力
+ * @param n 入力の長さ
+ * @param out 出力先（末尾に追加する）
+ * @return なし
+ */
+static void lz_compress(const unsigned char *src, int n, mu_RemoteBuffer *out) {
+  int table[1 << LZ_HASH_BITS];
+  int i = 0, anchor = 0;
+  memset(table, -1, sizeof(table));
+  while (i + LZ_MIN_MATCH <= n) {
+    unsigned h = (read_u32(src + i) * 2654435761u) >> (32 - LZ_HASH_BITS);
+    int cand = table[h];
+    table[h] = i;
+    if (cand >= 0 && i - cand <= LZ_WINDOW && memcmp(src + cand, src + i, LZ_MIN_MATCH) == 0) {
+      int len = LZ_MIN_MATCH;
+      while (i + len < n && src[cand + len] == src[i + len]) { len++; }
+      buffer_uint(out, i - anchor);
+      buffer_put(out, src + anchor, i - anchor);
+      buffer_uint(out, len - LZ_MIN_MATCH);
+      buffer_uint(out, i - cand);
+      i += len;
+      anchor = i;
+    } else {
+      i++;
+    }
+  }
+  buffer_uint(out, n - anchor);
+  buffer_put(out, src + anchor, n - anchor);
+}
+
+
+/**
+ * @brief LZ77展開（内部関数）
+ * @param r 圧縮データ
+ * @param out 出力先（先頭から書き直す）
+ * @param size 展開後の長さ
+ * @return int 成功したら1
+ */
+static int lz_decompress(Reader *r, mu_RemoteBuffer *out, int size) {
+  unsigned char *dst;
+  out->size = 0;
+  if (!buffer_reserve(out, size)) { return 0; }
+  dst = out->data;
+  for (;;) {
+    int lit = read_uint(r), len, dist;
+    if (!r->ok || lit > size - out->size || lit > r->end - r->p) { return 0; }
+    memcpy(dst + out->size, r->p, lit);
+    r->p += lit;
+    out->size += lit;
+    if (r->p == r->end) { return out->size == size; }
+    len = read_uint(r) + LZ_MIN_MATCH;
+    dist = read_uint(r);
+    if (!r->ok || dist <= 0 || dist > out->size || len > size - out->size) { return 0; }
+    /* 重なりがあり得るので1バイトずつ */
+    while (len-- > 0) { dst[out->size] = dst[out->size - dist]; out->size++; }
+  }
+}
+
+
+/*============================================================================
+** socket
+**============================================================================*/
+
+/**
+ * @brief ソケットの作成（内部関数）
+ * "unix:パス" ならUnixドメイン、それ以外は "ホスト:ポート" のTCPです。
+ * @param address アドレス
+ * @param server 1なら待ち受け、0なら接続
+ * @return mu_Socket ソケット、失敗したらNO_SOCKET
+ */
+static mu_Socket open_socket(const char *address, int server) {
+  mu_Socket s = NO_SOCKET;
+  struct addrinfo hints, *res, *ai;
+  char host[256];
+  const char *colon;
+#ifdef _WIN32
+  static int started;
+  WSADATA wsa;
+  if (!started) { WSAStartup(MAKEWORD(2, 2), &wsa); started = 1; }
+#else
+  if (strncmp(address, "unix:", 5) == 0) {
+    struct sockaddr_un sun;
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    if (strlen(address + 5) >= sizeof(sun.sun_path)) { return NO_SOCKET; }
+    strcpy(sun.sun_path, address + 5);
+    s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s == NO_SOCKET) { return NO_SOCKET; }
+    if (server) { unlink(sun.sun_path); }
+    if (server ? bind(s, (struct sockaddr*) &sun, sizeof(sun)) != 0 || listen(s, 1) != 0
+               : connect(s, (struct sockaddr*) &sun, sizeof(sun)) != 0)
+    {
+      close_socket(s);
+      return NO_SOCKET;
+    }
+    return s;
+  }
+#endif
+  colon = strrchr(address, ':');
+  if (!colon || colon - address >= (int) sizeof(host)) { return NO_SOCKET; }
+  memcpy(host, address, colon - address);
+  host[colon - address] = '\0';
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = server ? AI_PASSIVE : 0;
+  if (getaddrinfo(host[0] ? host : NULL, colon + 1, &hints, &res) != 0) { return NO_SOCKET; }
+  for (ai = res; ai; ai = ai->ai_next) {
+    int one = 1;
+    s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (s == NO_SOCKET) { continue; }
+    if (server) {
+      setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*) &one, sizeof(one));
+      if (bind(s, ai->ai_addr, (int) ai->ai_addrlen) == 0 && listen(s, 1) == 0) { break; }
+    } else if (connect(s, ai->ai_addr, (int) ai->ai_addrlen) == 0) {
+      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*) &one, sizeof(one));
+      break;
+    }
+    close_socket(s);
+    s = NO_SOCKET;
+  }
+  freeaddrinfo(res);
+  return s;
+}
+
+
+/**
+ * @brief 読み込み可能になるまで待つ（内部関数）
+ * @return int 読み込めるなら1
+ */
+static int wait_readable(mu_Socket s, int timeout_ms) {
+  fd_set set;
+  struct timeval tv;
+  FD_ZERO(&set);
+  FD_SET(s, &set);
+  tv.tv_sec = timeout_ms / 1000;
+  tv.tv_usec = (timeout_ms % 1000) * 1000;
+  return select((int) s + 1, &set, NULL, NULL, &tv) > 0;
+}
+
+
+/**
+ * @brief 全て送る（内部関数）
+ * @return int 成功したら1
+ */
+static int send_all(mu_Socket s, const unsigned char *p, int n) {
+  while (n > 0) {
+    int sent = send(s, (const char*) p, n, 0);
+    if (sent <= 0) { return 0; }
+    p += sent;
+    n -= sent;
+  }
+  return 1;
+}
+
+
+/**
+ * @brief 届いている分を受け取る（内部関数）
+ * @param s ソケット
+ * @param b 受信バッファ（末尾に追加する）
+ * @param timeout_ms 何も届いていないときに待つ時間
+ * @return int 切断されたら-1、それ以外は受け取ったバイト数
+ */
+static int receive_available(mu_Socket s, mu_RemoteBuffer *b, int timeout_ms) {
+  int total = 0;
+  while (wait_readable(s, total ? 0 : timeout_ms)) {
+    unsigned char *p = buffer_reserve(b, 65536);
+    int n;
+    if (!p) { return -1; }
+    n = recv(s, (char*) p, 65536, 0);
+    if (n <= 0) { return -1; }
+    b->size += n;
+    total += n;
+  }
+  return total;
+}
+
+
+/**
+ * @brief メッセージの送信（内部関数）
+ * @return int 成功したら1
+ */
+static int send_message(mu_Socket s, int type, mu_RemoteBuffer *scratch, const unsigned char *body, int n) {
+  scratch->size = 0;
+  buffer_u32(scratch, n + 1);
+  buffer_byte(scratch, type);
+  buffer_put(scratch, body, n);
+  return scratch->size == n + 5 && send_all(s, scratch->data, scratch->size);
+}
+
+
+/*============================================================================
+** server
+**============================================================================*/
+
+/**
+ * @brief フォントの番号（内部関数）
+ * @return int 番号（表が一杯ならMU_REMOTE_FONTS。クライアントではNULLになる）
+ */
+static int font_id(mu_RemoteServer *srv, mu_Font font) {
+  int i;
+  for (i = 0; i < srv->font_count; i++) {
+    if (srv->fonts[i] == font) { return i; }
+  }
+  if (srv->font_count == MU_REMOTE_FONTS) { return MU_REMOTE_FONTS; }
+  srv->fonts[srv->font_count] = font;
+  return srv->font_count++;
+}
+
+
+/**
+ * @brief ルートコンテナのコマンドを符号化（内部関数）
+ * headの次からtailまでを走査します。途中のJUMP（入れ子のルートコンテナや
+ * mu_endで隠れたコマンド）は飛び先へ進みます。
+ */
+static void encode_commands(mu_RemoteServer *srv, mu_Context *ctx, mu_Container *cnt, mu_RemoteBuffer *out) {
+  char *pos = (char*) cnt->head + sizeof(mu_JumpCommand);
+  mu_Command *cmd;
+  while ((cmd = mu_read_command(ctx, &pos, &srv->scratch)) != cnt->tail) {
+    int len;
+    if (cmd->type == MU_COMMAND_JUMP) { pos = cmd->jump.dst; continue; }
+    buffer_byte(out, cmd->type);
+    switch (cmd->type) {
+      case MU_COMMAND_CLIP:
+        buffer_int(out, cmd->clip.rect.x); buffer_int(out, cmd->clip.rect.y);
+        buffer_int(out, cmd->clip.rect.w); buffer_int(out, cmd->clip.rect.h);
+        break;
+      case MU_COMMAND_RECT:
+        buffer_int(out, cmd->rect.rect.x); buffer_int(out, cmd->rect.rect.y);
+        buffer_int(out, cmd->rect.rect.w); buffer_int(out, cmd->rect.rect.h);
+        buffer_put(out, &cmd->rect.color, 4);
+        break;
+      case MU_COMMAND_ICON:
+        buffer_int(out, cmd->icon.rect.x); buffer_int(out, cmd->icon.rect.y);
+        buffer_int(out, cmd->icon.rect.w); buffer_int(out, cmd->icon.rect.h);
+        buffer_uint(out, cmd->icon.id);
+        buffer_put(out, &cmd->icon.color, 4);
+        break;
+      case MU_COMMAND_TEXT:
+        len = cmd->text.len;
+        buffer_byte(out, font_id(srv, cmd->text.font));
+        buffer_int(out, cmd->text.pos.x); buffer_int(out, cmd->text.pos.y);
+        buffer_put(out, &cmd->text.color, 4);
+        buffer_uint(out, len);
+        buffer_put(out, cmd->text.str, len);
+        break;
+    }
+  }
+}
+
+
+/**
+ * @brief 1つのルートコンテナをフレームに追加（内部関数）
+ * 前に送った内容と同じなら参照だけを追加します。
+ */
+static void add_segment(mu_RemoteServer *srv, mu_Context *ctx, mu_Container *cnt, unsigned *hash) {
+  int key = (int) (cnt - ctx->containers);
+  unsigned h;
+  srv->segment.size = 0;
+  encode_commands(srv, ctx, cnt, &srv->segment);
+  h = hash_bytes(2166136261u, srv->segment.data, srv->segment.size) | 1;
+  *hash = hash_bytes(*hash, srv->segment.data, srv->segment.size);
+  srv->raw_bytes += srv->segment.size;
+  srv->segments++;
+  buffer_uint(&srv->frame, key);
+  if (srv->hashes[key] == h) {
+    buffer_byte(&srv->frame, SEGMENT_REF);
+    srv->refs++;
+    return;
+  }
+  srv->hashes[key] = h;
+  buffer_byte(&srv->frame, SEGMENT_DATA);
+  buffer_uint(&srv->frame, srv->segment.size);
+  buffer_put(&srv->frame, srv->segment.data, srv->segment.size);
+}
+
+
+static void drop_client(mu_RemoteServer *srv) {
+  if (srv->client != NO_SOCKET) { close_socket(srv->client); }
+  srv->client = NO_SOCKET;
+  srv->recv.size = 0;
+  /* 次のクライアントには全てのコンテナを送り直す */
+  memset(srv->hashes, 0, sizeof(srv->hashes));
+}
+
+
+int mu_remote_listen(mu_RemoteServer *srv, const char *address) {
+  memset(srv, 0, sizeof(*srv));
+  srv->client = NO_SOCKET;
+  srv->listener = open_socket(address, 1);
+  return srv->listener != NO_SOCKET;
+}
+
+
+int mu_remote_poll(mu_RemoteServer *srv, mu_Context *ctx) {
+  int pos = 0;
+  if (srv->listener == NO_SOCKET) { return 0; }
+  if (srv->client == NO_SOCKET) {
+    int one = 1;
+    if (!wait_readable(srv->listener, 0)) { return 0; }
+    srv->client = accept(srv->listener, NULL, NULL);
+    if (srv->client == NO_SOCKET) { return 0; }
+    setsockopt(srv->client, IPPROTO_TCP, TCP_NODELAY, (const char*) &one, sizeof(one));
+  }
+  if (receive_available(srv->client, &srv->recv, 0) < 0) {
+    drop_client(srv);
+    return 0;
+  }
+
+  /* 届いた入力を順にmu_input_*で適用する */
+  while (srv->recv.size - pos >= 4) {
+    int n = (int) read_u32(srv->recv.data + pos);
+    Reader r;
+    int type, x, y, code, len;
+    if (n < 1 || n > (1 << 20)) { drop_client(srv); return 0; }
+    if (srv->recv.size - pos - 4 < n) { break; }
+    r.p = srv->recv.data + pos + 5;
+    r.end = srv->recv.data + pos + 4 + n;
+    r.ok = 1;
+    pos += 4 + n;
+    if (r.p[-1] == MSG_RESYNC) {
+      /* クライアントのキャッシュが食い違っているので、次のフレームは参照を使わない */
+      memset(srv->hashes, 0, sizeof(srv->hashes));
+      srv->resyncs++;
+      continue;
+    }
+    if (r.p[-1] != MSG_INPUT) { continue; }
+    type = read_uint(&r);
+    x = read_int(&r);
+    y = read_int(&r);
+    code = (int) read_uint(&r);
+    len = read_uint(&r);
+    if (!r.ok) { continue; }
+    switch (type) {
+      case MU_EVENT_MOUSEMOVE: mu_input_mousemove(ctx, x, y); break;
+      case MU_EVENT_MOUSEDOWN: mu_input_mousedown(ctx, x, y, code); break;
+      case MU_EVENT_MOUSEUP: mu_input_mouseup(ctx, x, y, code); break;
+      case MU_EVENT_SCROLL: mu_input_scroll(ctx, x, y); break;
+      case MU_EVENT_KEYDOWN: mu_input_keydown(ctx, code); break;
+      case MU_EVENT_KEYUP: mu_input_keyup(ctx, code); break;
+      case MU_EVENT_TIME: mu_input_time(ctx, (unsigned) code); break;
+      case MU_EVENT_TEXT:
+        /* 文字列は終端付きで送られてくる */
+        if (len > 0 && len <= r.end - r.p && r.p[len - 1] == '\0') { mu_input_text(ctx, (const char*) r.p); }
+        break;
+    }
+  }
+  memmove(srv->recv.data, srv->recv.data + pos, srv->recv.size - pos);
+  srv->recv.size -= pos;
+  return 1;
+}
+
+
+int mu_remote_send_frame(mu_RemoteServer *srv, mu_Context *ctx) {
+  char *pos = ctx->command_list.items;
+  char *end = ctx->command_list.items + ctx->command_list.idx;
+  mu_Command *cmd = NULL;
+  unsigned hash = 2166136261u;
+  int i = 0, n = ctx->root_list.idx;
+  if (srv->client == NO_SOCKET) { return 0; }
+  srv->frame.size = 0;
+  srv->raw_bytes = srv->refs = srv->segments = 0;
+
+  /* mu_endが繋いだJUMPを辿り、表示されるルートコンテナを順に追加する。
+  ** ジャンプの順はroot_list（zindex順）と同じで、隠れたコンテナだけが抜けている */
+  if (pos != end) { cmd = mu_read_command(ctx, &pos, &srv->scratch); }
+  while (cmd && cmd->type == MU_COMMAND_JUMP) {
+    char *dst = cmd->jump.dst;
+    mu_Container *cnt = NULL;
+    if (dst == end) { break; }
+    for (; i < n; i++) {
+      if ((char*) ctx->root_list.items[i]->head + sizeof(mu_JumpCommand) == dst) {
+        cnt = ctx->root_list.items[i++];
+        break;
+      }
+    }
+    if (!cnt) { break; }
+    add_segment(srv, ctx, cnt, &hash);
+    cmd = cnt->tail;
+  }
+
+  /* 本体: 展開後の長さ, ハッシュ, 圧縮データ */
+  srv->packed.size = 0;
+  buffer_u32(&srv->packed, srv->frame.size);
+  buffer_u32(&srv->packed, hash);
+  lz_compress(srv->frame.data, srv->frame.size, &srv->packed);
+  if (!send_message(srv->client, MSG_FRAME, &srv->segment, srv->packed.data, srv->packed.size)) {
+    drop_client(srv);
+    return 0;
+  }
+  srv->sent_bytes = srv->packed.size + 5;
+  return 1;
+}
+
+
+void mu_remote_close_server(mu_RemoteServer *srv) {
+  drop_client(srv);
+  if (srv->listener != NO_SOCKET) { close_socket(srv->listener); }
+  srv->listener = NO_SOCKET;
+  buffer_free(&srv->frame);
+  buffer_free(&srv->segment);
+  buffer_free(&srv->packed);
+  buffer_free(&srv->recv);
+}
+
+
+/*============================================================================
+** client
+**============================================================================*/
+
+int mu_remote_connect(mu_RemoteClient *cli, const char *address) {
+  memset(cli, 0, sizeof(*cli));
+  cli->sock = open_socket(address, 0);
+  return cli->sock != NO_SOCKET;
+}
+
+
+/**
+ * @brief 符号化したコマンドを1つコマンドリストに戻す（内部関数）
+ * @return int 成功したら1
+ */
+static int decode_command(mu_RemoteClient *cli, mu_Context *ctx, Reader *r) {
+  int type = *r->p++, len, font = 0;
+  mu_Rect rect = { 0, 0, 0, 0 };
+  mu_Vec2 pos = { 0, 0 };
+  mu_Color color = { 0, 0, 0, 0 };
+  mu_Command cmd;
+  switch (type) {
+    case MU_COMMAND_CLIP: case MU_COMMAND_RECT: case MU_COMMAND_ICON: break;
+    case MU_COMMAND_TEXT:
+      if (r->p >= r->end) { return 0; }
+      font = *r->p++;
+      pos.x = read_int(r);
+      pos.y = read_int(r);
+      break;
+    default: return 0;
+  }
+  if (type != MU_COMMAND_TEXT) {
+    rect.x = read_int(r); rect.y = read_int(r);
+    rect.w = read_int(r); rect.h = read_int(r);
+  }
+  if (type == MU_COMMAND_ICON) { cmd.icon.id = read_uint(r); }
+  if (type != MU_COMMAND_CLIP) {
+    if (r->end - r->p < 4) { return 0; }
+    memcpy(&color, r->p, 4);
+    r->p += 4;
+  }
+  cmd.type = type;
+  switch (type) {
+    case MU_COMMAND_CLIP: cmd.clip.rect = rect; break;
+    case MU_COMMAND_RECT: cmd.rect.rect = rect; cmd.rect.color = color; break;
+    case MU_COMMAND_ICON: cmd.icon.rect = rect; cmd.icon.color = color; break;
+    case MU_COMMAND_TEXT:
+      len = read_uint(r);
+      if (len < 0 || len > r->end - r->p) { return 0; }
+      cmd.text.font = font < MU_REMOTE_FONTS ? cli->fonts[font] : NULL;
+      cmd.text.pos = pos;
+      cmd.text.color = color;
+      cmd.text.str = (const char*) r->p;
+      cmd.text.len = len;
+      r->p += len;
+      break;
+  }
+  return r->ok && mu_inject_command(ctx, &cmd);
+}
+
+
+/**
+ * @brief 符号化したコマンドをコマンドリストに戻す（内部関数）
+ * @return int 成功したら1（失敗したらコマンドリストは空になる）
+ */
+static int decode_commands(mu_RemoteClient *cli, mu_Context *ctx, Reader *r) {
+  int ok = 1;
+  mu_clear_commands(ctx);
+  while (ok && r->p < r->end) { ok = decode_command(cli, ctx, r); }
+  mu_commit_commands(ctx);
+  if (!ok) { mu_clear_commands(ctx); }
+  return ok;
+}
+
+
+/**
+ * @brief 1フレームの展開（内部関数）
+ * 参照をキャッシュから展開し、コンテナの内容をキャッシュに覚えます。
+ * @return int 成功したら1
+ */
+static int decode_frame(mu_RemoteClient *cli, mu_Context *ctx, Reader *msg) {
+  Reader r, s;
+  unsigned size, hash, h = 2166136261u;
+  if (msg->end - msg->p < 8) { return 0; }
+  size = read_u32(msg->p);
+  hash = read_u32(msg->p + 4);
+  msg->p += 8;
+  if (size > (1u << 28) || !lz_decompress(msg, &cli->frame, (int) size)) { return 0; }
+
+  r.p = cli->frame.data;
+  r.end = cli->frame.data + cli->frame.size;
+  r.ok = 1;
+  cli->stream.size = 0;
+  while (r.p < r.end) {
+    unsigned key = read_uint(&r);
+    int kind, len;
+    mu_RemoteBuffer *c;
+    if (!r.ok || key >= MU_CONTAINERPOOL_SIZE || r.p >= r.end) { return 0; }
+    c = &cli->cache[key];
+    kind = *r.p++;
+    if (kind == SEGMENT_DATA) {
+      len = read_uint(&r);
+      if (!r.ok || len < 0 || len > r.end - r.p) { return 0; }
+      c->size = 0;
+      buffer_put(c, r.p, len);
+      if (c->size != len) { return 0; }
+      r.p += len;
+    } else if (kind != SEGMENT_REF) {
+      return 0;
+    }
+    h = hash_bytes(h, c->data, c->size);
+    buffer_put(&cli->stream, c->data, c->size);
+  }
+  if (h != hash) { return 0; }
+
+  s.p = cli->stream.data;
+  s.end = cli->stream.data + cli->stream.size;
+  s.ok = 1;
+  return decode_commands(cli, ctx, &s);
+}
+
+
+int mu_remote_receive(mu_RemoteClient *cli, mu_Context *ctx, int timeout_ms) {
+  int pos = 0, got = 0;
+  if (cli->sock == NO_SOCKET || cli->closed) { return 0; }
+  if (receive_available(cli->sock, &cli->recv, timeout_ms) < 0) { cli->closed = 1; }
+
+  while (cli->recv.size - pos >= 4) {
+    int n = (int) read_u32(cli->recv.data + pos);
+    Reader r;
+    if (n < 1 || n > (1 << 28)) { cli->closed = 1; break; }
+    if (cli->recv.size - pos - 4 < n) { break; }
+    r.p = cli->recv.data + pos + 5;
+    r.end = cli->recv.data + pos + 4 + n;
+    r.ok = 1;
+    pos += 4 + n;
+    if (r.p[-1] != MSG_FRAME) { continue; }
+    cli->frames++;
+    if (decode_frame(cli, ctx, &r)) {
+      got = 1;
+    } else {
+      /* 参照の展開がずれたままにならないよう、全てのコンテナを送り直してもらう */
+      cli->errors++;
+      if (!send_message(cli->sock, MSG_RESYNC, &cli->send, NULL, 0)) { cli->closed = 1; }
+    }
+  }
+  memmove(cli->recv.data, cli->recv.data + pos, cli->recv.size - pos);
+  cli->recv.size -= pos;
+  return got;
+}
+
+
+int mu_remote_send_input(mu_RemoteClient *cli, int type, int x, int y, int code, const char *text) {
+  mu_RemoteBuffer body;
+  int ok, len = text ? (int) strlen(text) + 1 : 0;
+  if (cli->sock == NO_SOCKET || cli->closed) { return 0; }
+  memset(&body, 0, sizeof(body));
+  buffer_uint(&body, type);
+  buffer_int(&body, x);
+  buffer_int(&body, y);
+  buffer_uint(&body, (unsigned) code);
+  buffer_uint(&body, len);
+  buffer_put(&body, text, len);
+  ok = send_message(cli->sock, MSG_INPUT, &cli->send, body.data, body.size);
+  buffer_free(&body);
+  if (!ok) { cli->closed = 1; }
+  return ok;
+}
+
+
+void mu_remote_disconnect(mu_RemoteClient *cli) {
+  int i;
+  if (cli->sock != NO_SOCKET) { close_socket(cli->sock); }
+  cli->sock = NO_SOCKET;
+  for (i = 0; i < MU_CONTAINERPOOL_SIZE; i++) { buffer_free(&cli->cache[i]); }
+  buffer_free(&cli->recv);
+  buffer_free(&cli->frame);
+  buffer_free(&cli->stream);
+  buffer_free(&cli->send);
+}
@@ -0,0 +1,174 @@
+/**
+ * リモート表示モジュール (microui用)
+ * 画面を持たないサーバープロセスでUIを動かし、コマンドリストをソケット
+ * （TCPまたはUnixドメイン）でクライアントへ送ります。クライアントは受け取った
+ * コマンドをコマンドリストへ戻すので、mu_next_commandを使う任意のバックエンドで
+ * 描画できます。入力はクライアントからサーバーへ送り返し、mu_input_*として適用します。
+ *
+ * 送信量を減らすための工夫:
+ * - コマンドはルートコンテナ（ウィンドウ）ごとに区切って可変長整数で符号化します。
+ * - 前のフレームと同じ内容のルートコンテナは、番号だけを送ります（参照）。
+ *   クライアントは受け取った内容をコンテナの番号ごとに覚えておき、参照を展開します。
+ * - フレーム全体を簡単なLZ77で圧縮して送ります。
+ * - 展開したフレームのハッシュを送り、クライアントで照合します。不一致（参照したコンテナの
+ *   内容がハッシュの衝突で古いままだった場合など）はerrorsに数え、RESYNCを送り返します。
+ *   サーバーはRESYNCを受け取ると、次のフレームで全てのコンテナを送り直します。
+ *
+ * メッセージ: 長さ(u32) 種類(u8) 本体
+ *   FRAME（サーバー→クライアント）: 展開後の長さ(u32) ハッシュ(u32) 圧縮データ
+ *   INPUT（クライアント→サーバー）: MU_EVENT_* x y code 文字列
+ *   RESYNC（クライアント→サーバー）: 本体なし。展開に失敗したので参照を使わずに送り直してほしい
+ *
+ * アドレスは "127.0.0.1:7000" のようなTCPか、"unix:/tmp/mu.sock" のような
+ * Unixドメインソケット（Windows以外）です。サーバーは同時に1つのクライアントを扱います。
+ * WindowsではWinsock（ws2_32.lib）をリンクしてください。
+ *
+ * 使い方（サーバー）:
+ *   mu_remote_listen(&srv, "127.0.0.1:7000");
+ *   for (;;) {
+ *     mu_remote_poll(&srv, ctx);          ... 接続の受け付けと入力の適用
+ *     mu_begin(ctx); ... mu_end(ctx);
+ *     mu_remote_send_frame(&srv, ctx);
+ *   }
+ *
+ * 使い方（クライアント）:
+ *   mu_remote_connect(&cli, "127.0.0.1:7000");
+ *   for (;;) {
+ *     mu_remote_send_input(&cli, MU_EVENT_MOUSEMOVE, x, y, 0, NULL);
+ *     if (mu_remote_receive(&cli, ctx, 16)) { ... mu_next_commandで描画 ... }
+ *   }
+ */
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <stddef.h>
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MU_REMOTE_FONTS 16     /* 番号に置き換えられるフォントの数 */
+
+#ifdef _WIN32
+  typedef size_t mu_Socket;    /* SOCKET（UINT_PTR） */
+#else
+  typedef int mu_Socket;
+#endif
+
+/* 伸長できるバイト列 */
+typedef struct {
+  unsigned char *data;
+  int size, capacity;
+} mu_RemoteBuffer;
+
+typedef struct {
+  mu_Socket listener, client;          /* 無ければ-1 */
+  unsigned hashes[MU_CONTAINERPOOL_SIZE];  /* クライアントに送ったコンテナの内容のハッシュ（0なら未送信） */
+  mu_Font fonts[MU_REMOTE_FONTS];
+  int font_count;
+  mu_RemoteBuffer frame, segment, packed, recv;
+  mu_CommandScratch scratch;           /* コマンドの展開先（MU_COMPACT_COMMANDS） */
+  /* 直近のフレームの統計 */
+  int raw_bytes;         /* 参照を展開したときの大きさ */
+  int sent_bytes;        /* 実際に送った大きさ */
+  int refs, segments;    /* 参照で送ったコンテナ数・全コンテナ数 */
+  int resyncs;           /* クライアントの求めで全てのコンテナを送り直した回数（累計） */
+} mu_RemoteServer;
+
+typedef struct {
+  mu_Socket sock;
+  mu_RemoteBuffer cache[MU_CONTAINERPOOL_SIZE];  /* コンテナの番号ごとの内容 */
+  mu_Font fonts[MU_REMOTE_FONTS];      /* 番号→フォント（既定はNULL） */
+  mu_RemoteBuffer recv, frame, stream, send;
+  int frames;            /* 受け取ったフレーム数 */
+  int errors;            /* 壊れていた・ハッシュが一致しなかったフレーム数 */
+  int closed;            /* サーバーが切断したら1 */
+} mu_RemoteClient;
+
+/**
+ * @brief サーバーの待ち受け開始
+ * 使い方: mu_remote_listen(&srv, "127.0.0.1:7000");
+ * @param srv サーバー
+ * @param address 待ち受けるアドレス
+ * @return int 成功したら1、失敗したら0
+ */
+int mu_remote_listen(mu_RemoteServer *srv, const char *address);
+
+/**
+ * @brief 接続の受け付けと入力の適用
+ * mu_beginの前に呼び出します。待たずに、届いている分だけ処理します。
+ * クライアントが切断したら、次のクライアントを受け付けられるように戻します。
+ * 使い方: mu_remote_poll(&srv, ctx);
+ * @param srv サーバー
+ * @param ctx MicroUIのコンテキスト
+ * @return int クライアントが接続していれば1
+ */
+int mu_remote_poll(mu_RemoteServer *srv, mu_Context *ctx);
+
+/**
+ * @brief フレームの送信
+ * mu_endの後に呼び出します。クライアントが無ければ何もしません。
+ * 使い方: mu_remote_send_frame(&srv, ctx);
+ * @param srv サーバー
+ * @param ctx MicroUIのコンテキスト
+ * @return int 送信したら1
+ */
+int mu_remote_send_frame(mu_RemoteServer *srv, mu_Context *ctx);
+
+/**
+ * @brief サーバーの終了
+ * 使い方: mu_remote_close_server(&srv);
+ * @param srv サーバー
+ * @return なし
+ */
+void mu_remote_close_server(mu_RemoteServer *srv);
+
+/**
+ * @brief サーバーへの接続
+ * 使い方: mu_remote_connect(&cli, "127.0.0.1:7000");
+ * @param cli クライアント
+ * @param address 接続先
+ * @return int 成功したら1、失敗したら0
+ */
+int mu_remote_connect(mu_RemoteClient *cli, const char *address);
+
+/**
+ * @brief フレームの受信
+ * 届いたフレームを順に展開し、最後のフレームをctx->command_listへ戻します。
+ * 戻したコマンドはJUMPを含まない並びで、mu_next_commandで走査できます。
+ * 使い方: if (mu_remote_receive(&cli, ctx, 16)) { ... }
+ * @param cli クライアント
+ * @param ctx コマンドリストの格納先（mu_beginとmu_endの間では呼ばない）
+ * @param timeout_ms フレームが無いときに待つ時間（ミリ秒）
+ * @return int 新しいフレームを戻したら1
+ */
+int mu_remote_receive(mu_RemoteClient *cli, mu_Context *ctx, int timeout_ms);
+
+/**
+ * @brief 入力の送信
+ * サーバー側で同じmu_input_*として適用されます。
+ * 使い方: mu_remote_send_input(&cli, MU_EVENT_MOUSEDOWN, x, y, MU_MOUSE_LEFT, NULL);
+ * @param cli クライアント
+ * @param type MU_EVENT_*
+ * @param x マウスX座標・スクロールX量
+ * @param y マウスY座標・スクロールY量
+ * @param code マウスボタン・キー・時刻（MU_EVENT_TIME）
+ * @param text 入力文字列（MU_EVENT_TEXTのみ）
+ * @return int 送信したら1
+ */
+int mu_remote_send_input(mu_RemoteClient *cli, int type, int x, int y, int code, const char *text);
+
+/**
+ * @brief 接続の終了
+ * 使い方: mu_remote_disconnect(&cli);
+ * @param cli クライアント
+ * @return なし
+ */
+void mu_remote_disconnect(mu_RemoteClient *cli);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
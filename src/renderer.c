@@ -4,6 +4,8 @@
 #include <stdbool.h>  // bool型用
 //#include <stdint.h>  // uint8_t用
 #include "renderer.h"
+#include "draw_list.h"
+#include "profile.h"
 
 #define USE_TTF_FONT 1// 1: TTF, 0: atlas.inl
 #if USE_TTF_FONT
@@ -46,10 +48,14 @@ int buf_on = TRUE;
 #define LAYOUT_HEIGHT 30
 #define MAX_INDICES (MAX_VERTICES * 3 / 2)
 
-static struct Vertex vertices[MAX_VERTICES];
-static short indices[MAX_INDICES];
-static int vertex_count = 0;
-static int index_count = 0;
+// 1フレーム分の頂点・インデックスとクリップ範囲（途中でフラッシュしない）
+static mu_DrawList draw_list;
+// D3Dバッファの現在の容量（要素数）とインデックス形式
+static int vb_capacity = 0;
+static int ib_capacity = 0;
+static D3DFORMAT ib_format = D3DFMT_INDEX16;
+// struct Vertexとmu_DrawVertexは同じ並びであること
+typedef char vertex_layout_check[sizeof(struct Vertex) == sizeof(mu_DrawVertex) ? 1 : -1];
 
 // デバイス設定関数
 void r_set_device(LPDIRECT3DDEVICE9 device)
@@ -187,6 +193,9 @@ static void r_cleanup_resources(void)
         g_index_buffer->lpVtbl->Release(g_index_buffer);
         g_index_buffer = NULL;
     }
+    vb_capacity = 0;
+    ib_capacity = 0;
+    mu_draw_list_free(&draw_list);
 
 #if USE_TTF_FONT
     if (g_font_texture) {
@@ -271,6 +280,16 @@ void r_init(LPDIRECT3DDEVICE9 device)
             r_cleanup_resources();
             return;
         }
+        vb_capacity = MAX_VERTICES;
+        ib_capacity = MAX_INDICES;
+        ib_format = D3DFMT_INDEX16;
+    }
+    mu_draw_list_init(&draw_list, MAX_VERTICES);
+    // 32ビットインデックスが使えないデバイスでは、広げずに65536頂点ごとに範囲を分ける
+    {
+        D3DCAPS9 caps;
+        if (SUCCEEDED(d3d_device->lpVtbl->GetDeviceCaps(d3d_device, &caps)) && caps.MaxVertexIndex < 0x7FFFFFFF)
+            draw_list.max_vertices = (int)caps.MaxVertexIndex + 1;
     }
 
     // レンダラーの初期化
@@ -291,20 +310,41 @@ static int update_vertex_buffer(void)
 {
     void* ptr;
     HRESULT hr;
+    int vertex_count = draw_list.vertex_count;
     if (!g_vertex_buffer)
     {
         return FALSE;
     }
 
+    // 前フレームより頂点が増えた場合はバッファを作り直す
+    if (vertex_count > vb_capacity)
+    {
+        g_vertex_buffer->lpVtbl->Release(g_vertex_buffer);
+        g_vertex_buffer = NULL;
+        vb_capacity = 0;
+        hr = d3d_device->lpVtbl->CreateVertexBuffer(d3d_device,
+            draw_list.vertex_capacity * sizeof(mu_DrawVertex),
+            D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY,
+            D3DFVF_XYZ | D3DFVF_TEX1 | D3DFVF_DIFFUSE,
+            D3DPOOL_DEFAULT,
+            &g_vertex_buffer,
+            NULL);
+        if (FAILED(hr))
+        {
+            return FALSE;
+        }
+        vb_capacity = draw_list.vertex_capacity;
+    }
+
     // 頂点バッファのロック
-    hr = g_vertex_buffer->lpVtbl->Lock(g_vertex_buffer, 0, vertex_count * sizeof(struct Vertex), &ptr, 0);
+    hr = g_vertex_buffer->lpVtbl->Lock(g_vertex_buffer, 0, vertex_count * sizeof(mu_DrawVertex), &ptr, D3DLOCK_DISCARD);
     if (FAILED(hr))
     {
         return FALSE;
     }
 
     // 頂点データのコピー
-    memcpy(ptr, vertices, vertex_count * sizeof(struct Vertex));
+    memcpy(ptr, draw_list.vertices, vertex_count * sizeof(mu_DrawVertex));
     g_vertex_buffer->lpVtbl->Unlock(g_vertex_buffer);
 
     return TRUE;
@@ -313,64 +353,101 @@ static int update_index_buffer(void)
 {
     void* ptr;
     HRESULT hr;
+    int index_count = draw_list.index_count;
+    D3DFORMAT format = (draw_list.index_size == 4) ? D3DFMT_INDEX32 : D3DFMT_INDEX16;
     if (!g_index_buffer)
     {
         return FALSE;
     }
 
+    // 容量不足、または16/32ビットが切り替わった場合はバッファを作り直す
+    if (index_count > ib_capacity || format != ib_format)
+    {
+        g_index_buffer->lpVtbl->Release(g_index_buffer);
+        g_index_buffer = NULL;
+        ib_capacity = 0;
+        hr = d3d_device->lpVtbl->CreateIndexBuffer(d3d_device,
+            draw_list.index_capacity * draw_list.index_size,
+            D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY,
+            format,
+            D3DPOOL_DEFAULT,
+            &g_index_buffer,
+            NULL);
+        if (FAILED(hr))
+        {
+            return FALSE;
+        }
+        ib_capacity = draw_list.index_capacity;
+        ib_format = format;
+    }
+
     // インデックスバッファのロック
-    hr = g_index_buffer->lpVtbl->Lock(g_index_buffer, 0, index_count * sizeof(short), &ptr, D3DLOCK_DISCARD);
+    hr = g_index_buffer->lpVtbl->Lock(g_index_buffer, 0, index_count * draw_list.index_size, &ptr, D3DLOCK_DISCARD);
     if (FAILED(hr))
     {
         return FALSE;
     }
     // インデックスデータのコピー
-    memcpy(ptr, indices, index_count * sizeof(short));
+    memcpy(ptr, draw_list.indices, index_count * draw_list.index_size);
     g_index_buffer->lpVtbl->Unlock(g_index_buffer);
 
     return TRUE;
 }
+
+// 記録したクリップ矩形をシザー矩形として設定（画面外は切り詰める）
+static void set_scissor(mu_Rect rect)
+{
+    RECT scissor_rect;
+    scissor_rect.left = mu_max(rect.x, 0);
+    scissor_rect.top = mu_max(rect.y, 0);
+    scissor_rect.right = mu_min(rect.x + rect.w, width);
+    scissor_rect.bottom = mu_min(rect.y + rect.h, height);
+    d3d_device->lpVtbl->SetRenderState(d3d_device, D3DRS_SCISSORTESTENABLE, TRUE);
+    d3d_device->lpVtbl->SetScissorRect(d3d_device, &scissor_rect);
+}
+
 static void flush(void)
 {
-    if (vertex_count == 0) { return; }
-    
+    int i;
+    int vertex_count = draw_list.vertex_count;
+    D3DFORMAT format = (draw_list.index_size == 4) ? D3DFMT_INDEX32 : D3DFMT_INDEX16;
 #if USE_TTF_FONT
-    // TTFフォント使用時: フォントテクスチャを使用（白い部分も含む）
-    if (!g_font_texture) { 
-        return; 
-    }
-    if (buf_on && (!update_vertex_buffer() || !update_index_buffer())) { return; }
-    
-    // フォントテクスチャを使用（UI要素とテキスト両方）
-    d3d_device->lpVtbl->SetTexture(d3d_device, 0, (IDirect3DBaseTexture9*)g_font_texture);
-    if (buf_on)
-        d3d_device->lpVtbl->SetStreamSource(d3d_device, 0, g_vertex_buffer, 0, sizeof(struct Vertex));
-    if (buf_on)
-        d3d_device->lpVtbl->SetIndices(d3d_device, g_index_buffer);
-    d3d_device->lpVtbl->SetFVF(d3d_device, D3DFVF_XYZ | D3DFVF_TEX1 | D3DFVF_DIFFUSE);
-    if (buf_on)
-        d3d_device->lpVtbl->DrawIndexedPrimitive(d3d_device, D3DPT_TRIANGLELIST, 0, 0, vertex_count, 0, index_count / 3);
-    else
-        d3d_device->lpVtbl->DrawIndexedPrimitiveUP(d3d_device, D3DPT_TRIANGLELIST, 0, vertex_count, index_count / 3, indices, D3DFMT_INDEX16, vertices, sizeof(struct Vertex));
-    vertex_count = 0;
-    index_count = 0;
-
+    // TTFフォント使用時: フォントテクスチャを使用（UI要素とテキスト両方）
+    IDirect3DTexture9* texture = g_font_texture;
 #else
-    if (!atlas_texture_d3d) { return; }
+    IDirect3DTexture9* texture = atlas_texture_d3d;
+#endif
+    if (vertex_count == 0) { return; }
+    if (!texture) { return; }
     if (buf_on && (!update_vertex_buffer() || !update_index_buffer())) { return; }
-    d3d_device->lpVtbl->SetTexture(d3d_device, 0, (IDirect3DBaseTexture9*)atlas_texture_d3d);
+
+    d3d_device->lpVtbl->SetTexture(d3d_device, 0, (IDirect3DBaseTexture9*)texture);
     if (buf_on)
-        d3d_device->lpVtbl->SetStreamSource(d3d_device, 0, g_vertex_buffer, 0, sizeof(struct Vertex));
+        d3d_device->lpVtbl->SetStreamSource(d3d_device, 0, g_vertex_buffer, 0, sizeof(mu_DrawVertex));
     if (buf_on)
         d3d_device->lpVtbl->SetIndices(d3d_device, g_index_buffer);
     d3d_device->lpVtbl->SetFVF(d3d_device, D3DFVF_XYZ | D3DFVF_TEX1 | D3DFVF_DIFFUSE);
-    if (buf_on)
-        d3d_device->lpVtbl->DrawIndexedPrimitive(d3d_device, D3DPT_TRIANGLELIST, 0, 0, vertex_count, 0, index_count / 3);
-    else
-        d3d_device->lpVtbl->DrawIndexedPrimitiveUP(d3d_device, D3DPT_TRIANGLELIST, 0, vertex_count, index_count / 3, indices, D3DFMT_INDEX16, vertices, sizeof(struct Vertex));
-    vertex_count = 0;
-    index_count = 0;
-#endif
+
+    // フレーム統計（コアの統計にバックエンドの分を加算）
+    g_ctx->stats.flushes++;
+    g_ctx->stats.vertices += vertex_count;
+    g_ctx->stats.draw_calls += draw_list.range_count;
+
+    // クリップ矩形ごとの範囲を順番に描画
+    for (i = 0; i < draw_list.range_count; i++)
+    {
+        mu_DrawRange* range = &draw_list.ranges[i];
+        // インデックスは範囲の先頭頂点からの相対値
+        int span = vertex_count - range->base_vertex;
+        if (draw_list.max_vertices > 0)
+            span = mu_min(span, draw_list.max_vertices);
+        set_scissor(range->clip);
+        if (buf_on)
+            d3d_device->lpVtbl->DrawIndexedPrimitive(d3d_device, D3DPT_TRIANGLELIST, range->base_vertex, 0, span, range->index_offset, range->index_count / 3);
+        else
+            d3d_device->lpVtbl->DrawIndexedPrimitiveUP(d3d_device, D3DPT_TRIANGLELIST, 0, span, range->index_count / 3,
+                (char*)draw_list.indices + range->index_offset * draw_list.index_size, format, draw_list.vertices + range->base_vertex, sizeof(mu_DrawVertex));
+    }
 }
 
 void draw_win()
@@ -380,12 +457,16 @@ void draw_win()
 
     // シーンの開始
     d3d_device->lpVtbl->BeginScene(d3d_device);
+    // 描画（範囲ごとにシザー矩形を設定する）
+    if (g_ctx->trace) { g_ctx->trace(g_ctx->trace_udata, "flush", 1); }
+    mu_profile_begin("flush");
+    flush();
+    mu_profile_end();
+    if (g_ctx->trace) { g_ctx->trace(g_ctx->trace_udata, NULL, 0); }
+
     // シザー矩形の無効化
     d3d_device->lpVtbl->SetRenderState(d3d_device, D3DRS_SCISSORTESTENABLE, FALSE);
 
-    // 描画
-    flush();
-
     // シーンの終了
     d3d_device->lpVtbl->EndScene(d3d_device);
     d3d_device->lpVtbl->Present(d3d_device, NULL, NULL, NULL, NULL);
@@ -395,30 +476,23 @@ void r_draw()
 {
     // コマンド処理
     mu_Command* cmd = NULL;
-    static int frame_count = 0;
-    int command_count = 0;
-    int text_count = 0;
-    int rect_count = 0;
 
-    frame_count++;
     process_frame(g_ctx);
 
+    mu_draw_list_begin(&draw_list);
     while (mu_next_command(g_ctx, &cmd))
     {
-        command_count++;
         switch (cmd->type)
         {
         case MU_COMMAND_CLIP:
             r_set_clip_rect(cmd->clip.rect);
             break;
         case MU_COMMAND_RECT:
-            rect_count++;
             r_draw_rect(cmd->rect.rect, cmd->rect.color);
             break;
         case MU_COMMAND_TEXT:
         {
             mu_Vec2 text_rect = { cmd->text.pos.x, cmd->text.pos.y };
-            text_count++;
             r_draw_text(cmd->text.str, text_rect, cmd->text.color);
         }
         break;
@@ -427,6 +501,7 @@ void r_draw()
             break;
         }
     }
+    mu_draw_list_end(&draw_list);
 
     draw_win();
 }
@@ -625,27 +700,12 @@ int r_get_text_width(const char* text, int len)
 * クリッピング領域の設定
 * @param rect - クリッピング領域の矩形情報（x,y,w,h）
 *
-* 処理フロー:
-* 1. デバイスの有効性チェック
-* 2. ビューポートの設定
-* 3. シザー矩形の設定
+* 以降の四角形に使うクリップ矩形を描画リストに記録します。
 */
 void r_set_clip_rect(mu_Rect rect)
 {
-    // シザー矩形の設定
-    RECT scissor_rect = {
-        rect.x,             // 左端
-        rect.y,             // 上端
-        rect.x + rect.w,    // 右端
-        rect.y + rect.h     // 下端
-    };
-    // デバイスの有効性チェック
-    if (!r_validate_device()) return;
-
-
-    // シザー矩形の設定
-    d3d_device->lpVtbl->SetRenderState(d3d_device, D3DRS_SCISSORTESTENABLE, TRUE);
-    d3d_device->lpVtbl->SetScissorRect(d3d_device, &scissor_rect);
+    // シザー矩形はflush時に範囲ごとに設定するので、ここでは記録だけ行う
+    mu_draw_list_set_clip(&draw_list, rect);
 }
 
 /*
@@ -834,7 +894,6 @@ static void push_quad(mu_Rect dst, mu_Rect src, mu_Color color)
     float x, y, w, h;
     DWORD vertex_color = D3DCOLOR_RGBA(color.r, color.g, color.b, color.a);
     if (!r_validate_device()) return;
-    if (vertex_count >= MAX_VERTICES - 4 || index_count >= MAX_INDICES - 6) { flush(); }
     #if USE_TTF_FONT
     if (g_font_atlas.width > 0 && g_font_atlas.height > 0) {
         x = (float)src.x / (float)g_font_atlas.width;
@@ -853,36 +912,5 @@ static void push_quad(mu_Rect dst, mu_Rect src, mu_Color color)
     w = (float)src.w / ATLAS_WIDTH;
     h = (float)src.h / ATLAS_HEIGHT;
     #endif
-    vertices[vertex_count + 0].x = dst.x;
-    vertices[vertex_count + 0].y = dst.y;
-    vertices[vertex_count + 0].z = 0.5f;
-    vertices[vertex_count + 0].color = vertex_color;
-    vertices[vertex_count + 0].u = x;
-    vertices[vertex_count + 0].v = y;
-    vertices[vertex_count + 1].x = dst.x + dst.w;
-    vertices[vertex_count + 1].y = dst.y;
-    vertices[vertex_count + 1].z = 0.5f;
-    vertices[vertex_count + 1].color = vertex_color;
-    vertices[vertex_count + 1].u = x + w;
-    vertices[vertex_count + 1].v = y;
-    vertices[vertex_count + 2].x = dst.x;
-    vertices[vertex_count + 2].y = dst.y + dst.h;
-    vertices[vertex_count + 2].z = 0.5f;
-    vertices[vertex_count + 2].color = vertex_color;
-    vertices[vertex_count + 2].u = x;
-    vertices[vertex_count + 2].v = y + h;
-    vertices[vertex_count + 3].x = dst.x + dst.w;
-    vertices[vertex_count + 3].y = dst.y + dst.h;
-    vertices[vertex_count + 3].z = 0.5f;
-    vertices[vertex_count + 3].color = vertex_color;
-    vertices[vertex_count + 3].u = x + w;
-    vertices[vertex_count + 3].v = y + h;
-    indices[index_count + 0] = vertex_count + 0;
-    indices[index_count + 1] = vertex_count + 1;
-    indices[index_count + 2] = vertex_count + 2;
-    indices[index_count + 3] = vertex_count + 2;
-    indices[index_count + 4] = vertex_count + 1;
-    indices[index_count + 5] = vertex_count + 3;
-    vertex_count += 4;
-    index_count += 6;
+    mu_draw_list_quad(&draw_list, dst, x, y, x + w, y + h, vertex_color);
 }
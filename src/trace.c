@@ -0,0 +1,159 @@
+﻿/**
+ * トレース出力モジュール (microui用)
+ * 詳細はtrace.hを参照してください。
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include <string.h>
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+/**
+ * @brief 現在時刻（内部関数）
+ * @return double 単調増加する時刻（秒）
+ */
+static double trace_now(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if (!freq.QuadPart) { QueryPerformanceFrequency(&freq); }
+  QueryPerformanceCounter(&t);
+  return (double) t.QuadPart / (double) freq.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+
+/**
+ * @brief バッファへの書き込み（内部関数）
+ * バッファが一杯になったらファイルに書き出してから追加します。
+ * @param tr トレース
+ * @param str 書き込む文字列
+ * @param len 長さ（MU_TRACE_BUFSIZE以下）
+ * @return なし
+ */
+static void write_out(mu_Trace *tr, const char *str, int len) {
+  if (tr->buf_len + len > MU_TRACE_BUFSIZE) {
+    fwrite(tr->buf, 1, tr->buf_len, tr->fp);
+    tr->buf_len = 0;
+  }
+  memcpy(tr->buf + tr->buf_len, str, len);
+  tr->buf_len += len;
+}
+
+
+/**
+ * @brief 1イベントをJSONで書き込む（内部関数）
+ * 名前の '"' と '\' と制御文字はエスケープします。
+ * @param tr トレース
+ * @param name 名前（NULLなら名前なし）
+ * @param ph フェーズ（"B" "E" "i"）
+ * @param ts 時刻（マイクロ秒）
+ * @return なし
+ */
+static void write_event(mu_Trace *tr, const char *name, const char *ph, double ts) {
+  char line[64 + MU_TRACE_NAMESIZE * 6];
+  char *p = line;
+  p += sprintf(p, "%s{", tr->written ? ",\n" : "");
+  if (name) {
+    p += sprintf(p, "\"name\":\"");
+    for (; *name; name++) {
+      unsigned char c = (unsigned char) *name;
+      if (c == '"' || c == '\\') { *p++ = '\\'; *p++ = c; }
+      else if (c < 0x20) { p += sprintf(p, "\\u%04x", c); }
+      else { *p++ = c; }
+    }
+    p += sprintf(p, "\",");
+  }
+  p += sprintf(p, "\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":1%s}",
+    ph, ts, ph[0] == 'i' ? ",\"s\":\"t\"" : "");
+  write_out(tr, line, (int) (p - line));
+  tr->written++;
+}
+
+
+/**
+ * @brief 溜めたフレームの判定と書き出し（内部関数）
+ * @param tr トレース
+ * @param now 現在時刻（マイクロ秒）
+ * @return なし
+ */
+static void finish_frame(mu_Trace *tr, double now) {
+  int i;
+  if (tr->event_count > 0 && tr->frames_left != 0 &&
+      now - tr->frame_start >= tr->slow_us)
+  {
+    for (i = 0; i < tr->event_count; i++) {
+      const mu_TraceEvent *e = &tr->events[i];
+      write_event(tr, e->begin ? e->name : NULL, e->begin ? "B" : "E", e->ts);
+    }
+    if (tr->dropped) {
+      char name[MU_TRACE_NAMESIZE];
+      sprintf(name, "dropped %d events", tr->dropped);
+      write_event(tr, name, "i", tr->events[tr->event_count - 1].ts);
+    }
+    if (tr->frames_left > 0) { tr->frames_left--; }
+  }
+  tr->event_count = 0;
+  tr->dropped = 0;
+  tr->frame_start = now;
+}
+
+
+int mu_trace_open(mu_Trace *tr, const char *path, int frames, double slow_ms) {
+  memset(tr, 0, sizeof(*tr));
+  tr->fp = fopen(path, "wb");
+  if (!tr->fp) { return 0; }
+  tr->origin = trace_now();
+  tr->frames_left = frames > 0 ? frames : -1;
+  tr->slow_us = slow_ms > 0 ? slow_ms * 1000.0 : 0;
+  write_out(tr, "[\n", 2);
+  return 1;
+}
+
+
+void mu_trace_close(mu_Trace *tr) {
+  if (!tr->fp) { return; }
+  finish_frame(tr, (trace_now() - tr->origin) * 1e6);
+  write_out(tr, "\n]\n", 3);
+  fwrite(tr->buf, 1, tr->buf_len, tr->fp);
+  fclose(tr->fp);
+  tr->fp = NULL;
+  tr->buf_len = 0;
+}
+
+
+void mu_trace_attach(mu_Context *ctx, mu_Trace *tr) {
+  ctx->trace = tr ? mu_trace_event : NULL;
+  ctx->trace_udata = tr;
+}
+
+
+void mu_trace_event(void *udata, const char *name, int begin) {
+  mu_Trace *tr = (mu_Trace*) udata;
+  mu_TraceEvent *e;
+  double now;
+  if (!tr->fp || tr->frames_left == 0) { return; }
+  now = (trace_now() - tr->origin) * 1e6;
+  /* "frame"の開始で前のフレームを締める */
+  if (begin && name && strcmp(name, "frame") == 0) { finish_frame(tr, now); }
+  if (tr->event_count == MU_TRACE_EVENTS) { tr->dropped++; return; }
+  e = &tr->events[tr->event_count++];
+  e->name[0] = '\0';
+  if (begin && name) {
+    strncpy(e->name, name, MU_TRACE_NAMESIZE - 1);
+    e->name[MU_TRACE_NAMESIZE - 1] = '\0';
+  }
+  e->ts = now;
+  e->begin = begin;
+}
@@ -0,0 +1,112 @@
+/**
+ * トレース出力モジュール (microui用)
+ * microuiのフレームの時間経過を、Chromeのトレースイベント形式（JSON）で
+ * ファイルに書き出します。chrome://tracing や Perfetto で開けば、
+ * アプリの他のトレースと同じビューアで確認できます。
+ *
+ * コアはctx->traceフックを、mu_begin〜mu_end（"frame"）、mu_endの処理（"mu_end"）、
+ * ウィンドウのbegin〜end（ウィンドウのタイトル）で呼び出します。
+ * renderer.cはフラッシュ（"flush"）で呼び出します。
+ * フックがNULLなら何もしないので、未使用時のコストは分岐1回です。
+ *
+ * - イベントは1フレーム分だけmu_Trace内に溜め、次のフレームの開始時に
+ *   書き出すかどうかを決めます（遅いフレームだけを書き出せるように）。
+ * - ファイルへはMU_TRACE_BUFSIZEの固定バッファを通して書くので、
+ *   記録が長くなってもメモリは増えません。
+ * - 1フレームのイベントがMU_TRACE_EVENTSを超えた分は捨て、数だけ記録します。
+ *
+ * 使い方:
+ *   static mu_Trace trace;
+ *   mu_trace_open(&trace, "ui_trace.json", 300, 0);    ... 300フレーム分を書き出す
+ *   mu_trace_open(&trace, "ui_slow.json", 20, 16.7);   ... 16.7msより遅いフレームを20個まで
+ *   mu_trace_attach(ctx, &trace);
+ *   ... フレームループ ...
+ *   mu_trace_close(&trace);
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include "microui.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MU_TRACE_EVENTS
+#define MU_TRACE_EVENTS  4096   /* 1フレームに溜められるイベント数 */
+#endif
+#ifndef MU_TRACE_BUFSIZE
+#define MU_TRACE_BUFSIZE 65536  /* 書き込みバッファのバイト数 */
+#endif
+#define MU_TRACE_NAMESIZE 32    /* イベント名の最大長（終端を含む） */
+
+/* 1フレーム分に溜めるイベント */
+typedef struct {
+  char name[MU_TRACE_NAMESIZE]; /* ウィンドウのタイトルは書き換えられることがあるのでコピーする */
+  double ts;                    /* 記録開始からの時刻（マイクロ秒） */
+  int begin;                    /* 1なら開始（"B"）、0なら終了（"E"） */
+} mu_TraceEvent;
+
+typedef struct {
+  FILE *fp;
+  char buf[MU_TRACE_BUFSIZE];
+  int buf_len;
+  mu_TraceEvent events[MU_TRACE_EVENTS];
+  int event_count;
+  int dropped;           /* 今フレームで捨てたイベント数 */
+  double origin;         /* mu_trace_openの時刻（秒） */
+  double frame_start;    /* 今フレームの開始時刻（マイクロ秒） */
+  int frames_left;       /* 書き出せるフレーム数の残り（-1なら無制限） */
+  double slow_us;        /* 0より大きければ、これより遅いフレームだけ書き出す */
+  int written;           /* 書き出したイベント数 */
+} mu_Trace;
+
+/**
+ * @brief トレースファイルを開く
+ * ファイルを作成し、JSON配列の先頭を書き込みます。
+ * 使い方: mu_trace_open(&trace, "ui_trace.json", 300, 0);
+ * @param tr トレース
+ * @param path 出力ファイル名
+ * @param frames 書き出すフレーム数（0なら閉じるまで全て）
+ * @param slow_ms 0より大きければ、これより時間のかかったフレームだけ書き出す（ミリ秒）
+ * @return int 成功したら1、ファイルを作成できなければ0
+ */
+int mu_trace_open(mu_Trace *tr, const char *path, int frames, double slow_ms);
+
+/**
+ * @brief トレースファイルを閉じる
+ * 溜めている最後のフレームを判定して書き出し、JSON配列を閉じます。
+ * 使い方: mu_trace_close(&trace);
+ * @param tr トレース
+ * @return なし
+ */
+void mu_trace_close(mu_Trace *tr);
+
+/**
+ * @brief コンテキストにトレースを接続
+ * ctx->traceとctx->trace_udataを設定します。trにNULLを渡すと切り離します。
+ * 使い方: mu_trace_attach(ctx, &trace);
+ * @param ctx MicroUIのコンテキスト
+ * @param tr トレース
+ * @return なし
+ */
+void mu_trace_attach(mu_Context *ctx, mu_Trace *tr);
+
+/**
+ * @brief イベントの記録（ctx->traceフック）
+ * 区間の開始・終了を記録します。"frame"の開始でフレームを区切ります。
+ * バックエンドからは if (ctx->trace) ctx->trace(ctx->trace_udata, "flush", 1); のように呼びます。
+ * 使い方: mu_trace_event(&trace, "flush", 1);
+ * @param udata トレース（mu_Trace*）
+ * @param name 区間名（終了ではNULLでもよい）
+ * @param begin 開始なら1、終了なら0
+ * @return なし
+ */
+void mu_trace_event(void *udata, const char *name, int begin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,6 +5,10 @@
 #include "renderer.h"
 #include "microui.h"
 #include "ttf_font.h"
+#include "profile.h"
+#include "trace.h"
+#include "input_record.h"
+#include "command_capture.h"
 //#include "japanese_atlas.inl"
 //#include <stdint.h>  // uint8_tp
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -13,6 +17,19 @@ int width = 1200;
 int height = 800;
 
 mu_Context* g_ctx = NULL;
+#ifdef MU_PROFILE
+static mu_ProfileBuffer g_prof;  // UIXbh̃vt@CL^
+static mu_ProfileView g_prof_view;  // vt@CEBhE̕\
+#endif
+#ifdef MU_TRACE
+static mu_Trace g_trace;  // xt[̃g[Xo͐
+#endif
+#ifdef MU_RECORD
+static mu_Recorder g_rec;  // ͂̋L^ibench/microui_benchƓ`j
+#endif
+#ifdef MU_CAPTURE
+static mu_CaptureWriter g_capture;  // R}hXg̕ۑibench/command_replayŌvj
+#endif
 static  char logbuf[64000];
 static   int logbuf_updated = 0;
 static float bg[4] = { 90, 95, 100,105 };
@@ -294,8 +311,21 @@ void process_frame(mu_Context* ctx)
      
      // ɋ̃EBhE\
     empty_window(ctx);
+#ifdef MU_PROFILE
+    {
+        mu_ProfileBuffer* buffers[1] = { &g_prof };
+        mu_profile_window(ctx, "Profiler", &g_prof_view, buffers, 1);
+    }
+#endif
      
      mu_end(ctx);
+#ifdef MU_RECORD
+    mu_record_frame(&g_rec, ctx);
+#endif
+#ifdef MU_CAPTURE
+    // ŏ300t[ۑ
+    if (g_capture.frames < 300) { mu_capture_frame(&g_capture, ctx); }
+#endif
 }
  static void log_window(mu_Context* ctx)
  {
@@ -360,6 +390,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 	{
 		return DefWindowProc(hwnd, uMsg, wParam, lParam);
 	}
+	/* ̓CxgɃbZ[W̔t */
+	mu_input_time(g_ctx, GetMessageTime());
 
 	switch (uMsg)
 	{
@@ -478,6 +510,22 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 
 	memset(g_ctx, 0, sizeof(mu_Context));
 	mu_init(g_ctx);
+#ifdef MU_PROFILE
+	mu_profile_thread(&g_prof, "UI");
+#endif
+#ifdef MU_TRACE
+	// 33msxt[50܂Chromẽg[X`ŏo
+	if (mu_trace_open(&g_trace, "microui_trace.json", 50, 33.0))
+	{
+		mu_trace_attach(g_ctx, &g_trace);
+	}
+#endif
+#ifdef MU_RECORD
+	mu_record_open(&g_rec, g_ctx, "microui_input.rec");
+#endif
+#ifdef MU_CAPTURE
+	mu_capture_open(&g_capture, "microui_frames.mucc");
+#endif
 
 	g_ctx->text_width = text_width;
 	g_ctx->text_height = text_height;
@@ -539,6 +587,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 	}
 
 	// N[Abv
+#ifdef MU_TRACE
+	mu_trace_close(&g_trace);
+#endif
+#ifdef MU_RECORD
+	mu_record_close(&g_rec, g_ctx);
+#endif
+#ifdef MU_CAPTURE
+	mu_capture_close(&g_capture);
+#endif
 	r_cleanup();
 	CleanD3D();
 	free(g_ctx);